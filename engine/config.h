@@ -1,5 +1,6 @@
 #pragma once
 #include <engine/types.h>
+#include <array>
 
 namespace lotus
 {
@@ -8,9 +9,68 @@ namespace lotus
     public:
         struct Renderer
         {
+            enum class QualityPreset
+            {
+                Low,
+                Medium,
+                High,
+                Ultra
+            };
+
+            //CPU transcoding of uncompressed textures to BCn: Fast trades some quality for load time, None keeps them as RGBA8
+            enum class TextureCompression
+            {
+                None,
+                Fast,
+                High
+            };
+
+            //projected sizes are fractions of the screen height (bounding sphere radius / view half-height)
+            struct DetailCulling
+            {
+                float cull_size;
+                float fade_size;
+            };
+
             uint32_t screen_width = 1900;
             uint32_t screen_height = 1000;
             uint32_t borderless = 0;
+            QualityPreset quality = QualityPreset::High;
+            TextureCompression texture_compression = TextureCompression::High;
+            //textures keep their mips up to texture_streaming_min_dimension resident, and stream the rest in while visible
+            bool texture_streaming = true;
+            uint32_t texture_streaming_min_dimension = 64;
+            //MB of texture memory the streamer keeps resident before evicting
+            uint32_t texture_budget = 1536;
+            //MB of the persistent staging ring all uploads go through
+            uint32_t staging_buffer_size = 64;
+            //MB of streaming uploads copied per frame (loads that something is waiting on always go out in the frame they're made)
+            uint32_t upload_budget = 32;
+            //copy uploads on a transfer-only queue when the device has one
+            bool async_uploads = true;
+            //MB of throwaway buffer uploads made every frame, to compare the logged frame times with async_uploads on and off
+            //  under load (0 for none)
+            uint32_t synthetic_upload_load = 0;
+            //seconds between memory usage log lines (0 for none)
+            uint32_t memory_log_interval = 30;
+            //MB of models and textures that nothing uses any more kept loaded, so going back to a zone doesn't load them again
+            uint32_t model_cache_budget = 256;
+            uint32_t texture_cache_budget = 256;
+            //how far (radians, model space units for translation) a compressed animation may drift from its source frames
+            //  when dropping keys that interpolating their neighbours gets close enough to (0 for all three keeps every frame)
+            float animation_rotation_tolerance = 0.002f;
+            float animation_translation_tolerance = 0.002f;
+            float animation_scale_tolerance = 0.002f;
+
+            std::array<DetailCulling, 4> detail_culling
+            {{
+                { 0.02f, 0.04f },
+                { 0.01f, 0.02f },
+                { 0.005f, 0.01f },
+                { 0.f, 0.f }
+            }};
+
+            const DetailCulling& getDetailCulling() const { return detail_culling[static_cast<size_t>(quality)]; }
         } renderer {};
     };
 }
@@ -34,13 +34,13 @@ namespace lotus
         camera_rot.z = cos(rot_x) * sin(rot_y);
         camera_rot = glm::normalize(camera_rot);
 
-        view_proj_ubo = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(CameraData)) * engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-        view_proj_mapped = static_cast<uint8_t*>(view_proj_ubo->map(0, engine->renderer.uniform_buffer_align_up(sizeof(CameraData)) * engine->renderer.getImageCount(), {}));
+        view_proj_ubo = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(CameraData)) * engine->renderer.getFrameCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+        view_proj_mapped = static_cast<uint8_t*>(view_proj_ubo->map(0, engine->renderer.uniform_buffer_align_up(sizeof(CameraData)) * engine->renderer.getFrameCount(), {}));
 
         if (engine->renderer.render_mode == RenderMode::Rasterization)
         {
-            cascade_data_ubo = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(cascade_data)) * engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-            cascade_data_mapped = static_cast<uint8_t*>(cascade_data_ubo->map(0, engine->renderer.uniform_buffer_align_up(sizeof(cascade_data)) * engine->renderer.getImageCount(), {}));
+            cascade_data_ubo = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(cascade_data)) * engine->renderer.getFrameCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+            cascade_data_mapped = static_cast<uint8_t*>(cascade_data_ubo->map(0, engine->renderer.uniform_buffer_align_up(sizeof(cascade_data)) * engine->renderer.getFrameCount(), {}));
         }
         update = true;
     }
@@ -49,6 +49,7 @@ namespace lotus
     {
         near_clip = _near_clip;
         far_clip = _far_clip;
+        fov = radians;
         camera_data.proj = glm::perspective(radians, aspect, near_clip, far_clip);
         camera_data.proj[1][1] *= -1;
         camera_data.proj_inverse = glm::inverse(camera_data.proj);
@@ -81,6 +82,34 @@ namespace lotus
         update = true;
     }
 
+    Camera::Frustum Camera::Frustum::fromViewProj(const glm::mat4& view_proj)
+    {
+        auto normalize = [](glm::vec4 plane)
+        {
+            return plane / glm::length(glm::vec3(plane));
+        };
+
+        Frustum frustum;
+        frustum.left = normalize(glm::row(view_proj, 3) + glm::row(view_proj, 0));
+        frustum.right = normalize(glm::row(view_proj, 3) - glm::row(view_proj, 0));
+        frustum.top = normalize(glm::row(view_proj, 3) - glm::row(view_proj, 1));
+        frustum.bottom = normalize(glm::row(view_proj, 3) + glm::row(view_proj, 1));
+        //-w..w near plane is looser than the 0..w one vulkan clips to, so this errs towards keeping casters
+        frustum.near = normalize(glm::row(view_proj, 3) + glm::row(view_proj, 2));
+        frustum.far = normalize(glm::row(view_proj, 3) - glm::row(view_proj, 2));
+        return frustum;
+    }
+
+    bool Camera::Frustum::intersects(const BoundingSphere& sphere) const
+    {
+        for (const auto& plane : { left, right, top, bottom, near, far })
+        {
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+                return false;
+        }
+        return true;
+    }
+
     void Camera::look(float rot_x_offset, float rot_y_offset)
     {
         rot_y += rot_y_offset;
@@ -155,7 +184,93 @@ namespace lotus
             normal = glm::normalize(glm::cross(Y, aux));
             point = -glm::dot(normal, nc + X * nw);
             frustum.right.x = normal.x; frustum.right.y = normal.y; frustum.right.z = normal.z; frustum.right.w = point;
+
+            //computed here rather than in render so shadow casters can be culled against the cascades
+            if (engine->renderer.render_mode == RenderMode::Rasterization)
+                updateCascades();
+        }
+    }
+
+    void Camera::updateCascades()
+    {
+        glm::vec3 lightDir = engine->lights.light.diffuse_dir;
+        float cascade_splits[lotus::Renderer::shadowmap_cascades];
+
+        float near_clip = this->getNearClip();
+        float far_clip = this->getFarClip();
+        float range = far_clip - near_clip;
+        float ratio = far_clip / near_clip;
+
+        for (size_t i = 0; i < lotus::Renderer::shadowmap_cascades; ++i)
+        {
+            float p = (i + 1) / static_cast<float>(lotus::Renderer::shadowmap_cascades);
+            float log = near_clip * std::pow(ratio, p);
+            float uniform = near_clip + range * p;
+            float d = 0.95f * (log - uniform) + uniform;
+            cascade_splits[i] = (d - near_clip) / range;
+        }
+
+        float last_split = 0.0f;
+
+        for (uint32_t i = 0; i < lotus::Renderer::shadowmap_cascades; ++i)
+        {
+            float split_dist = cascade_splits[i];
+            std::array<glm::vec3, 8> frustum_corners = {
+                glm::vec3{-1.f, 1.f, -1.f},
+                glm::vec3{1.f, 1.f, -1.f},
+                glm::vec3{1.f, -1.f, -1.f},
+                glm::vec3{-1.f, -1.f, -1.f},
+                glm::vec3{-1.f, 1.f, 1.f},
+                glm::vec3{1.f, 1.f, 1.f},
+                glm::vec3{1.f, -1.f, 1.f},
+                glm::vec3{-1.f, -1.f, 1.f}
+            };
+
+            glm::mat4 inverse_camera = glm::inverse(getProjMatrix() * getViewMatrix());
+
+            for (auto& corner : frustum_corners)
+            {
+                glm::vec4 inverse_corner = inverse_camera * glm::vec4{ corner, 1.f };
+                corner = inverse_corner / inverse_corner.w;
+            }
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                glm::vec3 distance = frustum_corners[i + 4] - frustum_corners[i];
+                frustum_corners[i + 4] = frustum_corners[i] + (distance * split_dist);
+                frustum_corners[i] = frustum_corners[i] + (distance * last_split);
+            }
+
+            glm::vec3 center = glm::vec3{ 0.f };
+            for (auto& corner : frustum_corners)
+            {
+                center += corner;
+            }
+            center /= 8.f;
+
+            float radius = 0.f;
+
+            for (auto& corner : frustum_corners)
+            {
+                float distance = glm::length(corner - center);
+                radius = glm::max(radius, distance);
+            }
+            radius = std::ceil(radius * 16.f) / 16.f;
+
+            glm::vec3 max_extents = glm::vec3(radius);
+            glm::vec3 min_extents = -max_extents;
+
+            glm::mat4 light_view = glm::lookAt(center - lightDir * -min_extents.z, center, glm::vec3{ 0.f, -1.f, 0.f });
+            glm::mat4 light_ortho = glm::ortho(min_extents.x, max_extents.x, min_extents.y, max_extents.y, min_extents.z * 2, max_extents.z * 2);
+            light_ortho[1][1] *= -1;
+
+            cascade_data.cascade_splits[i] =  (near_clip + split_dist * range) * -1.f;
+            cascade_data.cascade_view_proj[i] = light_ortho * light_view;
+            cascade_frustums[i] = Frustum::fromViewProj(cascade_data.cascade_view_proj[i]);
+
+            last_split = cascade_splits[i];
         }
+        cascade_data.inverse_view = glm::inverse(getViewMatrix());
     }
 
     void Camera::render(Engine* engine, std::shared_ptr<Entity>& sp)
@@ -164,88 +279,11 @@ namespace lotus
         {
             engine->worker_pool.addWork(std::make_unique<LambdaWorkItem>([this, engine](WorkerThread* thread)
             {
-                memcpy(view_proj_mapped + (engine->renderer.getCurrentImage() * engine->renderer.uniform_buffer_align_up(sizeof(CameraData))), &camera_data, sizeof(camera_data));
+                memcpy(view_proj_mapped + (engine->renderer.getCurrentFrame() * engine->renderer.uniform_buffer_align_up(sizeof(CameraData))), &camera_data, sizeof(camera_data));
 
                 if (thread->engine->renderer.render_mode == RenderMode::Rasterization)
                 {
-                    glm::vec3 lightDir = thread->engine->lights.light.diffuse_dir;
-                    float cascade_splits[lotus::Renderer::shadowmap_cascades];
-
-                    float near_clip = this->getNearClip();
-                    float far_clip = this->getFarClip();
-                    float range = far_clip - near_clip;
-                    float ratio = far_clip / near_clip;
-
-                    for (size_t i = 0; i < lotus::Renderer::shadowmap_cascades; ++i)
-                    {
-                        float p = (i + 1) / static_cast<float>(lotus::Renderer::shadowmap_cascades);
-                        float log = near_clip * std::pow(ratio, p);
-                        float uniform = near_clip + range * p;
-                        float d = 0.95f * (log - uniform) + uniform;
-                        cascade_splits[i] = (d - near_clip) / range;
-                    }
-
-                    float last_split = 0.0f;
-
-                    for (uint32_t i = 0; i < lotus::Renderer::shadowmap_cascades; ++i)
-                    {
-                        float split_dist = cascade_splits[i];
-                        std::array<glm::vec3, 8> frustum_corners = {
-                            glm::vec3{-1.f, 1.f, -1.f},
-                            glm::vec3{1.f, 1.f, -1.f},
-                            glm::vec3{1.f, -1.f, -1.f},
-                            glm::vec3{-1.f, -1.f, -1.f},
-                            glm::vec3{-1.f, 1.f, 1.f},
-                            glm::vec3{1.f, 1.f, 1.f},
-                            glm::vec3{1.f, -1.f, 1.f},
-                            glm::vec3{-1.f, -1.f, 1.f}
-                        };
-
-                        glm::mat4 inverse_camera = glm::inverse(getProjMatrix() * getViewMatrix());
-
-                        for (auto& corner : frustum_corners)
-                        {
-                            glm::vec4 inverse_corner = inverse_camera * glm::vec4{ corner, 1.f };
-                            corner = inverse_corner / inverse_corner.w;
-                        }
-
-                        for (size_t i = 0; i < 4; ++i)
-                        {
-                            glm::vec3 distance = frustum_corners[i + 4] - frustum_corners[i];
-                            frustum_corners[i + 4] = frustum_corners[i] + (distance * split_dist);
-                            frustum_corners[i] = frustum_corners[i] + (distance * last_split);
-                        }
-
-                        glm::vec3 center = glm::vec3{ 0.f };
-                        for (auto& corner : frustum_corners)
-                        {
-                            center += corner;
-                        }
-                        center /= 8.f;
-
-                        float radius = 0.f;
-
-                        for (auto& corner : frustum_corners)
-                        {
-                            float distance = glm::length(corner - center);
-                            radius = glm::max(radius, distance);
-                        }
-                        radius = std::ceil(radius * 16.f) / 16.f;
-
-                        glm::vec3 max_extents = glm::vec3(radius);
-                        glm::vec3 min_extents = -max_extents;
-
-                        glm::mat4 light_view = glm::lookAt(center - lightDir * -min_extents.z, center, glm::vec3{ 0.f, -1.f, 0.f });
-                        glm::mat4 light_ortho = glm::ortho(min_extents.x, max_extents.x, min_extents.y, max_extents.y, min_extents.z * 2, max_extents.z * 2);
-                        light_ortho[1][1] *= -1;
-
-                        cascade_data.cascade_splits[i] =  (near_clip + split_dist * range) * -1.f;
-                        cascade_data.cascade_view_proj[i] = light_ortho * light_view;
-
-                        last_split = cascade_splits[i];
-                    }
-                    cascade_data.inverse_view = glm::inverse(getViewMatrix());
-                    memcpy(cascade_data_mapped + (thread->engine->renderer.getCurrentImage() * thread->engine->renderer.uniform_buffer_align_up(sizeof(cascade_data))), &cascade_data, sizeof(cascade_data));
+                    memcpy(cascade_data_mapped + (thread->engine->renderer.getCurrentFrame() * thread->engine->renderer.uniform_buffer_align_up(sizeof(cascade_data))), &cascade_data, sizeof(cascade_data));
                 }
             }));
         }
@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "entity.h"
 #include "engine/renderer/memory.h"
+#include "engine/renderer/bounds.h"
 #include "engine/renderer/vulkan/renderer.h"
 
 //i love windows
@@ -28,6 +29,7 @@ namespace lotus
         void setPerspective(float radians, float aspect, float near_clip, float far_clip);
         float getNearClip() { return near_clip; }
         float getFarClip() { return far_clip; }
+        float getFov() { return fov; }
         void move(float forward_offset, float right_offset);
         void look(float rot_x_offset, float rot_y_offset);
         float getRotX() const { return rot_x; }
@@ -62,19 +64,28 @@ namespace lotus
             glm::vec4 bottom;
             glm::vec4 near;
             glm::vec4 far;
+
+            static Frustum fromViewProj(const glm::mat4& view_proj);
+
+            bool intersects(const BoundingSphere& sphere) const;
         } frustum {};
 
+        //light space frustum of each shadowmap cascade, matching cascade_data.cascade_view_proj
+        std::array<Frustum, Renderer::shadowmap_cascades> cascade_frustums {};
+
         std::unique_ptr<Buffer> cascade_data_ubo;
         uint8_t* cascade_data_mapped{ nullptr };
 
     protected:
         virtual void tick(time_point time, duration delta) override;
         virtual void render(Engine* engine, std::shared_ptr<Entity>& sp) override;
+        void updateCascades();
 
         float rot_x{ -glm::pi<float>() };
         float rot_y{ 0.f };
         float near_clip{ 0.f };
         float far_clip{ 0.f };
+        float fov{ 0.f };
         glm::vec3 camera_rot{};
 
         float nh{};
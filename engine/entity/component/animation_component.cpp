@@ -2,26 +2,18 @@
 #include "engine/core.h"
 #include "engine/entity/deformable_entity.h"
 #include "engine/renderer/skeleton.h"
-#include "engine/task/transform_skeleton.h"
 
 namespace lotus
 {
     AnimationComponent::AnimationComponent(Entity* _entity, Engine* _engine, std::unique_ptr<Skeleton>&& _skeleton, size_t _vertex_stride) : Component(_entity, _engine), skeleton(std::move(_skeleton)), vertex_stride(_vertex_stride)
     {
-        skeleton_bone_buffer = engine->renderer.memory_manager->GetBuffer(sizeof(BufferBone) * skeleton->bones.size() * engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
         //TODO: remove me
+        pose.resize(skeleton->bones.size());
+        skeleton->animations["idl0"]->sample(0, 0, 0.f, pose);
         playAnimation("idl0");
-        for (uint32_t i = 0; i < skeleton->bones.size(); ++i)
-        {
-            auto& bone = skeleton->bones[i];
-            bone.rot = skeleton->animations["idl0"]->transforms[0][i].rot;
-            bone.trans = skeleton->animations["idl0"]->transforms[0][i].trans;
-            bone.scale = skeleton->animations["idl0"]->transforms[0][i].scale;
-        }
     }
 
-    void AnimationComponent::tick(time_point time, duration delta)
+    void AnimationComponent::updatePose(time_point time)
     {
         if (current_animation)
         {
@@ -32,34 +24,30 @@ namespace lotus
             if (animation_delta < interpolation_time)
             {
                 float frame_f = static_cast<float>(animation_delta.count()) / static_cast<float>(interpolation_time.count());
-                size_t frame = (interpolation_time / frame_duration) % current_animation->transforms.size();
-                for (uint32_t i = 0; i < skeleton->bones.size(); ++i)
-                {
-                    auto& bone = skeleton->bones[i];
-                    bone.rot = glm::slerp(bones_interpolate[i].rot, current_animation->transforms[frame][i].rot, frame_f);
-                    bone.trans = glm::mix(bones_interpolate[i].trans, current_animation->transforms[frame][i].trans, frame_f);
-                    bone.scale = glm::mix(bones_interpolate[i].scale, current_animation->transforms[frame][i].scale, frame_f);
-                }
+                uint32_t frame = (interpolation_time / frame_duration) % current_animation->getFrameCount();
+                current_animation->sample(frame, frame, 0.f, pose, &pose_interpolate, frame_f);
             }
             else
             {
                 float frame_f = static_cast<float>((animation_delta % frame_duration).count()) / static_cast<float>(frame_duration.count());
-                size_t frame = (animation_delta / frame_duration) % current_animation->transforms.size();
-                uint32_t next_frame = (frame + 1) % current_animation->transforms.size();
-                for (uint32_t i = 0; i < skeleton->bones.size(); ++i)
-                {
-                    auto& bone = skeleton->bones[i];
-                    bone.rot = glm::slerp(current_animation->transforms[frame][i].rot, current_animation->transforms[next_frame][i].rot, frame_f);
-                    bone.trans = glm::mix(current_animation->transforms[frame][i].trans, current_animation->transforms[next_frame][i].trans, frame_f);
-                    bone.scale = glm::mix(current_animation->transforms[frame][i].scale, current_animation->transforms[next_frame][i].scale, frame_f);
-                }
+                uint32_t frame = (animation_delta / frame_duration) % current_animation->getFrameCount();
+                uint32_t next_frame = (frame + 1) % current_animation->getFrameCount();
+                current_animation->sample(frame, next_frame, frame_f, pose);
             }
         }
     }
 
-    void AnimationComponent::render(Engine* engine, std::shared_ptr<Entity>& sp)
+    void AnimationComponent::writeBones(BufferBone* bones) const
     {
-        engine->worker_pool.addWork(std::make_unique<TransformSkeletonTask>(std::static_pointer_cast<DeformableEntity>(sp)));
+        for (size_t i = 0; i < pose.size(); ++i)
+        {
+            bones[i].trans = { pose.trans_x[i], pose.trans_y[i], pose.trans_z[i] };
+            bones[i].scale = { pose.scale_x[i], pose.scale_y[i], pose.scale_z[i] };
+            bones[i].rot.x = pose.rot_x[i];
+            bones[i].rot.y = pose.rot_y[i];
+            bones[i].rot.z = pose.rot_z[i];
+            bones[i].rot.w = pose.rot_w[i];
+        }
     }
 
     void AnimationComponent::playAnimation(std::string name, float speed, std::optional<std::string> _next_anim)
@@ -80,12 +68,7 @@ namespace lotus
         anim_speed = speed;
         current_animation = skeleton->animations[name].get();
         animation_start = sim_clock::now();
-        //copy current bones so that we can interpolate off them to the new animation
-        //bones_interpolate = skeleton->bones;
-        bones_interpolate.clear();
-        for (const auto& bone : skeleton->bones)
-        {
-            bones_interpolate.emplace_back(bone);
-        }
+        //copy the current pose so that we can interpolate off it to the new animation
+        pose_interpolate = pose;
     }
 }
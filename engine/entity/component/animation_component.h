@@ -16,16 +16,16 @@ namespace lotus
     public:
         struct ModelTransformedGeometry
         {
-            //transformed vertex buffers (per mesh, per render target)
+            //transformed vertex buffers (per mesh, per frame in flight)
             std::vector<std::vector<std::unique_ptr<Buffer>>> vertex_buffers;
-            //acceleration structures (per render target)
+            //acceleration structures (per frame in flight)
             std::vector<std::unique_ptr<BottomLevelAccelerationStructure>> bottom_level_as;
         };
         explicit AnimationComponent(Entity*, Engine* engine, std::unique_ptr<Skeleton>&&, size_t vertex_stride);
         virtual ~AnimationComponent() override = default;
 
-        virtual void tick(time_point time, duration delta) override;
-        virtual void render(Engine* engine, std::shared_ptr<Entity>& sp) override;
+        //samples the current animation into the pose; only touches this component, so the scene updates every component's pose in parallel after ticking
+        void updatePose(time_point time);
         void playAnimation(std::string name, float speed = 1.f, std::optional<std::string> next_anim = {});
         void playAnimationLoop(std::string name, float speed = 1.f );
 
@@ -43,14 +43,17 @@ namespace lotus
             glm::vec3 scale;
             float _pad2;
         };
-        std::unique_ptr<Buffer> skeleton_bone_buffer;
+        //current pose, in the layout the skinning shader reads (bones.size() entries)
+        void writeBones(BufferBone* bones) const;
 
     protected:
         void changeAnimation(std::string name, float speed);
         static constexpr duration interpolation_time{ 100ms };
 
         std::optional<std::string> next_anim;
-        std::vector<Skeleton::Bone> bones_interpolate;
+        //current pose, and the one it was in when the animation changed (to cross-fade from)
+        Animation::Streams pose;
+        Animation::Streams pose_interpolate;
         float anim_speed{ 1.f };
         bool loop{ true };
     };
@@ -10,11 +10,49 @@ namespace lotus
 
     void DeformableEntity::addSkeleton(std::unique_ptr<Skeleton>&& skeleton, size_t vertex_stride)
     {
+        skeleton_bounds = {};
+        for (const auto& [name, animation] : skeleton->animations)
+        {
+            skeleton_bounds.extend(animation->bounds);
+        }
         addComponent<AnimationComponent>(std::move(skeleton), vertex_stride);
         animation_component = getComponent<AnimationComponent>();
     }
 
-    void DeformableEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    void DeformableEntity::updateBounds()
+    {
+        AABB bounds;
+        for (const auto& model : models)
+        {
+            if (!model->bounds.valid())
+            {
+                world_bounds = {};
+                world_sphere = {};
+                return;
+            }
+            if (model->weighted)
+            {
+                //any vertex is at most the model's bone radius away from a bone
+                if (!skeleton_bounds.valid())
+                {
+                    world_bounds = {};
+                    world_sphere = {};
+                    return;
+                }
+                glm::vec3 radius{ model->bounding_sphere.radius };
+                bounds.extend(AABB{ skeleton_bounds.min - radius, skeleton_bounds.max + radius });
+            }
+            else
+            {
+                bounds.extend(model->bounds);
+            }
+        }
+        auto model_matrix = getModelMatrix();
+        world_bounds = bounds.transform(model_matrix);
+        world_sphere = BoundingSphere::fromAABB(bounds).transform(model_matrix);
+    }
+
+    void DeformableEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (size_t i = 0; i < models.size(); ++i)
         {
@@ -22,7 +60,7 @@ namespace lotus
             BottomLevelAccelerationStructure* blas = nullptr;
             if (model->weighted)
             {
-                blas = animation_component->transformed_geometries[i].bottom_level_as[image_index].get();
+                blas = animation_component->transformed_geometries[i].bottom_level_as[frame_index].get();
             }
             else if (model->bottom_level_as)
             {
@@ -50,7 +88,7 @@ namespace lotus
         }
     }
 
-    void DeformableEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    void DeformableEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (size_t i = 0; i < models.size(); ++i)
         {
@@ -58,7 +96,7 @@ namespace lotus
             BottomLevelAccelerationStructure* blas = nullptr;
             if (model->weighted)
             {
-                blas = animation_component->transformed_geometries[i].bottom_level_as[image_index].get();
+                blas = animation_component->transformed_geometries[i].bottom_level_as[frame_index].get();
             }
             else if (model->bottom_level_as)
             {
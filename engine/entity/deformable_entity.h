@@ -12,9 +12,12 @@ namespace lotus
 
         void addSkeleton(std::unique_ptr<Skeleton>&& skeleton, size_t vertex_stride);
 
-        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index);
-        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t image_index);
+        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index);
+        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index);
+        virtual void updateBounds() override;
 
         AnimationComponent* animation_component {nullptr};
+        //model space extents of the bones over every animation
+        AABB skeleton_bounds;
     };
 }
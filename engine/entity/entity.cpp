@@ -44,6 +44,7 @@ namespace lotus
     {
         this->pos = pos;
         this->pos_mat = glm::translate(glm::mat4{ 1.f }, pos);
+        moved = true;
     }
 
     void Entity::setRot(glm::quat quat)
@@ -61,6 +61,9 @@ namespace lotus
         glm::vec3 getRotEuler();
 
         bool should_remove() { return remove; };
+        //set whenever the position changes, cleared once Scene has updated its spatial index
+        bool has_moved() const { return moved; }
+        void clear_moved() { moved = false; }
 
     protected:
         virtual void tick(time_point time, duration delta){}
@@ -78,6 +81,7 @@ namespace lotus
 
         //toggle when the entity is to be removed from the scene
         bool remove{ false };
+        bool moved{ true };
 
     private:
         std::vector<std::unique_ptr<Component>> components;
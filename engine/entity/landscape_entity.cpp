@@ -5,7 +5,19 @@
 
 namespace lotus
 {
-    void LandscapeEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    LandscapeEntity::~LandscapeEntity()
+    {
+        if (visible_instance_buffer_mapped)
+        {
+            visible_instance_buffer->unmap();
+        }
+        if (indirect_buffer_mapped)
+        {
+            indirect_buffer->unmap();
+        }
+    }
+
+    void LandscapeEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (const auto& model : models)
         {
@@ -29,7 +41,46 @@ namespace lotus
         }
     }
 
-    void LandscapeEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    void LandscapeEntity::writeVisibleInstances(uint32_t frame_index, uint32_t view, const std::vector<std::pair<uint32_t, InstanceInfo>>& instances)
+    {
+        if (!visible_instance_buffer_mapped || !indirect_buffer_mapped || view >= view_count)
+            return;
+
+        uint32_t slot = frame_index * view_count + view;
+        visible_counts.assign(models.size(), 0);
+        InstanceInfo* slot_instances = visible_instance_buffer_mapped + instance_info.size() * slot;
+        for (const auto& [model_index, info] : instances)
+        {
+            auto [offset, count] = model_instance_ranges[model_index];
+            auto& visible = visible_counts[model_index];
+            if (visible < count)
+            {
+                slot_instances[offset + visible] = info;
+                ++visible;
+            }
+        }
+
+        vk::DrawIndexedIndirectCommand* slot_draws = indirect_buffer_mapped + draw_count * slot;
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            for (size_t j = 0; j < models[i]->meshes.size(); ++j)
+            {
+                slot_draws[model_draw_offsets[i] + j].instanceCount = visible_counts[i];
+            }
+        }
+    }
+
+    vk::DeviceSize LandscapeEntity::getVisibleInstanceOffset(uint32_t frame_index, uint32_t view, vk::DeviceSize instance_offset) const
+    {
+        return (instance_info.size() * (frame_index * view_count + view) + instance_offset) * sizeof(InstanceInfo);
+    }
+
+    vk::DeviceSize LandscapeEntity::getIndirectOffset(uint32_t frame_index, uint32_t view, uint32_t draw_index) const
+    {
+        return (static_cast<vk::DeviceSize>(draw_count) * (frame_index * view_count + view) + draw_index) * sizeof(vk::DrawIndexedIndirectCommand);
+    }
+
+    void LandscapeEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         //landscape can't move so no need to update
     }
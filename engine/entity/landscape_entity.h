@@ -14,15 +14,43 @@ namespace lotus
         };
 
         explicit LandscapeEntity(Engine* _engine) : RenderableEntity(_engine) {}
-        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index) override;
-        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t image_index) override;
+        virtual ~LandscapeEntity();
+        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index) override;
+        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index) override;
         virtual std::unique_ptr<WorkItem> recreate_command_buffers(std::shared_ptr<Entity>& sp) override;
+        //instances are culled individually, so the entity itself is never culled
+        virtual void updateBounds() override {}
+
+        //views with their own culled instance list: the gbuffer pass, then each shadowmap cascade (if shadowmaps are used)
+        static constexpr uint32_t gbuffer_view{ 0 };
+        static constexpr uint32_t getCascadeView(uint32_t cascade) { return 1 + cascade; }
+
+        //rewrites the raster instance list for a frame/view, grouped per model (pair of model index/instance)
+        void writeVisibleInstances(uint32_t frame_index, uint32_t view, const std::vector<std::pair<uint32_t, InstanceInfo>>& instances);
+        vk::DeviceSize getVisibleInstanceOffset(uint32_t frame_index, uint32_t view, vk::DeviceSize instance_offset) const;
+        vk::DeviceSize getIndirectOffset(uint32_t frame_index, uint32_t view, uint32_t draw_index) const;
+        uint32_t getViewCount() const { return view_count; }
 
         std::unique_ptr<Buffer> instance_buffer;
         std::vector<InstanceInfo> instance_info;
         std::unordered_map<std::string, std::pair<vk::DeviceSize, uint32_t>> instance_offsets; //pair of offset/count
 
+        //per frame, per view copy of the instances that survived culling, drawn through indirect_buffer
+        std::unique_ptr<Buffer> visible_instance_buffer;
+        InstanceInfo* visible_instance_buffer_mapped{ nullptr };
+        std::unique_ptr<Buffer> indirect_buffer;
+        vk::DrawIndexedIndirectCommand* indirect_buffer_mapped{ nullptr };
+        std::vector<uint32_t> model_draw_offsets; //first indirect draw for each model's meshes
+        uint32_t draw_count{ 0 };
+        uint32_t view_count{ 1 };
+
+        friend class LandscapeEntityInitTask;
+
         std::vector<std::shared_ptr<Model>> collision_models;
         std::shared_ptr<TopLevelAccelerationStructure> collision_as;
+
+    protected:
+        std::vector<uint32_t> visible_counts;
+        std::vector<std::pair<vk::DeviceSize, uint32_t>> model_instance_ranges;
     };
 }
@@ -47,7 +47,12 @@ namespace lotus
         engine->worker_pool.addWork(std::make_unique<EntityRenderTask>(re_sp));
     }
     
-    void Particle::populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    std::unique_ptr<WorkItem> Particle::recreate_command_buffers(std::shared_ptr<Entity>& sp)
+    {
+        return std::make_unique<ParticleEntityReInitTask>(std::static_pointer_cast<Particle>(sp));
+    }
+
+    void Particle::populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (size_t i = 0; i < models.size(); ++i)
         {
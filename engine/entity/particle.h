@@ -18,7 +18,8 @@ namespace lotus
         duration getLifetime() { return lifetime; }
         time_point getSpawnTime() { return spawn_time; }
 
-        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index);
+        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index);
+        virtual std::unique_ptr<WorkItem> recreate_command_buffers(std::shared_ptr<Entity>& sp) override;
 
         uint64_t resource_index{ 0 };
 
@@ -12,14 +12,6 @@ namespace lotus
 
     RenderableEntity::~RenderableEntity()
     {
-        if (uniform_buffer_mapped)
-        {
-            uniform_buffer->unmap();
-        }
-        if (mesh_index_buffer_mapped)
-        {
-            mesh_index_buffer->unmap();
-        }
     }
 
     std::unique_ptr<WorkItem> RenderableEntity::recreate_command_buffers(std::shared_ptr<Entity>& sp)
@@ -44,17 +36,33 @@ namespace lotus
         return scale;
     }
 
-    void RenderableEntity::render(Engine* engine, std::shared_ptr<Entity>& sp)
+    void RenderableEntity::updateBounds()
     {
-        //TODO: check bounding box
-        //if (glm::dot(engine->camera.getPos() - pos, engine->camera.getRotationVector()) > 0)
+        AABB bounds;
+        for (const auto& model : models)
         {
-            auto re_sp = std::static_pointer_cast<RenderableEntity>(sp);
-            engine->worker_pool.addWork(std::make_unique<EntityRenderTask>(re_sp));
+            if (!model->bounds.valid())
+            {
+                //can't cull what we don't know the size of
+                world_bounds = {};
+                world_sphere = {};
+                return;
+            }
+            bounds.extend(model->bounds);
         }
+        auto model_matrix = getModelMatrix();
+        world_bounds = bounds.transform(model_matrix);
+        world_sphere = BoundingSphere::fromAABB(bounds).transform(model_matrix);
+    }
+
+    void RenderableEntity::render(Engine* engine, std::shared_ptr<Entity>& sp)
+    {
+        //culling is done in Scene::render
+        auto re_sp = std::static_pointer_cast<RenderableEntity>(sp);
+        engine->worker_pool.addWork(std::make_unique<EntityRenderTask>(re_sp));
     }
 
-    void RenderableEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    void RenderableEntity::populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (size_t i = 0; i < models.size(); ++i)
         {
@@ -75,7 +83,7 @@ namespace lotus
         }
     }
 
-    void RenderableEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t image_index)
+    void RenderableEntity::update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index)
     {
         for (size_t i = 0; i < models.size(); ++i)
         {
@@ -5,6 +5,8 @@
 #include <memory>
 #include "engine/renderer/model.h"
 #include "engine/renderer/skeleton.h"
+#include "engine/renderer/vulkan/renderer.h"
+#include "engine/renderer/constant_arena.h"
 
 namespace lotus
 {
@@ -27,21 +29,30 @@ namespace lotus
 
         glm::vec3 getScale();
 
-        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t image_index);
-        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t image_index);
+        virtual void populate_AS(TopLevelAccelerationStructure* as, uint32_t frame_index);
+        virtual void update_AS(TopLevelAccelerationStructure* as, uint32_t frame_index);
 
         std::vector<std::shared_ptr<Model>> models;
 
         glm::mat4 getModelMatrix();
 
-        std::unique_ptr<Buffer> uniform_buffer;
-        uint8_t* uniform_buffer_mapped{ nullptr };
+        //recomputes world_bounds/world_sphere from the models' bounds; leaves them invalid if the entity can't be culled
+        virtual void updateBounds();
+
+        AABB world_bounds;
+        BoundingSphere world_sphere;
+        //set by Scene each frame before render
+        bool visible{ true };
+        bool shadow_visible{ true };
+        //shadow_visible is set if any of these are
+        std::array<bool, Renderer::shadowmap_cascades> cascade_visible{ true, true, true, true };
+
+        //model matrices (UniformBufferObject) and mesh index, per frame in flight
+        ConstantArena::Slot constants;
         std::vector<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>> command_buffers;
+        //one per frame in flight per cascade (frame * shadowmap_cascades + cascade)
         std::vector<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>> shadowmap_buffers;
 
-        std::unique_ptr<Buffer> mesh_index_buffer;
-        uint8_t* mesh_index_buffer_mapped{ nullptr };
-
     protected:
         virtual void render(Engine* engine, std::shared_ptr<Entity>& sp) override;
         glm::vec3 scale{ 1.f, 1.f, 1.f };
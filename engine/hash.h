@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace lotus
+{
+    //non-cryptographic content hashing, for recognising byte-identical asset data
+    class Hash
+    {
+    public:
+        //XXH64; seed can be used to chain several buffers (or mix in metadata) into one hash
+        static uint64_t xxh64(const void* data, size_t len, uint64_t seed = 0);
+    };
+}
@@ -6,8 +6,8 @@ namespace lotus
 {
     LightManager::LightManager(Engine* _engine) : engine(_engine)
     {
-        light_buffer = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer)) * engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-        buffer_map = static_cast<uint8_t*>(light_buffer->map(0, engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer)) * engine->renderer.getImageCount(), {}));
+        light_buffer = engine->renderer.memory_manager->GetBuffer(engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer)) * engine->renderer.getFrameCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+        buffer_map = static_cast<uint8_t*>(light_buffer->map(0, engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer)) * engine->renderer.getFrameCount(), {}));
     }
 
     LightManager::~LightManager()
@@ -17,6 +17,6 @@ namespace lotus
 
     void LightManager::UpdateLightBuffer()
     {
-        memcpy(buffer_map + (engine->renderer.getCurrentImage() * engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer))), &light, sizeof(light));
+        memcpy(buffer_map + (engine->renderer.getCurrentFrame() * engine->renderer.uniform_buffer_align_up(sizeof(LightBuffer))), &light, sizeof(light));
     }
 }
@@ -1,5 +1,6 @@
 #include "acceleration_structure.h"
 #include "engine/core.h"
+#include "engine/renderer/frame_allocator.h"
 #include "engine/renderer/model.h"
 #include "engine/entity/deformable_entity.h"
 #include "engine/entity/particle.h"
@@ -32,9 +33,9 @@ void lotus::AccelerationStructure::PopulateBuffers()
     auto memory_requirements_object = engine->renderer.device->getAccelerationStructureMemoryRequirementsKHR(memory_requirements_info);
 
     scratch_memory = engine->renderer.memory_manager->GetBuffer(memory_requirements_build.memoryRequirements.size > memory_requirements_update.memoryRequirements.size ?
-        memory_requirements_build.memoryRequirements.size : memory_requirements_update.memoryRequirements.size, vk::BufferUsageFlagBits::eRayTracingKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        memory_requirements_build.memoryRequirements.size : memory_requirements_update.memoryRequirements.size, vk::BufferUsageFlagBits::eRayTracingKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Scratch);
 
-    object_memory = engine->renderer.memory_manager->GetMemory(memory_requirements_object.memoryRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal);
+    object_memory = engine->renderer.memory_manager->GetMemory(memory_requirements_object.memoryRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryAllocateFlagBits::eDeviceAddress, MemoryCategory::AccelerationStructure);
 
     vk::BindAccelerationStructureMemoryInfoKHR bind_info;
     bind_info.accelerationStructure = *acceleration_structure;
@@ -105,7 +106,9 @@ void lotus::BottomLevelAccelerationStructure::Update(vk::CommandBuffer buffer)
     UpdateAccelerationStructure(buffer, geometries, geometry_offsets);
 }
 
-lotus::TopLevelAccelerationStructure::TopLevelAccelerationStructure(Engine* _engine, bool _updateable) : AccelerationStructure(_engine, vk::AccelerationStructureTypeKHR::eTopLevel), updateable(_updateable)
+lotus::TopLevelAccelerationStructure::TopLevelAccelerationStructure(Engine* _engine, bool _updateable) : AccelerationStructure(_engine, vk::AccelerationStructureTypeKHR::eTopLevel),
+    descriptor_vertex_info(_engine->renderer.frame_allocator->getResource()), descriptor_index_info(_engine->renderer.frame_allocator->getResource()),
+    descriptor_texture_info(_engine->renderer.frame_allocator->getResource()), instances(_engine->renderer.frame_allocator->getResource()), updateable(_updateable)
 {
     instances.reserve(Renderer::max_acceleration_binding_index);
     if (updateable)
@@ -125,10 +128,10 @@ void lotus::TopLevelAccelerationStructure::Build(vk::CommandBuffer command_buffe
     if (dirty)
     {
         bool update = true;
-        uint32_t i = engine->renderer.getCurrentImage();
+        uint32_t i = engine->renderer.getCurrentFrame();
         if (!instance_memory)
         {
-            instance_memory = engine->renderer.memory_manager->GetBuffer(instances.size() * sizeof(vk::AccelerationStructureInstanceKHR), vk::BufferUsageFlagBits::eRayTracingKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+            instance_memory = engine->renderer.memory_manager->GetBuffer(instances.size() * sizeof(vk::AccelerationStructureInstanceKHR), vk::BufferUsageFlagBits::eRayTracingKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::AccelerationStructure);
             vk::AccelerationStructureCreateGeometryTypeInfoKHR info{vk::GeometryTypeKHR::eInstances, static_cast<uint32_t>(instances.size())};
             info.allowsTransforms = true;
             std::vector<vk::AccelerationStructureCreateGeometryTypeInfoKHR> infos{ info };
@@ -229,7 +232,7 @@ void lotus::TopLevelAccelerationStructure::UpdateInstance(uint32_t instance_id,
 
 void lotus::TopLevelAccelerationStructure::AddBLASResource(Model* model)
 {
-    uint32_t image = engine->renderer.getCurrentImage();
+    uint32_t frame = engine->renderer.getCurrentFrame();
     uint16_t index = static_cast<uint16_t>(descriptor_vertex_info.size()) + engine->renderer.static_acceleration_bindings_offset;
     for (size_t i = 0; i < model->meshes.size(); ++i)
     {
@@ -237,32 +240,32 @@ void lotus::TopLevelAccelerationStructure::AddBLASResource(Model* model)
         descriptor_vertex_info.emplace_back(mesh->vertex_buffer->buffer, 0, VK_WHOLE_SIZE);
         descriptor_index_info.emplace_back(mesh->index_buffer->buffer, 0, VK_WHOLE_SIZE);
         descriptor_texture_info.emplace_back(*mesh->texture->sampler, *mesh->texture->image_view, vk::ImageLayout::eShaderReadOnlyOptimal);
-        engine->renderer.mesh_info_buffer_mapped[image * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, glm::vec3{1.0}, 0, model->light_offset, (uint32_t)mesh->getIndexCount() };
+        engine->renderer.mesh_info_buffer_mapped[frame * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, glm::vec3{1.0}, 0, model->light_offset, (uint32_t)mesh->getIndexCount() };
     }
     model->bottom_level_as->resource_index = index;
 }
 
 void lotus::TopLevelAccelerationStructure::AddBLASResource(DeformableEntity* entity)
 {
-    uint32_t image = engine->renderer.getCurrentImage();
+    uint32_t frame = engine->renderer.getCurrentFrame();
     for (size_t i = 0; i < entity->models.size(); ++i)
     {
         uint16_t index = static_cast<uint16_t>(descriptor_vertex_info.size()) + engine->renderer.static_acceleration_bindings_offset;
         for (size_t j = 0; j < entity->models[i]->meshes.size(); ++j)
         {
             const auto& mesh = entity->models[i]->meshes[j];
-            descriptor_vertex_info.emplace_back(entity->animation_component->transformed_geometries[i].vertex_buffers[j][image]->buffer, 0, VK_WHOLE_SIZE);
+            descriptor_vertex_info.emplace_back(entity->animation_component->transformed_geometries[i].vertex_buffers[j][frame]->buffer, 0, VK_WHOLE_SIZE);
             descriptor_index_info.emplace_back(mesh->index_buffer->buffer, 0, VK_WHOLE_SIZE);
             descriptor_texture_info.emplace_back(*mesh->texture->sampler, *mesh->texture->image_view, vk::ImageLayout::eShaderReadOnlyOptimal);
-            engine->renderer.mesh_info_buffer_mapped[image * Renderer::max_acceleration_binding_index + index + j] = { index + (uint32_t)j, index + (uint32_t)j, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, entity->getScale(), 0, entity->models[i]->light_offset, (uint32_t)mesh->getIndexCount() };
+            engine->renderer.mesh_info_buffer_mapped[frame * Renderer::max_acceleration_binding_index + index + j] = { index + (uint32_t)j, index + (uint32_t)j, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, entity->getScale(), 0, entity->models[i]->light_offset, (uint32_t)mesh->getIndexCount() };
         }
-        entity->animation_component->transformed_geometries[i].bottom_level_as[image]->resource_index = index;
+        entity->animation_component->transformed_geometries[i].bottom_level_as[frame]->resource_index = index;
     }
 }
 
 void lotus::TopLevelAccelerationStructure::AddBLASResource(Particle* entity)
 {
-    uint32_t image = engine->renderer.getCurrentImage();
+    uint32_t frame = engine->renderer.getCurrentFrame();
     uint16_t index = static_cast<uint16_t>(descriptor_vertex_info.size()) + engine->renderer.static_acceleration_bindings_offset;
     auto& model = entity->models[0];
     for (size_t i = 0; i < model->meshes.size(); ++i)
@@ -271,8 +274,8 @@ void lotus::TopLevelAccelerationStructure::AddBLASResource(Particle* entity)
         descriptor_vertex_info.emplace_back(mesh->vertex_buffer->buffer, 0, VK_WHOLE_SIZE);
         descriptor_index_info.emplace_back(mesh->index_buffer->buffer, 0, VK_WHOLE_SIZE);
         descriptor_texture_info.emplace_back(*mesh->texture->sampler, *mesh->texture->image_view, vk::ImageLayout::eShaderReadOnlyOptimal);
-        engine->renderer.mesh_info_buffer_mapped[image * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, entity->color, entity->getScale(), entity->billboard, model->light_offset, (uint32_t)mesh->getIndexCount() };
+        engine->renderer.mesh_info_buffer_mapped[frame * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, entity->color, entity->getScale(), entity->billboard, model->light_offset, (uint32_t)mesh->getIndexCount() };
     }
-    *(uint32_t*)(entity->mesh_index_buffer_mapped + (image * engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)))) = index;
+    *entity->constants.getMeshIndex(frame) = index;
     entity->resource_index = index;
 }
@@ -3,6 +3,7 @@
 #include "engine/types.h"
 #include <glm/glm.hpp>
 #include <unordered_map>
+#include <memory_resource>
 
 namespace lotus
 {
@@ -66,11 +67,12 @@ namespace lotus
         void AddBLASResource(Model* model);
         void AddBLASResource(DeformableEntity* entity);
         void AddBLASResource(Particle* entity);
-        std::vector<vk::DescriptorBufferInfo> descriptor_vertex_info;
-        std::vector<vk::DescriptorBufferInfo> descriptor_index_info;
-        std::vector<vk::DescriptorImageInfo> descriptor_texture_info;
+        //rebuilt every frame, so these live in the frame allocator of the frame that created it
+        std::pmr::vector<vk::DescriptorBufferInfo> descriptor_vertex_info;
+        std::pmr::vector<vk::DescriptorBufferInfo> descriptor_index_info;
+        std::pmr::vector<vk::DescriptorImageInfo> descriptor_texture_info;
     private:
-        std::vector<vk::AccelerationStructureInstanceKHR> instances;
+        std::pmr::vector<vk::AccelerationStructureInstanceKHR> instances;
         std::unique_ptr<Buffer> instance_memory;
         bool updateable{ false };
         bool dirty{ false };
@@ -1,27 +1,513 @@
 #include "animation.h"
 #include "skeleton.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 namespace lotus
 {
-    Animation::Animation(Skeleton* _skeleton) : skeleton(_skeleton)
+    namespace
     {
+        //the sampling kernel is written once against these, and run 8, 4 and then 1 bone at a time
+        struct ScalarLanes
+        {
+            using V = float;
+            static constexpr uint32_t width{ 1 };
+            static V load(const float* p) { return *p; }
+            static void store(float* p, V v) { *p = v; }
+            static V set(float f) { return f; }
+            static V add(V a, V b) { return a + b; }
+            static V sub(V a, V b) { return a - b; }
+            static V mul(V a, V b) { return a * b; }
+            static V div(V a, V b) { return a / b; }
+            static V sqrt(V a) { return std::sqrt(a); }
+            //sign to apply with flip(): the sign bit of a
+            static V sign(V a) { return a < 0.f ? -1.f : 1.f; }
+            static V flip(V a, V sign) { return a * sign; }
+        };
+
+#if defined(__SSE2__) || defined(_M_X64)
+        struct SSELanes
+        {
+            using V = __m128;
+            static constexpr uint32_t width{ 4 };
+            static V load(const float* p) { return _mm_loadu_ps(p); }
+            static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+            static V set(float f) { return _mm_set1_ps(f); }
+            static V add(V a, V b) { return _mm_add_ps(a, b); }
+            static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+            static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+            static V div(V a, V b) { return _mm_div_ps(a, b); }
+            static V sqrt(V a) { return _mm_sqrt_ps(a); }
+            static V sign(V a) { return _mm_and_ps(a, _mm_set1_ps(-0.f)); }
+            static V flip(V a, V sign) { return _mm_xor_ps(a, sign); }
+        };
+#endif
+
+#ifdef __AVX__
+        struct AVXLanes
+        {
+            using V = __m256;
+            static constexpr uint32_t width{ 8 };
+            static V load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+            static V set(float f) { return _mm256_set1_ps(f); }
+            static V add(V a, V b) { return _mm256_add_ps(a, b); }
+            static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+            static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+            static V div(V a, V b) { return _mm256_div_ps(a, b); }
+            static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+            static V sign(V a) { return _mm256_and_ps(a, _mm256_set1_ps(-0.f)); }
+            static V flip(V a, V sign) { return _mm256_xor_ps(a, sign); }
+        };
+#endif
+
+        template<typename L>
+        typename L::V lerp(typename L::V a, typename L::V b, typename L::V t)
+        {
+            return L::add(a, L::mul(L::sub(b, a), t));
+        }
+
+        //a = nlerp(a, b, t) along the shortest path
+        //with fit, t is first bent by a polynomial fit (in t and the angle between a and b) so the result stays within about 1e-3
+        //  radians of slerp (Kapoulkine, "Approximating slerp")
+        template<typename L, bool fit = true>
+        void nlerp(typename L::V* a, const typename L::V* b, typename L::V t)
+        {
+            using V = typename L::V;
+            V d = L::add(L::add(L::mul(a[0], b[0]), L::mul(a[1], b[1])), L::add(L::mul(a[2], b[2]), L::mul(a[3], b[3])));
+            V sign = L::sign(d);
+            d = L::flip(d, sign);
+
+            V adjusted_t = t;
+            if constexpr (fit)
+            {
+                V fit_a = L::add(L::set(1.0904f), L::mul(d, L::add(L::set(-3.2452f), L::mul(d, L::sub(L::set(3.55645f), L::mul(d, L::set(1.43519f)))))));
+                V fit_b = L::add(L::set(0.848013f), L::mul(d, L::add(L::set(-1.06021f), L::mul(d, L::set(0.215638f)))));
+                V half = L::sub(t, L::set(0.5f));
+                V k = L::add(L::mul(fit_a, L::mul(half, half)), fit_b);
+                adjusted_t = L::add(t, L::mul(L::mul(t, L::mul(half, L::sub(t, L::set(1.f)))), k));
+            }
+
+            for (int c = 0; c < 4; ++c)
+            {
+                a[c] = lerp<L>(a[c], L::flip(b[c], sign), adjusted_t);
+            }
+            V length = L::sqrt(L::add(L::add(L::mul(a[0], a[0]), L::mul(a[1], a[1])), L::add(L::mul(a[2], a[2]), L::mul(a[3], a[3]))));
+            for (int c = 0; c < 4; ++c)
+            {
+                a[c] = L::div(a[c], length);
+            }
+        }
+
+        //samples bones [i, count) L::width at a time, leaving i at the first bone that didn't fill a whole lane
+        //frame and next_frame are the offsets of the two frames' rows in clip
+        template<typename L>
+        void sampleLanes(const Animation::Streams& clip, size_t frame, size_t next_frame, float t, Animation::Streams& out, const Animation::Streams* from, float fade, uint32_t& i, uint32_t count)
+        {
+            using V = typename L::V;
+            const V t_v = L::set(t);
+            const V fade_v = L::set(fade);
+            const float* clip_rot[4] = { clip.rot_x.data(), clip.rot_y.data(), clip.rot_z.data(), clip.rot_w.data() };
+            const float* clip_trans[3] = { clip.trans_x.data(), clip.trans_y.data(), clip.trans_z.data() };
+            const float* clip_scale[3] = { clip.scale_x.data(), clip.scale_y.data(), clip.scale_z.data() };
+            float* out_rot[4] = { out.rot_x.data(), out.rot_y.data(), out.rot_z.data(), out.rot_w.data() };
+            float* out_trans[3] = { out.trans_x.data(), out.trans_y.data(), out.trans_z.data() };
+            float* out_scale[3] = { out.scale_x.data(), out.scale_y.data(), out.scale_z.data() };
+
+            for (; i + L::width <= count; i += L::width)
+            {
+                V rot[4], next_rot[4], trans[3], scale[3];
+                for (int c = 0; c < 4; ++c)
+                {
+                    rot[c] = L::load(clip_rot[c] + frame + i);
+                    next_rot[c] = L::load(clip_rot[c] + next_frame + i);
+                }
+                nlerp<L>(rot, next_rot, t_v);
+                for (int c = 0; c < 3; ++c)
+                {
+                    trans[c] = lerp<L>(L::load(clip_trans[c] + frame + i), L::load(clip_trans[c] + next_frame + i), t_v);
+                    scale[c] = lerp<L>(L::load(clip_scale[c] + frame + i), L::load(clip_scale[c] + next_frame + i), t_v);
+                }
+
+                if (from)
+                {
+                    V from_rot[4] = { L::load(from->rot_x.data() + i), L::load(from->rot_y.data() + i), L::load(from->rot_z.data() + i), L::load(from->rot_w.data() + i) };
+                    nlerp<L>(from_rot, rot, fade_v);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        rot[c] = from_rot[c];
+                    }
+                    trans[0] = lerp<L>(L::load(from->trans_x.data() + i), trans[0], fade_v);
+                    trans[1] = lerp<L>(L::load(from->trans_y.data() + i), trans[1], fade_v);
+                    trans[2] = lerp<L>(L::load(from->trans_z.data() + i), trans[2], fade_v);
+                    scale[0] = lerp<L>(L::load(from->scale_x.data() + i), scale[0], fade_v);
+                    scale[1] = lerp<L>(L::load(from->scale_y.data() + i), scale[1], fade_v);
+                    scale[2] = lerp<L>(L::load(from->scale_z.data() + i), scale[2], fade_v);
+                }
+
+                for (int c = 0; c < 4; ++c)
+                {
+                    L::store(out_rot[c] + i, rot[c]);
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    L::store(out_trans[c] + i, trans[c]);
+                    L::store(out_scale[c] + i, scale[c]);
+                }
+            }
+        }
+
+        void sampleStreams(const Animation::Streams& clip, size_t frame, size_t next_frame, float t, Animation::Streams& out, const Animation::Streams* from, float fade, uint32_t count)
+        {
+            uint32_t i = 0;
+#ifdef __AVX__
+            sampleLanes<AVXLanes>(clip, frame, next_frame, t, out, from, fade, i, count);
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+            sampleLanes<SSELanes>(clip, frame, next_frame, t, out, from, fade, i, count);
+#endif
+            sampleLanes<ScalarLanes>(clip, frame, next_frame, t, out, from, fade, i, count);
+        }
+
+        //a compressed clip's pose between the two keys around it of each channel: the earlier keys in the first row of keys,
+        //  the later ones in the second, and how far between them the pose is per bone and channel
+        struct KeyRows
+        {
+            void resize(size_t bones)
+            {
+                keys.resize(2 * bones);
+                rot_t.resize(bones);
+                trans_t.resize(bones);
+                scale_t.resize(bones);
+            }
+
+            Animation::Streams keys;
+            std::vector<float> rot_t, trans_t, scale_t;
+        };
+
+        //interpolates the first count bones of rows' keys into their first row, L::width bones at a time (as sampleLanes)
+        //rotations use plain nlerp, as that's what the keys were reduced against
+        template<typename L>
+        void lerpKeyLanes(KeyRows& rows, uint32_t& i, uint32_t count)
+        {
+            size_t bones = rows.rot_t.size();
+            using V = typename L::V;
+            auto& keys = rows.keys;
+            float* rot[4] = { keys.rot_x.data(), keys.rot_y.data(), keys.rot_z.data(), keys.rot_w.data() };
+            float* trans[3] = { keys.trans_x.data(), keys.trans_y.data(), keys.trans_z.data() };
+            float* scale[3] = { keys.scale_x.data(), keys.scale_y.data(), keys.scale_z.data() };
+
+            for (; i + L::width <= count; i += L::width)
+            {
+                V a[4], b[4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    a[c] = L::load(rot[c] + i);
+                    b[c] = L::load(rot[c] + bones + i);
+                }
+                nlerp<L, false>(a, b, L::load(rows.rot_t.data() + i));
+                for (int c = 0; c < 4; ++c)
+                {
+                    L::store(rot[c] + i, a[c]);
+                }
+                V trans_t = L::load(rows.trans_t.data() + i);
+                V scale_t = L::load(rows.scale_t.data() + i);
+                for (int c = 0; c < 3; ++c)
+                {
+                    L::store(trans[c] + i, lerp<L>(L::load(trans[c] + i), L::load(trans[c] + bones + i), trans_t));
+                    L::store(scale[c] + i, lerp<L>(L::load(scale[c] + i), L::load(scale[c] + bones + i), scale_t));
+                }
+            }
+        }
+
+        void lerpKeys(KeyRows& rows, uint32_t count)
+        {
+            uint32_t i = 0;
+#ifdef __AVX__
+            lerpKeyLanes<AVXLanes>(rows, i, count);
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+            lerpKeyLanes<SSELanes>(rows, i, count);
+#endif
+            lerpKeyLanes<ScalarLanes>(rows, i, count);
+        }
+
+        std::atomic<uint64_t> loaded_clips{ 0 };
+        std::atomic<int64_t> clip_bytes{ 0 };
+        std::atomic<uint64_t> clip_uncompressed_bytes{ 0 };
+        std::atomic<uint64_t> sampled_poses{ 0 };
+        std::atomic<uint64_t> sampled_bones{ 0 };
+        std::atomic<int64_t> sample_nanoseconds{ 0 };
+
+        //smallest-three: the largest component is left out (it's rebuilt from the quaternion being unit length), and made
+        //  positive by negating the whole quaternion, which keeps the other three within +-1/sqrt(2)
+        constexpr float quat_range{ 0.70710678f };
+        constexpr uint64_t quat_max{ 0x7fff };
+
+        void packQuat(glm::quat q, uint16_t* out)
+        {
+            float c[4] = { q.x, q.y, q.z, q.w };
+            int largest = 0;
+            for (int i = 1; i < 4; ++i)
+            {
+                if (std::abs(c[i]) > std::abs(c[largest]))
+                    largest = i;
+            }
+            float sign = c[largest] < 0.f ? -1.f : 1.f;
+            uint64_t bits = largest;
+            for (int i = 0; i < 4; ++i)
+            {
+                if (i == largest)
+                    continue;
+                float v = std::clamp(c[i] * sign / quat_range * 0.5f + 0.5f, 0.f, 1.f);
+                bits = (bits << 15) | static_cast<uint64_t>(std::lround(v * quat_max));
+            }
+            out[0] = static_cast<uint16_t>(bits >> 32);
+            out[1] = static_cast<uint16_t>(bits >> 16);
+            out[2] = static_cast<uint16_t>(bits);
+        }
+
+        glm::quat unpackQuat(const uint16_t* in)
+        {
+            uint64_t bits = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 16) | in[2];
+            int largest = static_cast<int>(bits >> 45);
+            //the three stored components are the others in order, so the k-th goes to k, or k + 1 from the largest on
+            //  (without branching on largest, which differs from key to key)
+            constexpr float scale{ 2.f * quat_range / quat_max };
+            float stored[3] = {
+                static_cast<float>((bits >> 30) & quat_max) * scale - quat_range,
+                static_cast<float>((bits >> 15) & quat_max) * scale - quat_range,
+                static_cast<float>(bits & quat_max) * scale - quat_range
+            };
+            float c[4];
+            for (int k = 0; k < 3; ++k)
+            {
+                c[k + (k >= largest)] = stored[k];
+            }
+            c[largest] = std::sqrt(std::max(0.f, 1.f - stored[0] * stored[0] - stored[1] * stored[1] - stored[2] * stored[2]));
+            return glm::quat{ c[3], c[0], c[1], c[2] };
+        }
+
+        //16 bits per component across [min, min + step * 65535]
+        void packVec(glm::vec3 v, glm::vec3 min, glm::vec3 step, uint16_t* out)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                out[c] = step[c] > 0.f ? static_cast<uint16_t>(std::clamp(std::lround((v[c] - min[c]) / step[c]), 0l, 65535l)) : 0;
+            }
+        }
+
+        glm::vec3 unpackVec(const uint16_t* in, glm::vec3 min, glm::vec3 step)
+        {
+            return min + glm::vec3{ in[0], in[1], in[2] } * step;
+        }
+
+        glm::quat nlerpQuat(glm::quat a, glm::quat b, float t)
+        {
+            if (glm::dot(a, b) < 0.f)
+                b = -b;
+            return glm::normalize(a * (1.f - t) + b * t);
+        }
+
+        glm::vec3 lerpVec(glm::vec3 a, glm::vec3 b, float t)
+        {
+            return glm::mix(a, b, t);
+        }
+
+        //radians between two unit rotations, from the chord between them (2 sin(angle / 4)), as acos of their dot product
+        //  can't resolve tolerances this small in float
+        float rotationAngle(glm::quat a, glm::quat b)
+        {
+            if (glm::dot(a, b) < 0.f)
+                b = -b;
+            float chord = std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) + (a.w - b.w) * (a.w - b.w));
+            return 4.f * std::asin(std::min(1.f, chord * 0.5f));
+        }
+
+        //the frames to keep as keys so that interpolating between them gets every frame within(reconstructed, actual)
+        //keys are interpolated as they'll be decoded (quantized), so the tolerance covers the quantization of the frames in between too
+        //greedy: each key is pushed as far along as the frames it skips allow
+        template<typename T, typename Lerp, typename Within>
+        std::vector<uint32_t> reduceKeys(const std::vector<T>& values, const std::vector<T>& quantized, Lerp lerp, Within within)
+        {
+            std::vector<uint32_t> keys{ 0 };
+            if (std::all_of(values.begin(), values.end(), [&](const T& value) { return within(quantized[0], value); }))
+                return keys;
+
+            uint32_t count = static_cast<uint32_t>(values.size());
+            uint32_t start = 0;
+            while (start + 1 < count)
+            {
+                uint32_t end = start + 1;
+                while (end + 1 < count)
+                {
+                    uint32_t next = end + 1;
+                    bool fits = true;
+                    for (uint32_t frame = start + 1; frame < next && fits; ++frame)
+                    {
+                        fits = within(lerp(quantized[start], quantized[next], static_cast<float>(frame - start) / (next - start)), values[frame]);
+                    }
+                    if (!fits)
+                        break;
+                    end = next;
+                }
+                keys.push_back(end);
+                start = end;
+            }
+            return keys;
+        }
+
+        //one bone's channel: a single key if every frame packs the same, otherwise the reduced keys (or every frame without a tolerance)
+        template<typename K, typename C, typename T, typename Pack, typename Unpack, typename Lerp, typename Within>
+        void addChannel(K& keys, const std::vector<T>& values, bool reduce, Pack pack, Unpack unpack, Lerp lerp, Within within)
+        {
+            uint32_t count = static_cast<uint32_t>(values.size());
+            std::vector<uint16_t> packed(count * 3);
+            for (uint32_t frame = 0; frame < count; ++frame)
+            {
+                pack(values[frame], packed.data() + frame * 3);
+            }
+
+            std::vector<uint32_t> frames;
+            bool constant = true;
+            for (uint32_t frame = 1; frame < count && constant; ++frame)
+            {
+                constant = std::equal(packed.begin(), packed.begin() + 3, packed.begin() + frame * 3);
+            }
+            if (constant)
+            {
+                frames.push_back(0);
+            }
+            else if (reduce)
+            {
+                std::vector<T> quantized(count);
+                for (uint32_t frame = 0; frame < count; ++frame)
+                {
+                    quantized[frame] = unpack(packed.data() + frame * 3);
+                }
+                frames = reduceKeys(values, quantized, lerp, within);
+            }
+            else
+            {
+                frames.resize(count);
+                for (uint32_t frame = 0; frame < count; ++frame)
+                {
+                    frames[frame] = frame;
+                }
+            }
+
+            keys.channels.push_back(C{ static_cast<uint32_t>(keys.frames.size()), static_cast<uint32_t>(frames.size()) });
+            for (auto frame : frames)
+            {
+                keys.frames.push_back(static_cast<uint16_t>(frame));
+                keys.values.insert(keys.values.end(), packed.begin() + frame * 3, packed.begin() + frame * 3 + 3);
+            }
+        }
+
+        template<typename K, typename Unpack, typename Lerp>
+        auto decodeChannel(const K& keys, uint32_t bone, uint32_t frame, Unpack unpack, Lerp lerp)
+        {
+            const auto& channel = keys.channels[bone];
+            const uint16_t* values = keys.values.data() + static_cast<size_t>(channel.first_key) * 3;
+            if (channel.key_count == 1)
+                return unpack(values);
+
+            //the first key is always frame 0 and the last one the final frame
+            auto first = keys.frames.begin() + channel.first_key;
+            uint32_t next = static_cast<uint32_t>(std::upper_bound(first, first + channel.key_count, frame) - first);
+            uint32_t key = next - 1;
+            if (next == channel.key_count || first[key] == frame)
+                return unpack(values + key * 3);
+            float t = static_cast<float>(frame - first[key]) / (first[next] - first[key]);
+            return lerp(unpack(values + key * 3), unpack(values + next * 3), t);
+        }
+
+        //the keys either side of frame + t (t in [0, 1], with frame + 1 still in the clip), and how far between them it is
+        //frame and frame + 1 always lie within one pair of keys, so the pose between them only needs those two
+        template<typename K>
+        float keySpan(const K& keys, uint32_t bone, uint32_t frame, float t, const uint16_t*& key, const uint16_t*& next_key)
+        {
+            const auto& channel = keys.channels[bone];
+            const uint16_t* values = keys.values.data() + static_cast<size_t>(channel.first_key) * 3;
+            key = next_key = values;
+            if (channel.key_count == 1)
+                return 0.f;
+
+            auto first = keys.frames.begin() + channel.first_key;
+            uint32_t next = static_cast<uint32_t>(std::upper_bound(first, first + channel.key_count, frame) - first);
+            key = next_key = values + (next - 1) * 3;
+            if (next == channel.key_count)
+                return 0.f;
+            next_key = values + next * 3;
+            return (static_cast<float>(frame - first[next - 1]) + t) / (first[next] - first[next - 1]);
+        }
     }
 
-    void Animation::addFrameData(uint32_t frame, uint32_t bone_index, BoneTransform transform)
+    void Animation::Streams::resize(size_t size)
     {
-        //multiply with skeleton
-        if (frame >= transforms.size())
+        for (auto stream : { &rot_x, &rot_y, &rot_z, &rot_w, &trans_x, &trans_y, &trans_z })
         {
-            transforms.resize(frame+1);
+            stream->resize(size);
         }
+        for (auto stream : { &scale_x, &scale_y, &scale_z })
+        {
+            stream->resize(size, 1.f);
+        }
+    }
+
+    Animation::BoneTransform Animation::Streams::get(size_t i) const
+    {
+        return {
+            glm::quat{ rot_w[i], rot_x[i], rot_y[i], rot_z[i] },
+            glm::vec3{ trans_x[i], trans_y[i], trans_z[i] },
+            glm::vec3{ scale_x[i], scale_y[i], scale_z[i] }
+        };
+    }
+
+    void Animation::Streams::set(size_t i, const BoneTransform& transform)
+    {
+        rot_x[i] = transform.rot.x;
+        rot_y[i] = transform.rot.y;
+        rot_z[i] = transform.rot.z;
+        rot_w[i] = transform.rot.w;
+        trans_x[i] = transform.trans.x;
+        trans_y[i] = transform.trans.y;
+        trans_z[i] = transform.trans.z;
+        scale_x[i] = transform.scale.x;
+        scale_y[i] = transform.scale.y;
+        scale_z[i] = transform.scale.z;
+    }
 
+    Animation::Animation(Skeleton* _skeleton, uint32_t _frame_count) : skeleton(_skeleton), frame_count(_frame_count), bone_count(static_cast<uint32_t>(_skeleton->bones.size()))
+    {
+        streams.resize(static_cast<size_t>(frame_count) * bone_count);
+        loaded_clips.fetch_add(1, std::memory_order_relaxed);
+        clip_bytes.fetch_add(getMemorySize(), std::memory_order_relaxed);
+        clip_uncompressed_bytes.fetch_add(getUncompressedSize(), std::memory_order_relaxed);
+    }
+
+    Animation::~Animation()
+    {
+        loaded_clips.fetch_sub(1, std::memory_order_relaxed);
+        clip_bytes.fetch_sub(getMemorySize(), std::memory_order_relaxed);
+        clip_uncompressed_bytes.fetch_sub(getUncompressedSize(), std::memory_order_relaxed);
+    }
+
+    void Animation::addFrameData(uint32_t frame, uint32_t bone_index, BoneTransform transform)
+    {
+        //multiply with skeleton
         Skeleton::Bone& bone = skeleton->bones[bone_index];
         BoneTransform new_transform;
 
         if (bone_index != 0)
         {
             BoneTransform local_transform = { transform.rot * bone.local_rot, bone.local_trans + transform.trans,  transform.scale };
-            const BoneTransform& parent_transform = transforms[frame][bone.parent_bone];
+            BoneTransform parent_transform = getTransform(frame, bone.parent_bone);
             new_transform = { parent_transform.rot * local_transform.rot, parent_transform.trans + (parent_transform.rot * local_transform.trans), local_transform.scale * parent_transform.scale };
         }
         else
@@ -29,7 +515,167 @@ namespace lotus
             new_transform = { transform.rot * bone.local_rot, bone.local_trans + transform.trans, transform.scale };
         }
 
-        transforms[frame][bone_index] = new_transform;
+        streams.set(static_cast<size_t>(frame) * bone_count + bone_index, new_transform);
+        bounds.extend(new_transform.trans);
     }
 
+    void Animation::compress(float rotation_tolerance, float translation_tolerance, float scale_tolerance)
+    {
+        //key frames are 16 bit
+        if (compressed || frame_count == 0 || frame_count > std::numeric_limits<uint16_t>::max() + 1u)
+            return;
+
+        size_t streams_size = getMemorySize();
+        //bones are stored in model space, so dropping a parent's keys doesn't add to its children's error
+        glm::vec3 trans_max{ std::numeric_limits<float>::lowest() };
+        glm::vec3 scale_max{ std::numeric_limits<float>::lowest() };
+        trans_min = glm::vec3{ std::numeric_limits<float>::max() };
+        scale_min = glm::vec3{ std::numeric_limits<float>::max() };
+        for (size_t i = 0; i < streams.size(); ++i)
+        {
+            auto transform = streams.get(i);
+            trans_min = glm::min(trans_min, transform.trans);
+            trans_max = glm::max(trans_max, transform.trans);
+            scale_min = glm::min(scale_min, transform.scale);
+            scale_max = glm::max(scale_max, transform.scale);
+        }
+        trans_step = (trans_max - trans_min) / 65535.f;
+        scale_step = (scale_max - scale_min) / 65535.f;
+
+        bool reduce = rotation_tolerance > 0.f || translation_tolerance > 0.f || scale_tolerance > 0.f;
+        auto within_rot = [rotation_tolerance](glm::quat a, glm::quat b) { return rotationAngle(a, b) <= rotation_tolerance; };
+        auto within_trans = [translation_tolerance](glm::vec3 a, glm::vec3 b) { return glm::distance(a, b) <= translation_tolerance; };
+        auto within_scale = [scale_tolerance](glm::vec3 a, glm::vec3 b) { return glm::distance(a, b) <= scale_tolerance; };
+        auto pack_trans = [this](glm::vec3 v, uint16_t* out) { packVec(v, trans_min, trans_step, out); };
+        auto pack_scale = [this](glm::vec3 v, uint16_t* out) { packVec(v, scale_min, scale_step, out); };
+        auto unpack_trans = [this](const uint16_t* in) { return unpackVec(in, trans_min, trans_step); };
+        auto unpack_scale = [this](const uint16_t* in) { return unpackVec(in, scale_min, scale_step); };
+
+        std::vector<glm::quat> rot(frame_count);
+        std::vector<glm::vec3> trans(frame_count);
+        std::vector<glm::vec3> scale(frame_count);
+        for (uint32_t bone = 0; bone < bone_count; ++bone)
+        {
+            for (uint32_t frame = 0; frame < frame_count; ++frame)
+            {
+                auto transform = getTransform(frame, bone);
+                rot[frame] = glm::normalize(transform.rot);
+                trans[frame] = transform.trans;
+                scale[frame] = transform.scale;
+            }
+            addChannel<Keys, Channel>(rot_keys, rot, reduce, packQuat, unpackQuat, nlerpQuat, within_rot);
+            addChannel<Keys, Channel>(trans_keys, trans, reduce, pack_trans, unpack_trans, lerpVec, within_trans);
+            addChannel<Keys, Channel>(scale_keys, scale, reduce, pack_scale, unpack_scale, lerpVec, within_scale);
+        }
+
+        streams = {};
+        compressed = true;
+        clip_bytes.fetch_add(static_cast<int64_t>(getMemorySize()) - static_cast<int64_t>(streams_size), std::memory_order_relaxed);
+    }
+
+    Animation::BoneTransform Animation::getTransform(uint32_t frame, uint32_t bone) const
+    {
+        if (compressed)
+            return decode(frame, bone);
+        return streams.get(static_cast<size_t>(frame) * bone_count + bone);
+    }
+
+    Animation::BoneTransform Animation::decode(uint32_t frame, uint32_t bone) const
+    {
+        auto unpack_trans = [this](const uint16_t* in) { return unpackVec(in, trans_min, trans_step); };
+        auto unpack_scale = [this](const uint16_t* in) { return unpackVec(in, scale_min, scale_step); };
+        return {
+            decodeChannel(rot_keys, bone, frame, unpackQuat, nlerpQuat),
+            decodeChannel(trans_keys, bone, frame, unpack_trans, lerpVec),
+            decodeChannel(scale_keys, bone, frame, unpack_scale, lerpVec)
+        };
+    }
+
+    void Animation::unpackFrame(uint32_t frame, Streams& out, size_t offset) const
+    {
+        for (uint32_t bone = 0; bone < bone_count; ++bone)
+        {
+            out.set(offset + bone, decode(frame, bone));
+        }
+    }
+
+    void Animation::sample(uint32_t frame, uint32_t next_frame, float t, Streams& out, const Streams* from, float fade) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (compressed)
+        {
+            //per-thread scratch, the size of the largest skeleton sampled on the thread
+            thread_local KeyRows rows;
+            if (rows.rot_t.size() < bone_count)
+                rows.resize(bone_count);
+            auto& keys = rows.keys;
+            if (next_frame == frame || next_frame == frame + 1)
+            {
+                //each channel's two keys around the pose are unpacked (the only scalar part), interpolated between several
+                //  bones at a time into the first row, which the kernel then only cross-fades
+                float frame_t = next_frame == frame ? 0.f : t;
+                size_t bones = rows.rot_t.size();
+                for (uint32_t bone = 0; bone < bone_count; ++bone)
+                {
+                    const uint16_t* key;
+                    const uint16_t* next_key;
+                    rows.rot_t[bone] = keySpan(rot_keys, bone, frame, frame_t, key, next_key);
+                    glm::quat rot = unpackQuat(key);
+                    glm::quat next_rot = unpackQuat(next_key);
+                    keys.rot_x[bone] = rot.x; keys.rot_y[bone] = rot.y; keys.rot_z[bone] = rot.z; keys.rot_w[bone] = rot.w;
+                    keys.rot_x[bones + bone] = next_rot.x; keys.rot_y[bones + bone] = next_rot.y; keys.rot_z[bones + bone] = next_rot.z; keys.rot_w[bones + bone] = next_rot.w;
+
+                    rows.trans_t[bone] = keySpan(trans_keys, bone, frame, frame_t, key, next_key);
+                    glm::vec3 trans = unpackVec(key, trans_min, trans_step);
+                    glm::vec3 next_trans = unpackVec(next_key, trans_min, trans_step);
+                    keys.trans_x[bone] = trans.x; keys.trans_y[bone] = trans.y; keys.trans_z[bone] = trans.z;
+                    keys.trans_x[bones + bone] = next_trans.x; keys.trans_y[bones + bone] = next_trans.y; keys.trans_z[bones + bone] = next_trans.z;
+
+                    rows.scale_t[bone] = keySpan(scale_keys, bone, frame, frame_t, key, next_key);
+                    glm::vec3 scale = unpackVec(key, scale_min, scale_step);
+                    glm::vec3 next_scale = unpackVec(next_key, scale_min, scale_step);
+                    keys.scale_x[bone] = scale.x; keys.scale_y[bone] = scale.y; keys.scale_z[bone] = scale.z;
+                    keys.scale_x[bones + bone] = next_scale.x; keys.scale_y[bones + bone] = next_scale.y; keys.scale_z[bones + bone] = next_scale.z;
+                }
+                lerpKeys(rows, bone_count);
+                sampleStreams(keys, 0, 0, 0.f, out, from, fade, bone_count);
+            }
+            else
+            {
+                //frames that aren't neighbours (looping back to the start) are unpacked into the two rows, then sampled as if uncompressed
+                unpackFrame(frame, keys, 0);
+                unpackFrame(next_frame, keys, rows.rot_t.size());
+                sampleStreams(keys, 0, rows.rot_t.size(), t, out, from, fade, bone_count);
+            }
+        }
+        else
+        {
+            sampleStreams(streams, static_cast<size_t>(frame) * bone_count, static_cast<size_t>(next_frame) * bone_count, t, out, from, fade, bone_count);
+        }
+        sampled_poses.fetch_add(1, std::memory_order_relaxed);
+        sampled_bones.fetch_add(bone_count, std::memory_order_relaxed);
+        sample_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+
+    Animation::Stats Animation::getStats()
+    {
+        Stats stats;
+        stats.clips = loaded_clips.load(std::memory_order_relaxed);
+        stats.memory_bytes = static_cast<uint64_t>(clip_bytes.load(std::memory_order_relaxed));
+        stats.uncompressed_bytes = clip_uncompressed_bytes.load(std::memory_order_relaxed);
+        stats.poses = sampled_poses.load(std::memory_order_relaxed);
+        stats.bones = sampled_bones.load(std::memory_order_relaxed);
+        stats.sample_time = std::chrono::nanoseconds(sample_nanoseconds.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+    size_t Animation::getMemorySize() const
+    {
+        size_t size = streams.size() * 10 * sizeof(float);
+        for (const auto* keys : { &rot_keys, &trans_keys, &scale_keys })
+        {
+            size += keys->channels.size() * sizeof(Channel) + (keys->frames.size() + keys->values.size()) * sizeof(uint16_t);
+        }
+        return size;
+    }
 }
@@ -4,8 +4,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <map>
 #include "engine/types.h"
+#include "bounds.h"
 
 namespace lotus
 {
@@ -21,13 +21,93 @@ namespace lotus
             glm::vec3 scale;
         };
 
-        Animation(Skeleton* skeleton);
+        //bone transforms split into one float stream per component, so they can be sampled several bones at a time
+        struct Streams
+        {
+            void resize(size_t size);
+            size_t size() const { return rot_x.size(); }
+            BoneTransform get(size_t i) const;
+            void set(size_t i, const BoneTransform& transform);
+
+            std::vector<float> rot_x, rot_y, rot_z, rot_w;
+            std::vector<float> trans_x, trans_y, trans_z;
+            std::vector<float> scale_x, scale_y, scale_z;
+        };
+
+        struct Stats
+        {
+            //clips currently loaded, with getMemorySize() and getUncompressedSize() summed over them
+            uint64_t clips{ 0 };
+            uint64_t memory_bytes{ 0 };
+            uint64_t uncompressed_bytes{ 0 };
+            //across every clip since startup
+            uint64_t poses{ 0 };
+            uint64_t bones{ 0 };
+            std::chrono::nanoseconds sample_time{ 0 };
+        };
+        static Stats getStats();
+
+        Animation(Skeleton* skeleton, uint32_t frame_count);
+        ~Animation();
+        Animation(const Animation&) = delete;
+        Animation& operator=(const Animation&) = delete;
         std::string name;
         Skeleton* skeleton;
         duration frame_duration;
 
+        //bones have to be added in skeleton order within a frame, so parents are already there
         void addFrameData(uint32_t frame, uint32_t bone, BoneTransform transform);
+        //once every frame is added: packs the clip into channels of quantized keys (see Channel), after which no more frames can be added
+        //keys that interpolating their (quantized) neighbours gets within rotation_tolerance (radians), translation_tolerance
+        //  (model space units) or scale_tolerance of are dropped; 0 for all three keeps every frame of a channel that isn't constant
+        //the keys that are kept are only off by their quantization (under 1e-4 radians, and half of 1/65535 of the clip's range)
+        void compress(float rotation_tolerance, float translation_tolerance, float scale_tolerance);
+
+        uint32_t getFrameCount() const { return frame_count; }
+        uint32_t getBoneCount() const { return bone_count; }
+        BoneTransform getTransform(uint32_t frame, uint32_t bone) const;
+        //every bone interpolated between two frames into out (a pose of getBoneCount() bones)
+        //with from set, the result is then cross-faded from that pose by fade (0 is all from)
+        //rotations use nlerp along the shortest path, with t adjusted to closely follow slerp
+        void sample(uint32_t frame, uint32_t next_frame, float t, Streams& out, const Streams* from = nullptr, float fade = 1.f) const;
+
+        //bytes held by the clip's transforms, and what they take up as one BoneTransform per bone per frame
+        size_t getMemorySize() const;
+        size_t getUncompressedSize() const { return static_cast<size_t>(frame_count) * bone_count * sizeof(BoneTransform); }
+
+        //model space extents of every bone position across all frames
+        AABB bounds;
+
+    private:
+        //one bone's rotation, translation or scale: key_count keys starting at first_key in that channel's Keys
+        //a constant channel only has the one key
+        struct Channel
+        {
+            uint32_t first_key{ 0 };
+            uint32_t key_count{ 0 };
+        };
+
+        //every bone's channel of one kind, with 3 16 bit values per key
+        //rotations are smallest-three (the largest component's index and the other three at 15 bits each),
+        //  translations and scales are quantized across the clip's range of them
+        struct Keys
+        {
+            std::vector<Channel> channels;
+            std::vector<uint16_t> frames;
+            std::vector<uint16_t> values;
+        };
+
+        void unpackFrame(uint32_t frame, Streams& out, size_t offset) const;
+        BoneTransform decode(uint32_t frame, uint32_t bone) const;
+
+        uint32_t frame_count;
+        uint32_t bone_count;
+        //laid out [frame][bone], so sampling a frame walks each stream linearly (empty once compressed)
+        Streams streams;
 
-        std::vector<std::map<uint32_t, BoneTransform>> transforms;
+        bool compressed{ false };
+        Keys rot_keys, trans_keys, scale_keys;
+        glm::vec3 trans_min{ 0 }, trans_step{ 0 };
+        glm::vec3 scale_min{ 0 }, scale_step{ 0 };
     };
 }
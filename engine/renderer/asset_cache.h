@@ -0,0 +1,305 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lotus
+{
+    //named assets (models, textures) shared by everything that loads them by name
+    //the cache holds a reference to every asset, so one nothing else is using any more stays warm (evictable) until it
+    //  ages out of the byte budget, least recently used first; loading it again by name just picks it back up
+    //loads come from any worker thread: lookups only lock the name's shard, and a name that's already being loaded
+    //  waits for that load instead of starting its own
+    //T needs a getMemorySize() const, which is what an evictable asset counts against the budget
+    template<typename T>
+    class AssetCache
+    {
+    public:
+        enum class State
+        {
+            //being loaded; nothing to hand out yet
+            Loading,
+            //in use by something besides the cache
+            Resident,
+            //only held by the cache
+            Evictable
+        };
+
+        struct Stats
+        {
+            size_t loading{ 0 };
+            size_t resident{ 0 };
+            size_t evictable{ 0 };
+            uint64_t evictable_bytes{ 0 };
+            uint64_t budget{ 0 };
+            //found resident, found evictable (a load that was saved by the cache), and not found
+            uint64_t hits{ 0 };
+            uint64_t warm_hits{ 0 };
+            uint64_t misses{ 0 };
+            //requests that waited on another thread's load of the same name instead of loading it again
+            uint64_t coalesced{ 0 };
+            uint64_t evictions{ 0 };
+        };
+
+        //the cached asset, or nothing if it isn't loaded (or is still loading)
+        std::shared_ptr<T> find(const std::string& name)
+        {
+            auto& shard = getShard(name);
+            std::lock_guard lk{ shard.mutex };
+            auto found = shard.entries.find(name);
+            if (found == shard.entries.end() || !found->second.asset)
+            {
+                ++misses;
+                return {};
+            }
+            return use(found->second);
+        }
+
+        //like find, but a name that's still being loaded waits for the load (nothing if it fails)
+        std::shared_ptr<T> findOrWait(const std::string& name)
+        {
+            auto& shard = getShard(name);
+            std::unique_lock lk{ shard.mutex };
+            auto found = shard.entries.find(name);
+            if (found == shard.entries.end())
+            {
+                ++misses;
+                return {};
+            }
+            if (found->second.asset)
+                return use(found->second);
+            auto pending = found->second.pending;
+            lk.unlock();
+            ++coalesced;
+            try
+            {
+                return pending.get();
+            }
+            catch (...)
+            {
+                return {};
+            }
+        }
+
+        //the cached asset, or the result of load() (which only one thread runs per name at a time)
+        template<typename Load>
+        std::shared_ptr<T> findOrLoad(const std::string& name, Load load)
+        {
+            auto& shard = getShard(name);
+            std::unique_lock lk{ shard.mutex };
+            auto [found, inserted] = shard.entries.try_emplace(name);
+            auto& entry = found->second;
+            if (!inserted)
+            {
+                if (entry.asset)
+                    return use(entry);
+                auto pending = entry.pending;
+                lk.unlock();
+                ++coalesced;
+                //rethrows if the load it's waiting on failed
+                return pending.get();
+            }
+            ++misses;
+            std::promise<std::shared_ptr<T>> promise;
+            entry.pending = promise.get_future().share();
+            lk.unlock();
+
+            std::shared_ptr<T> asset;
+            try
+            {
+                asset = load();
+            }
+            catch (...)
+            {
+                lk.lock();
+                shard.entries.erase(name);
+                lk.unlock();
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+
+            lk.lock();
+            //entries are only ever erased by prune, which leaves loading ones alone
+            auto& loaded = shard.entries.at(name);
+            loaded.asset = asset;
+            loaded.state = State::Resident;
+            loaded.pending = {};
+            lk.unlock();
+            promise.set_value(asset);
+            return asset;
+        }
+
+        //moves assets nothing else references any more to the evictable list, and evicts the oldest ones while over budget
+        //whoever calls this has to know the evicted assets aren't in use by the GPU (nothing can be referencing them on the CPU)
+        void prune()
+        {
+            //every shard at once, since an asset can be cached under more than one name (in different shards)
+            std::array<std::unique_lock<std::mutex>, shard_count> locks;
+            for (size_t i = 0; i < shard_count; ++i)
+            {
+                locks[i] = std::unique_lock{ shards[i].mutex };
+            }
+            std::lock_guard lru_lk{ lru_mutex };
+
+            //an asset is unused when the cache holds every reference to it
+            std::unordered_map<T*, long> cache_references;
+            for (const auto& shard : shards)
+            {
+                for (const auto& [name, entry] : shard.entries)
+                {
+                    if (entry.asset)
+                        ++cache_references[entry.asset.get()];
+                }
+            }
+            for (auto& shard : shards)
+            {
+                for (auto& [name, entry] : shard.entries)
+                {
+                    if (entry.state == State::Resident && entry.asset.use_count() <= cache_references[entry.asset.get()])
+                    {
+                        entry.state = State::Evictable;
+                        entry.bytes = entry.asset->getMemorySize();
+                        entry.lru = lru.insert(lru.end(), name);
+                        evictable_bytes += entry.bytes;
+                    }
+                }
+            }
+            while (evictable_bytes > budget && !lru.empty())
+            {
+                auto& shard = getShard(lru.front());
+                auto found = shard.entries.find(lru.front());
+                evictable_bytes -= found->second.bytes;
+                lru.pop_front();
+                shard.entries.erase(found);
+                ++evictions;
+            }
+        }
+
+        //drops every reference the cache holds, before the renderer goes away
+        void clear()
+        {
+            for (auto& shard : shards)
+            {
+                std::lock_guard lk{ shard.mutex };
+                std::erase_if(shard.entries, [](const auto& entry) { return entry.second.asset != nullptr; });
+            }
+            std::lock_guard lru_lk{ lru_mutex };
+            lru.clear();
+            evictable_bytes = 0;
+        }
+
+        void setBudget(uint64_t bytes)
+        {
+            std::lock_guard lru_lk{ lru_mutex };
+            budget = bytes;
+        }
+
+        //every cached asset, including evictable ones
+        template<typename F>
+        void forEach(F func)
+        {
+            for (auto& shard : shards)
+            {
+                std::lock_guard lk{ shard.mutex };
+                for (const auto& [name, entry] : shard.entries)
+                {
+                    if (entry.asset)
+                        func(entry.asset);
+                }
+            }
+        }
+
+        Stats getStats() const
+        {
+            Stats stats;
+            for (const auto& shard : shards)
+            {
+                std::lock_guard lk{ shard.mutex };
+                for (const auto& [name, entry] : shard.entries)
+                {
+                    if (!entry.asset)
+                        ++stats.loading;
+                    else if (entry.state == State::Resident)
+                        ++stats.resident;
+                    else
+                        ++stats.evictable;
+                }
+            }
+            {
+                std::lock_guard lru_lk{ lru_mutex };
+                stats.evictable_bytes = evictable_bytes;
+                stats.budget = budget;
+            }
+            stats.hits = hits;
+            stats.warm_hits = warm_hits;
+            stats.misses = misses;
+            stats.coalesced = coalesced;
+            stats.evictions = evictions;
+            return stats;
+        }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<T> asset;
+            State state{ State::Loading };
+            //set while loading, for anyone else asking for the same name
+            std::shared_future<std::shared_ptr<T>> pending;
+            //counted against the budget while evictable
+            uint64_t bytes{ 0 };
+            std::list<std::string>::iterator lru;
+        };
+
+        struct Shard
+        {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string, Entry> entries;
+        };
+
+        static constexpr size_t shard_count{ 16 };
+
+        Shard& getShard(const std::string& name)
+        {
+            return shards[std::hash<std::string>{}(name) % shard_count];
+        }
+
+        //entry's shard is locked
+        std::shared_ptr<T> use(Entry& entry)
+        {
+            if (entry.state == State::Evictable)
+            {
+                std::lock_guard lru_lk{ lru_mutex };
+                lru.erase(entry.lru);
+                evictable_bytes -= entry.bytes;
+                entry.state = State::Resident;
+                ++warm_hits;
+            }
+            else
+            {
+                ++hits;
+            }
+            return entry.asset;
+        }
+
+        std::array<Shard, shard_count> shards;
+        //always taken after a shard's mutex (prune takes all of them first)
+        mutable std::mutex lru_mutex;
+        //evictable entries, least recently used first
+        std::list<std::string> lru;
+        uint64_t evictable_bytes{ 0 };
+        uint64_t budget{ 0 };
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> warm_hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+        std::atomic<uint64_t> coalesced{ 0 };
+        std::atomic<uint64_t> evictions{ 0 };
+    };
+}
@@ -0,0 +1,453 @@
+#include "block_compression.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <glm/glm.hpp>
+
+namespace lotus
+{
+    namespace
+    {
+        glm::ivec3 expand565(uint16_t color)
+        {
+            int r = (color >> 11) & 0x1F;
+            int g = (color >> 5) & 0x3F;
+            int b = color & 0x1F;
+            return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+        }
+
+        uint16_t pack565(glm::vec3 color)
+        {
+            color = glm::clamp(color, glm::vec3{ 0.f }, glm::vec3{ 255.f });
+            auto r = static_cast<uint16_t>(color.r * 31.f / 255.f + 0.5f);
+            auto g = static_cast<uint16_t>(color.g * 63.f / 255.f + 0.5f);
+            auto b = static_cast<uint16_t>(color.b * 31.f / 255.f + 0.5f);
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void getPalette(uint16_t c0, uint16_t c1, glm::ivec3 palette[4])
+        {
+            palette[0] = expand565(c0);
+            palette[1] = expand565(c1);
+            palette[2] = (palette[0] * 2 + palette[1]) / 3;
+            palette[3] = (palette[0] + palette[1] * 2) / 3;
+        }
+
+        //4 colour mode palette order is c0, c1, 2/3 c0, 1/3 c0
+        constexpr uint32_t palette_order[4] = { 0, 2, 3, 1 };
+
+        uint32_t getNearestIndices(const glm::vec3 colors[16], const glm::ivec3 palette[4], int* error)
+        {
+            uint32_t indices = 0;
+            int total = 0;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                glm::ivec3 color{ colors[i] };
+                uint32_t best = 0;
+                int best_distance = std::numeric_limits<int>::max();
+                for (uint32_t p = 0; p < 4; ++p)
+                {
+                    glm::ivec3 d = color - palette[p];
+                    int distance = d.r * d.r + d.g * d.g + d.b * d.b;
+                    if (distance < best_distance)
+                    {
+                        best = p;
+                        best_distance = distance;
+                    }
+                }
+                indices |= best << (i * 2);
+                total += best_distance;
+            }
+            if (error)
+                *error = total;
+            return indices;
+        }
+
+        //given the indices, solve for the endpoints that minimise squared error (each pixel is a*c0 + b*c1)
+        bool refineEndpoints(const glm::vec3 colors[16], uint32_t indices, glm::vec3& e0, glm::vec3& e1)
+        {
+            constexpr float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+            float aa = 0.f, ab = 0.f, bb = 0.f;
+            glm::vec3 ax{ 0.f }, bx{ 0.f };
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                float a = weights[(indices >> (i * 2)) & 0x3];
+                float b = 1.f - a;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                ax += a * colors[i];
+                bx += b * colors[i];
+            }
+            float det = aa * bb - ab * ab;
+            if (std::abs(det) < 1e-6f)
+                return false;
+            e0 = (ax * bb - bx * ab) / det;
+            e1 = (bx * aa - ax * ab) / det;
+            return true;
+        }
+
+        void writeColorBlock(uint8_t* block, uint16_t c0, uint16_t c1, uint32_t indices)
+        {
+            block[0] = c0 & 0xFF;
+            block[1] = c0 >> 8;
+            block[2] = c1 & 0xFF;
+            block[3] = c1 >> 8;
+            block[4] = indices & 0xFF;
+            block[5] = (indices >> 8) & 0xFF;
+            block[6] = (indices >> 16) & 0xFF;
+            block[7] = indices >> 24;
+        }
+
+        //c0 > c1 keeps the block in 4 colour mode; swapping endpoints swaps index pairs 0/1 and 2/3
+        void orderEndpoints(uint16_t& c0, uint16_t& c1, uint32_t& indices)
+        {
+            if (c0 < c1)
+            {
+                std::swap(c0, c1);
+                indices ^= 0x55555555;
+            }
+        }
+    }
+
+    bool BlockCompression::isSupported(vk::Format format)
+    {
+        switch (format)
+        {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+        case vk::Format::eBc2UnormBlock:
+        case vk::Format::eBc3UnormBlock:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint32_t BlockCompression::getBlockSize(vk::Format format)
+    {
+        return format == vk::Format::eBc1RgbUnormBlock || format == vk::Format::eBc1RgbaUnormBlock ? 8 : 16;
+    }
+
+    void BlockCompression::decodeColorBlock(const uint8_t* block, uint8_t* rgba, bool bc1)
+    {
+        uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+        glm::ivec3 palette[4];
+        getPalette(c0, c1, palette);
+        bool three_color = bc1 && c0 <= c1;
+        if (three_color)
+        {
+            palette[2] = (palette[0] + palette[1]) / 2;
+            palette[3] = glm::ivec3{ 0 };
+        }
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t index = (indices >> (i * 2)) & 0x3;
+            const auto& color = palette[index];
+            rgba[i * 4] = static_cast<uint8_t>(color.r);
+            rgba[i * 4 + 1] = static_cast<uint8_t>(color.g);
+            rgba[i * 4 + 2] = static_cast<uint8_t>(color.b);
+            if (bc1)
+                rgba[i * 4 + 3] = three_color && index == 3 ? 0 : 255;
+        }
+    }
+
+    void BlockCompression::encodeColorBlock(const uint8_t* rgba, uint8_t* block, Quality quality)
+    {
+        glm::vec3 colors[16];
+        glm::vec3 mean{ 0.f };
+        glm::vec3 min{ 255.f };
+        glm::vec3 max{ 0.f };
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            colors[i] = glm::vec3(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+            mean += colors[i];
+            min = glm::min(min, colors[i]);
+            max = glm::max(max, colors[i]);
+        }
+        mean /= 16.f;
+
+        if (quality == Quality::Fast)
+        {
+            //bounding box diagonal, flipped on green/blue to follow the sign of their covariance with red (or with green, if red is flat)
+            float cov_rg = 0.f, cov_rb = 0.f, cov_gb = 0.f;
+            for (const auto& color : colors)
+            {
+                glm::vec3 d = color - mean;
+                cov_rg += d.r * d.g;
+                cov_rb += d.r * d.b;
+                cov_gb += d.g * d.b;
+            }
+            if (cov_rg < 0.f)
+                std::swap(min.g, max.g);
+            if (cov_rb < 0.f || (cov_rb == 0.f && cov_gb < 0.f))
+                std::swap(min.b, max.b);
+
+            glm::vec3 inset = (max - min) / 16.f;
+            uint16_t c0 = pack565(max - inset);
+            uint16_t c1 = pack565(min + inset);
+            if (c0 == c1)
+            {
+                writeColorBlock(block, c0, c1, 0);
+                return;
+            }
+
+            //project onto the endpoint axis rather than searching the palette
+            glm::ivec3 palette[4];
+            getPalette(c0, c1, palette);
+            glm::vec3 p0{ palette[0] };
+            glm::vec3 axis = glm::vec3{ palette[1] } - p0;
+            float scale = 3.f / glm::dot(axis, axis);
+            uint32_t indices = 0;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                float t = glm::clamp(glm::dot(colors[i] - p0, axis) * scale, 0.f, 3.f);
+                indices |= palette_order[static_cast<uint32_t>(t + 0.5f)] << (i * 2);
+            }
+            orderEndpoints(c0, c1, indices);
+            writeColorBlock(block, c0, c1, indices);
+            return;
+        }
+
+        //endpoints lie along the principal axis of the block's colours
+        float cov[6]{};
+        for (const auto& color : colors)
+        {
+            glm::vec3 d = color - mean;
+            cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+            cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+        }
+        glm::vec3 axis{ 1.f, 1.f, 1.f };
+        for (int i = 0; i < 8; ++i)
+        {
+            glm::vec3 next{
+                cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b
+            };
+            float length = glm::length(next);
+            if (length < 1e-6f)
+                break;
+            axis = next / length;
+        }
+
+        float min_t = std::numeric_limits<float>::max();
+        float max_t = std::numeric_limits<float>::lowest();
+        for (const auto& color : colors)
+        {
+            float t = glm::dot(color - mean, axis);
+            min_t = std::min(min_t, t);
+            max_t = std::max(max_t, t);
+        }
+        //inset the endpoints slightly, the extremes are usually better served by the interpolated colours
+        float inset = (max_t - min_t) / 32.f;
+        uint16_t c0 = pack565(mean + axis * (max_t - inset));
+        uint16_t c1 = pack565(mean + axis * (min_t + inset));
+        if (c0 == c1)
+        {
+            writeColorBlock(block, c0, c1, 0);
+            return;
+        }
+
+        glm::ivec3 palette[4];
+        getPalette(c0, c1, palette);
+        int error = 0;
+        uint32_t indices = getNearestIndices(colors, palette, &error);
+
+        //a couple of least squares passes, kept only while they reduce the error
+        for (int pass = 0; pass < 2 && error > 0; ++pass)
+        {
+            glm::vec3 e0, e1;
+            if (!refineEndpoints(colors, indices, e0, e1))
+                break;
+            uint16_t r0 = pack565(e0);
+            uint16_t r1 = pack565(e1);
+            if (r0 == r1 || (r0 == c0 && r1 == c1))
+                break;
+            getPalette(r0, r1, palette);
+            int refined_error = 0;
+            uint32_t refined_indices = getNearestIndices(colors, palette, &refined_error);
+            if (refined_error >= error)
+                break;
+            c0 = r0;
+            c1 = r1;
+            indices = refined_indices;
+            error = refined_error;
+        }
+
+        orderEndpoints(c0, c1, indices);
+        writeColorBlock(block, c0, c1, indices);
+    }
+
+    void BlockCompression::decodeBC3AlphaBlock(const uint8_t* block, uint8_t* rgba)
+    {
+        uint32_t a0 = block[0];
+        uint32_t a1 = block[1];
+        uint8_t palette[8] = { static_cast<uint8_t>(a0), static_cast<uint8_t>(a1) };
+        if (a0 > a1)
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+                palette[i] = static_cast<uint8_t>(((8 - i) * a0 + (i - 1) * a1) / 7);
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+                palette[i] = static_cast<uint8_t>(((6 - i) * a0 + (i - 1) * a1) / 5);
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 6; ++i)
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        for (uint32_t i = 0; i < 16; ++i)
+            rgba[i * 4 + 3] = palette[(indices >> (i * 3)) & 0x7];
+    }
+
+    void BlockCompression::encodeBC3AlphaBlock(const uint8_t* rgba, uint8_t* block)
+    {
+        uint8_t min = 255;
+        uint8_t max = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            min = std::min(min, rgba[i * 4 + 3]);
+            max = std::max(max, rgba[i * 4 + 3]);
+        }
+
+        //always the 8 level mode (a0 > a1); punch-through 0/255 alpha is still exact with those as the endpoints
+        block[0] = max;
+        block[1] = min;
+        uint64_t indices = 0;
+        if (max != min)
+        {
+            uint8_t palette[8] = { max, min };
+            for (uint32_t i = 2; i < 8; ++i)
+                palette[i] = static_cast<uint8_t>(((8 - i) * max + (i - 1) * min) / 7);
+
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                int alpha = rgba[i * 4 + 3];
+                uint64_t best = 0;
+                int best_distance = std::numeric_limits<int>::max();
+                for (uint32_t p = 0; p < 8; ++p)
+                {
+                    int distance = std::abs(alpha - palette[p]);
+                    if (distance < best_distance)
+                    {
+                        best = p;
+                        best_distance = distance;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+        for (uint32_t i = 0; i < 6; ++i)
+            block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    void BlockCompression::decodeBlock(vk::Format format, const uint8_t* block, uint8_t* rgba)
+    {
+        switch (format)
+        {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+            decodeColorBlock(block, rgba, true);
+            break;
+        case vk::Format::eBc2UnormBlock:
+            decodeColorBlock(block + 8, rgba, false);
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint8_t alpha = (block[i / 2] >> ((i % 2) * 4)) & 0xF;
+                rgba[i * 4 + 3] = alpha * 17;
+            }
+            break;
+        case vk::Format::eBc3UnormBlock:
+            decodeColorBlock(block + 8, rgba, false);
+            decodeBC3AlphaBlock(block, rgba);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void BlockCompression::encodeBlock(vk::Format format, const uint8_t* rgba, uint8_t* block, Quality quality)
+    {
+        switch (format)
+        {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+            //the 4 colour mode only - callers choose BC1 for textures without meaningful alpha
+            encodeColorBlock(rgba, block, quality);
+            break;
+        case vk::Format::eBc2UnormBlock:
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                uint8_t a0 = static_cast<uint8_t>((rgba[i * 8 + 3] * 15 + 127) / 255);
+                uint8_t a1 = static_cast<uint8_t>((rgba[i * 8 + 7] * 15 + 127) / 255);
+                block[i] = a0 | (a1 << 4);
+            }
+            encodeColorBlock(rgba, block + 8, quality);
+            break;
+        case vk::Format::eBc3UnormBlock:
+            encodeBC3AlphaBlock(rgba, block);
+            encodeColorBlock(rgba, block + 8, quality);
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::vector<uint8_t> BlockCompression::decode(vk::Format format, const uint8_t* data, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        uint32_t blocks_x = getBlockCount(width);
+        uint32_t blocks_y = getBlockCount(height);
+        uint32_t block_size = getBlockSize(format);
+        uint8_t block_rgba[64];
+
+        for (uint32_t by = 0; by < blocks_y; ++by)
+        {
+            for (uint32_t bx = 0; bx < blocks_x; ++bx)
+            {
+                decodeBlock(format, data + (static_cast<size_t>(by) * blocks_x + bx) * block_size, block_rgba);
+                for (uint32_t y = 0; y < block_dimension && by * block_dimension + y < height; ++y)
+                {
+                    uint32_t row_pixels = std::min(block_dimension, width - bx * block_dimension);
+                    memcpy(rgba.data() + ((static_cast<size_t>(by) * block_dimension + y) * width + bx * block_dimension) * 4, block_rgba + y * 16, row_pixels * 4);
+                }
+            }
+        }
+        return rgba;
+    }
+
+    std::vector<uint8_t> BlockCompression::encode(vk::Format format, const uint8_t* rgba, uint32_t width, uint32_t height, Quality quality)
+    {
+        uint32_t blocks_x = getBlockCount(width);
+        uint32_t blocks_y = getBlockCount(height);
+        uint32_t block_size = getBlockSize(format);
+        std::vector<uint8_t> data(static_cast<size_t>(blocks_x) * blocks_y * block_size);
+        uint8_t block_rgba[64];
+
+        for (uint32_t by = 0; by < blocks_y; ++by)
+        {
+            for (uint32_t bx = 0; bx < blocks_x; ++bx)
+            {
+                for (uint32_t y = 0; y < block_dimension; ++y)
+                {
+                    uint32_t sy = std::min(by * block_dimension + y, height - 1);
+                    for (uint32_t x = 0; x < block_dimension; ++x)
+                    {
+                        uint32_t sx = std::min(bx * block_dimension + x, width - 1);
+                        memcpy(block_rgba + (y * block_dimension + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                    }
+                }
+                encodeBlock(format, block_rgba, data.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_size, quality);
+            }
+        }
+        return data;
+    }
+}
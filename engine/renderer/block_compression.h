@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+
+namespace lotus
+{
+    //CPU encode/decode of BCn blocks, for textures the engine has to compress or rewrite after load (ie. when generating mips)
+    class BlockCompression
+    {
+    public:
+        enum class Quality
+        {
+            //bounding box endpoints, indices by projection
+            Fast,
+            //principal axis endpoints refined by least squares, indices by nearest colour
+            High
+        };
+
+        static constexpr uint32_t block_dimension = 4;
+        static uint32_t getBlockCount(uint32_t dimension) { return (dimension + block_dimension - 1) / block_dimension; }
+        static bool isSupported(vk::Format format);
+
+        //blocks are 8 (BC1) or 16 (BC2/BC3) bytes, rgba is 4x4 RGBA8 pixels (64 bytes) in row order
+        static void decodeBlock(vk::Format format, const uint8_t* block, uint8_t* rgba);
+        static void encodeBlock(vk::Format format, const uint8_t* rgba, uint8_t* block, Quality quality);
+
+        //whole images; partial blocks on the right/bottom edges are padded by clamping
+        static std::vector<uint8_t> decode(vk::Format format, const uint8_t* data, uint32_t width, uint32_t height);
+        static std::vector<uint8_t> encode(vk::Format format, const uint8_t* rgba, uint32_t width, uint32_t height, Quality quality);
+
+    private:
+        //8 byte BC1 style colour block; 4 colour mode unless the BC1 block has transparent pixels
+        static void decodeColorBlock(const uint8_t* block, uint8_t* rgba, bool bc1);
+        static void encodeColorBlock(const uint8_t* rgba, uint8_t* block, Quality quality);
+        static void decodeBC3AlphaBlock(const uint8_t* block, uint8_t* rgba);
+        static void encodeBC3AlphaBlock(const uint8_t* rgba, uint8_t* block);
+        static uint32_t getBlockSize(vk::Format format);
+    };
+}
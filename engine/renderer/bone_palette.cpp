@@ -0,0 +1,79 @@
+#include "bone_palette.h"
+#include <algorithm>
+#include <bit>
+#include "engine/core.h"
+
+namespace lotus
+{
+    //a few thousand bones per frame before a region has to grow
+    constexpr vk::DeviceSize initial_capacity{ 256 * 1024 };
+
+    BonePalette::BonePalette(Engine* _engine, uint32_t frames_in_flight) : engine(_engine), frames(frames_in_flight)
+    {
+        for (auto& frame : frames)
+        {
+            createRegion(frame, initial_capacity);
+        }
+        stats.capacity = initial_capacity;
+    }
+
+    BonePalette::~BonePalette()
+    {
+        for (auto& frame : frames)
+        {
+            frame.buffer->unmap();
+        }
+    }
+
+    void BonePalette::createRegion(Frame& frame, vk::DeviceSize capacity)
+    {
+        if (frame.buffer)
+            frame.buffer->unmap();
+        frame.buffer = engine->renderer.memory_manager->GetBuffer(capacity, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+        frame.data = static_cast<uint8_t*>(frame.buffer->map(0, capacity, {}));
+        frame.capacity = capacity;
+    }
+
+    BonePalette::Allocation BonePalette::allocate(vk::DeviceSize size)
+    {
+        auto& frame = frames[engine->renderer.getCurrentFrame()];
+        vk::DeviceSize aligned_size = engine->renderer.storage_buffer_align_up(size);
+        vk::DeviceSize offset = frame.head.fetch_add(aligned_size);
+        if (offset + aligned_size <= frame.capacity)
+        {
+            return { frame.buffer->buffer, offset, size, frame.data + offset };
+        }
+
+        //the region is grown when this frame retires; until then, the overflow gets a buffer of its own
+        auto buffer = engine->renderer.memory_manager->GetBuffer(size, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+        Allocation allocation{ buffer->buffer, 0, size, buffer->map(0, size, {}) };
+        std::lock_guard lk{ mutex };
+        frame.overflow.push_back(std::move(buffer));
+        ++stats.overflow_allocations;
+        return allocation;
+    }
+
+    void BonePalette::retire(uint32_t frame_index)
+    {
+        auto& frame = frames[frame_index];
+        vk::DeviceSize used = frame.head.exchange(0);
+        if (used > frame.capacity)
+        {
+            createRegion(frame, std::bit_ceil(used));
+        }
+        std::lock_guard lk{ mutex };
+        for (auto& buffer : frame.overflow)
+        {
+            buffer->unmap();
+        }
+        frame.overflow.clear();
+        stats.frame_bytes = used;
+        stats.capacity = std::max(stats.capacity, frame.capacity);
+    }
+
+    BonePalette::Stats BonePalette::getStats() const
+    {
+        std::lock_guard lk{ mutex };
+        return stats;
+    }
+}
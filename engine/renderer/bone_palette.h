@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+#include "memory.h"
+
+namespace lotus
+{
+    class Engine;
+
+    //bone transforms for every skinned entity, written by the CPU straight into persistently mapped memory
+    //each frame in flight has its own region, bump allocated while the frame is recorded and reset once its fence has been waited on
+    class BonePalette
+    {
+    public:
+        struct Allocation
+        {
+            vk::Buffer buffer;
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            void* data;
+        };
+
+        struct Stats
+        {
+            //bytes handed out by the last retired frame
+            vk::DeviceSize frame_bytes{ 0 };
+            //per frame region
+            vk::DeviceSize capacity{ 0 };
+            //allocations that didn't fit their frame's region and got a buffer of their own
+            uint64_t overflow_allocations{ 0 };
+        };
+
+        BonePalette(Engine* engine, uint32_t frames_in_flight);
+        ~BonePalette();
+
+        //from the current frame's region; only valid until that frame retires, so it has to be called while the frame is recorded
+        Allocation allocate(vk::DeviceSize size);
+        //frame's fence has been waited on: its region is reused, and grown if it overflowed
+        void retire(uint32_t frame);
+        Stats getStats() const;
+
+    private:
+        struct Frame
+        {
+            std::unique_ptr<Buffer> buffer;
+            uint8_t* data{ nullptr };
+            vk::DeviceSize capacity{ 0 };
+            std::atomic<vk::DeviceSize> head{ 0 };
+            std::vector<std::unique_ptr<Buffer>> overflow;
+        };
+
+        void createRegion(Frame& frame, vk::DeviceSize capacity);
+
+        Engine* engine;
+        std::vector<Frame> frames;
+        //guards overflow and stats
+        mutable std::mutex mutex;
+        Stats stats;
+    };
+}
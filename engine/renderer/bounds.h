@@ -0,0 +1,65 @@
+#pragma once
+
+#include <limits>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace lotus
+{
+    struct AABB
+    {
+        glm::vec3 min{ std::numeric_limits<float>::max() };
+        glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+        void extend(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void extend(const AABB& other)
+        {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+        //transforms the 8 corners implicitly (Arvo) and returns the box around them
+        AABB transform(const glm::mat4& matrix) const
+        {
+            if (!valid())
+                return *this;
+            glm::vec3 new_center = glm::vec3(matrix * glm::vec4(center(), 1.f));
+            glm::vec3 old_extents = extents();
+            glm::vec3 new_extents{ 0.f };
+            for (int i = 0; i < 3; ++i)
+            {
+                new_extents += glm::abs(glm::vec3(matrix[i])) * old_extents[i];
+            }
+            return { new_center - new_extents, new_center + new_extents };
+        }
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center{ 0.f };
+        float radius{ 0.f };
+
+        static BoundingSphere fromAABB(const AABB& aabb)
+        {
+            if (!aabb.valid())
+                return {};
+            return { aabb.center(), glm::length(aabb.extents()) };
+        }
+
+        //radius is scaled by the largest axis scale so non-uniform scales stay conservative
+        BoundingSphere transform(const glm::mat4& matrix) const
+        {
+            float scale = std::max({ glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])) });
+            return { glm::vec3(matrix * glm::vec4(center, 1.f)), radius * scale };
+        }
+    };
+}
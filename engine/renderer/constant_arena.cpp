@@ -0,0 +1,130 @@
+#include "constant_arena.h"
+#include <cstring>
+#include "engine/core.h"
+
+namespace lotus
+{
+    ConstantArena::Slot::Slot(ConstantArena* _arena, uint32_t _index, vk::Buffer _buffer, uint8_t* _page_data) :
+        arena(_arena), index(_index), buffer(_buffer), page_data(_page_data)
+    {
+    }
+
+    ConstantArena::Slot::Slot(Slot&& o) noexcept : arena(o.arena), index(o.index), buffer(o.buffer), page_data(o.page_data)
+    {
+        o.arena = nullptr;
+    }
+
+    ConstantArena::Slot& ConstantArena::Slot::operator=(Slot&& o) noexcept
+    {
+        if (this != &o)
+        {
+            if (arena)
+                arena->release(index);
+            arena = o.arena;
+            index = o.index;
+            buffer = o.buffer;
+            page_data = o.page_data;
+            o.arena = nullptr;
+        }
+        return *this;
+    }
+
+    ConstantArena::Slot::~Slot()
+    {
+        if (arena)
+            arena->release(index);
+    }
+
+    vk::Buffer ConstantArena::Slot::getBuffer() const
+    {
+        return buffer;
+    }
+
+    vk::DeviceSize ConstantArena::Slot::getModelOffset(uint32_t frame) const
+    {
+        return arena->getOffset(index, frame);
+    }
+
+    vk::DeviceSize ConstantArena::Slot::getMeshIndexOffset(uint32_t frame) const
+    {
+        return arena->getOffset(index, frame) + arena->model_stride;
+    }
+
+    uint8_t* ConstantArena::Slot::getModel(uint32_t frame) const
+    {
+        return page_data + getModelOffset(frame);
+    }
+
+    uint32_t* ConstantArena::Slot::getMeshIndex(uint32_t frame) const
+    {
+        return reinterpret_cast<uint32_t*>(page_data + getMeshIndexOffset(frame));
+    }
+
+    ConstantArena::ConstantArena(Engine* _engine, uint32_t _frames_in_flight, vk::DeviceSize model_size) : engine(_engine), frames_in_flight(_frames_in_flight)
+    {
+        model_stride = engine->renderer.uniform_buffer_align_up(model_size);
+        stride = model_stride + engine->renderer.uniform_buffer_align_up(sizeof(uint32_t));
+    }
+
+    ConstantArena::~ConstantArena()
+    {
+        for (auto& page : pages)
+        {
+            page.buffer->unmap();
+        }
+    }
+
+    ConstantArena::Slot ConstantArena::allocate()
+    {
+        std::lock_guard lk{ mutex };
+        uint32_t index;
+        if (!free_slots.empty())
+        {
+            //entities are only destroyed once nothing in flight references them, so a released slot can be handed out straight away
+            index = free_slots.back();
+            free_slots.pop_back();
+        }
+        else
+        {
+            index = next_slot++;
+            if (index / slots_per_page >= pages.size())
+            {
+                vk::DeviceSize page_size = stride * slots_per_page * frames_in_flight;
+                Page page;
+                page.buffer = engine->renderer.memory_manager->GetBuffer(page_size, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+                page.data = static_cast<uint8_t*>(page.buffer->map(0, page_size, {}));
+                pages.push_back(std::move(page));
+            }
+        }
+        ++used_slots;
+
+        const auto& page = pages[index / slots_per_page];
+        for (uint32_t frame = 0; frame < frames_in_flight; ++frame)
+        {
+            memset(page.data + getOffset(index, frame), 0, stride);
+        }
+        return Slot{ this, index, page.buffer->buffer, page.data };
+    }
+
+    void ConstantArena::release(uint32_t index)
+    {
+        std::lock_guard lk{ mutex };
+        free_slots.push_back(index);
+        --used_slots;
+    }
+
+    vk::DeviceSize ConstantArena::getOffset(uint32_t index, uint32_t frame) const
+    {
+        return (static_cast<vk::DeviceSize>(frame) * slots_per_page + index % slots_per_page) * stride;
+    }
+
+    ConstantArena::Stats ConstantArena::getStats() const
+    {
+        std::lock_guard lk{ mutex };
+        Stats stats;
+        stats.slots = used_slots;
+        stats.pages = static_cast<uint32_t>(pages.size());
+        stats.bytes = stride * slots_per_page * frames_in_flight * pages.size();
+        return stats;
+    }
+}
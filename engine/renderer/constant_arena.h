@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+#include "memory.h"
+
+namespace lotus
+{
+    class Engine;
+
+    //per-frame object constants (model matrices and mesh index) for every renderable entity, in persistently mapped pages
+    //an entity keeps its slot for its whole lifetime, so command buffers recorded once can keep pushing the same buffer and offsets
+    class ConstantArena
+    {
+    public:
+        struct Stats
+        {
+            uint32_t slots{ 0 };
+            uint32_t pages{ 0 };
+            vk::DeviceSize bytes{ 0 };
+        };
+
+        //handed back to the arena when destroyed
+        class Slot
+        {
+        public:
+            Slot() = default;
+            Slot(Slot&& o) noexcept;
+            Slot& operator=(Slot&& o) noexcept;
+            ~Slot();
+
+            explicit operator bool() const { return arena != nullptr; }
+
+            vk::Buffer getBuffer() const;
+            vk::DeviceSize getModelOffset(uint32_t frame) const;
+            vk::DeviceSize getMeshIndexOffset(uint32_t frame) const;
+            uint8_t* getModel(uint32_t frame) const;
+            uint32_t* getMeshIndex(uint32_t frame) const;
+
+        private:
+            friend class ConstantArena;
+            Slot(ConstantArena* arena, uint32_t index, vk::Buffer buffer, uint8_t* page_data);
+
+            ConstantArena* arena{ nullptr };
+            uint32_t index{ 0 };
+            //copied out of the page so lookups don't need the arena's lock
+            vk::Buffer buffer;
+            uint8_t* page_data{ nullptr };
+        };
+
+        ConstantArena(Engine* engine, uint32_t frames_in_flight, vk::DeviceSize model_size);
+        ~ConstantArena();
+
+        Slot allocate();
+        Stats getStats() const;
+
+        static constexpr uint32_t slots_per_page{ 1024 };
+
+    private:
+        struct Page
+        {
+            std::unique_ptr<Buffer> buffer;
+            uint8_t* data{ nullptr };
+        };
+
+        void release(uint32_t index);
+        //offset of a slot's model constants for a frame, within its page
+        vk::DeviceSize getOffset(uint32_t index, uint32_t frame) const;
+
+        Engine* engine;
+        uint32_t frames_in_flight;
+        //model constants first, then the mesh index, each aligned for a uniform buffer binding
+        vk::DeviceSize model_stride{ 0 };
+        vk::DeviceSize stride{ 0 };
+
+        mutable std::mutex mutex;
+        //pages are only ever added, since recorded command buffers point into them
+        std::vector<Page> pages;
+        std::vector<uint32_t> free_slots;
+        uint32_t next_slot{ 0 };
+        uint32_t used_slots{ 0 };
+    };
+}
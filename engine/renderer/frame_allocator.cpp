@@ -0,0 +1,100 @@
+#include "frame_allocator.h"
+#include <algorithm>
+#include <bit>
+#include "engine/core.h"
+
+namespace lotus
+{
+    //enough for a frame's worth of command buffer lists and culling results on one thread
+    constexpr size_t block_size{ 64 * 1024 };
+
+    void* FrameAllocator::Arena::do_allocate(size_t size, size_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        while (true)
+        {
+            if (block < blocks.size())
+            {
+                auto base = reinterpret_cast<uintptr_t>(blocks[block].data.get());
+                uintptr_t offset = ((base + head + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+                if (offset + size <= blocks[block].size)
+                {
+                    head = offset + size;
+                    return blocks[block].data.get() + offset;
+                }
+                ++block;
+                head = 0;
+            }
+            else
+            {
+                size_t new_size = std::max(block_size, std::bit_ceil(size + alignment));
+                blocks.push_back({ std::make_unique<std::byte[]>(new_size), new_size });
+                heap_allocations.fetch_add(1, std::memory_order_relaxed);
+                reserved.fetch_add(new_size, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void FrameAllocator::Arena::reset()
+    {
+        block = 0;
+        head = 0;
+    }
+
+    FrameAllocator::FrameAllocator(Engine* _engine, uint32_t _frames_in_flight) : engine(_engine), frames_in_flight(_frames_in_flight), epochs(_frames_in_flight)
+    {
+    }
+
+    FrameAllocator::ThreadArenas& FrameAllocator::getThreadArenas()
+    {
+        thread_local std::shared_ptr<ThreadArenas> arenas;
+        if (!arenas || arenas->allocator != this)
+        {
+            arenas = std::make_shared<ThreadArenas>(this, frames_in_flight);
+            std::lock_guard lk{ mutex };
+            thread_arenas.push_back(arenas);
+        }
+        return *arenas;
+    }
+
+    std::pmr::memory_resource* FrameAllocator::getResource()
+    {
+        uint32_t frame = engine->renderer.getCurrentFrame();
+        auto& arena = getThreadArenas().frames[frame];
+        //rewound by its own thread, so the owning thread never races the one retiring the frame
+        uint64_t epoch = epochs[frame].load(std::memory_order_acquire);
+        if (arena.epoch != epoch)
+        {
+            arena.reset();
+            arena.epoch = epoch;
+        }
+        return &arena;
+    }
+
+    void FrameAllocator::retire(uint32_t frame)
+    {
+        epochs[frame].fetch_add(1, std::memory_order_release);
+        std::lock_guard lk{ mutex };
+        Stats frame_stats;
+        for (const auto& arenas : thread_arenas)
+        {
+            auto& arena = arenas->frames[frame];
+            frame_stats.frame_allocations += arena.allocations.exchange(0, std::memory_order_relaxed);
+            frame_stats.frame_bytes += arena.bytes.exchange(0, std::memory_order_relaxed);
+            frame_stats.frame_heap_allocations += arena.heap_allocations.exchange(0, std::memory_order_relaxed);
+            for (const auto& thread_arena : arenas->frames)
+            {
+                frame_stats.reserved += thread_arena.reserved.load(std::memory_order_relaxed);
+            }
+        }
+        frame_stats.threads = static_cast<uint32_t>(thread_arenas.size());
+        stats = frame_stats;
+    }
+
+    FrameAllocator::Stats FrameAllocator::getStats() const
+    {
+        std::lock_guard lk{ mutex };
+        return stats;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace lotus
+{
+    class Engine;
+
+    //transient CPU allocations (command buffer lists, culling results, descriptor infos) that only live while a frame is recorded
+    //every thread gets its own bump allocated arena per frame in flight, so allocating never takes a lock
+    //an arena's memory is kept and reused once its frame retires, so a warmed up frame shouldn't touch the heap at all
+    class FrameAllocator
+    {
+    public:
+        struct Stats
+        {
+            //allocations and bytes handed out by the last retired frame, across all threads
+            //the containers on the arenas grow the same way on the heap, so this is also how many heap allocations they made
+            //  per frame before they moved here
+            uint64_t frame_allocations{ 0 };
+            uint64_t frame_bytes{ 0 };
+            //blocks the last retired frame had to get from the heap: the heap allocations they make per frame now
+            //  (0 once the arenas have grown to fit)
+            uint64_t frame_heap_allocations{ 0 };
+            //held by every arena of every thread
+            size_t reserved{ 0 };
+            uint32_t threads{ 0 };
+        };
+
+        FrameAllocator(Engine* engine, uint32_t frames_in_flight);
+
+        //the calling thread's arena for the current frame; anything allocated from it is only valid until that frame retires
+        std::pmr::memory_resource* getResource();
+        //frame's fence has been waited on: its arenas are rewound the next time their thread asks for them
+        void retire(uint32_t frame);
+        Stats getStats() const;
+
+    private:
+        class Arena : public std::pmr::memory_resource
+        {
+        public:
+            void reset();
+
+            //only written by the owning thread, but summed up by whichever thread retires the frame
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> heap_allocations{ 0 };
+            std::atomic<size_t> reserved{ 0 };
+            //the frame's retire count when this arena was last rewound
+            uint64_t epoch{ 0 };
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            //everything is released at once when the frame retires
+            void do_deallocate(void*, size_t, size_t) override {}
+            bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+        private:
+            struct Block
+            {
+                std::unique_ptr<std::byte[]> data;
+                size_t size{ 0 };
+            };
+            std::vector<Block> blocks;
+            size_t block{ 0 };
+            size_t head{ 0 };
+        };
+
+        struct ThreadArenas
+        {
+            ThreadArenas(FrameAllocator* _allocator, uint32_t frames_in_flight) : allocator(_allocator), frames(frames_in_flight) {}
+            FrameAllocator* allocator;
+            std::vector<Arena> frames;
+        };
+
+        ThreadArenas& getThreadArenas();
+
+        Engine* engine;
+        uint32_t frames_in_flight;
+        std::vector<std::atomic<uint64_t>> epochs;
+
+        //guards thread_arenas and stats
+        mutable std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadArenas>> thread_arenas;
+        Stats stats;
+    };
+}
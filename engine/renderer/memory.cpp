@@ -1,10 +1,36 @@
 #include "memory.h"
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 
 namespace lotus
 {
+    namespace
+    {
+        //the bundled vma only sets VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT on dedicated allocations (and has no allocator-wide flag for it),
+        //  so it's added here to every block it allocates: the device always enables bufferDeviceAddress, and pooled buffers can then have addresses
+        VKAPI_ATTR VkResult VKAPI_CALL allocateDeviceAddressMemory(VkDevice device, const VkMemoryAllocateInfo* allocate_info, const VkAllocationCallbacks* allocator, VkDeviceMemory* memory)
+        {
+            for (auto next = static_cast<const VkBaseInStructure*>(allocate_info->pNext); next; next = next->pNext)
+            {
+                //VMA_ALLOCATION_DEVICE_ADDRESS_BIT already chained it
+                if (next->sType == VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO)
+                    return vkAllocateMemory(device, allocate_info, allocator, memory);
+            }
+            VkMemoryAllocateFlagsInfo flags_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO };
+            flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+            flags_info.pNext = allocate_info->pNext;
+            VkMemoryAllocateInfo device_address_info = *allocate_info;
+            device_address_info.pNext = &flags_info;
+            return vkAllocateMemory(device, &device_address_info, allocator, memory);
+        }
+    }
+
     void* Memory::map(vk::DeviceSize offset, vk::DeviceSize size, vk::MemoryMapFlags flags)
     {
         void* mapped;
@@ -22,9 +48,18 @@ namespace lotus
         vmaUnmapMemory(manager->allocator, allocation);
     }
 
+    Memory::~Memory()
+    {
+        if (accounted_size > 0)
+            manager->untrack(category, accounted_size);
+    }
+
     Buffer::~Buffer()
     {
-        vmaDestroyBuffer(manager->allocator, buffer, allocation);
+        if (cache_key)
+            manager->recycle(cache_key, buffer, allocation);
+        else
+            vmaDestroyBuffer(manager->allocator, buffer, allocation);
     }
 
     Image::~Image()
@@ -37,24 +72,413 @@ namespace lotus
         vmaFreeMemory(manager->allocator, allocation);
     }
 
-    MemoryManager::MemoryManager(vk::PhysicalDevice _physical_device, vk::Device _device): device(_device),
-                                 physical_device(_physical_device), allocator(VK_NULL_HANDLE)
+    MemoryManager::MemoryManager(vk::PhysicalDevice _physical_device, vk::Device _device, uint32_t _frames_in_flight, bool _memory_budget): device(_device),
+                                 physical_device(_physical_device), allocator(VK_NULL_HANDLE), frames_in_flight(_frames_in_flight), memory_budget(_memory_budget)
     {
+        VmaVulkanFunctions vulkan_functions = {};
+        vulkan_functions.vkAllocateMemory = &allocateDeviceAddressMemory;
+
         VmaAllocatorCreateInfo vma_ci = {};
         vma_ci.device = device;
         vma_ci.physicalDevice = physical_device;
+        vma_ci.pVulkanFunctions = &vulkan_functions;
 
         vmaCreateAllocator(&vma_ci, &allocator);
     }
 
     MemoryManager::~MemoryManager()
     {
+        //every thread is done allocating by now
+        for (auto& cache : thread_caches)
+        {
+            for (auto& [key, buffers] : cache->free)
+            {
+                for (auto& cached : buffers)
+                    vmaDestroyBuffer(allocator, cached.buffer, cached.allocation);
+            }
+            for (auto& [key, cached] : cache->released)
+                vmaDestroyBuffer(allocator, cached.buffer, cached.allocation);
+            cache->free.clear();
+            cache->released.clear();
+            cache->manager = nullptr;
+        }
+        for (auto& [key, buffers] : depot)
+        {
+            for (auto& cached : buffers)
+                vmaDestroyBuffer(allocator, cached.buffer, cached.allocation);
+        }
+        for (auto& [key, pool] : pools)
+        {
+            vmaDestroyPool(allocator, pool);
+        }
         vmaDestroyAllocator(allocator);
     }
 
+    MemoryManager::PoolClass MemoryManager::getPoolClass(bool device_address, vk::MemoryPropertyFlags memoryflags)
+    {
+        if (device_address)
+            return PoolClass::DeviceAddress;
+        if (memoryflags & vk::MemoryPropertyFlagBits::eHostVisible)
+            return PoolClass::Streaming;
+        return PoolClass::Static;
+    }
+
+    VmaPool MemoryManager::getPool(PoolClass pool_class, uint32_t memory_type)
+    {
+        auto& pool = pools[{ pool_class, memory_type }];
+        if (!pool)
+        {
+            VmaPoolCreateInfo pool_info = {};
+            pool_info.memoryTypeIndex = memory_type;
+            //pools never hold optimal images, so buffers don't need to be kept apart from them
+            pool_info.flags = VMA_POOL_CREATE_IGNORE_BUFFER_IMAGE_GRANULARITY_BIT;
+            vmaCreatePool(allocator, &pool_info, &pool);
+        }
+        return pool;
+    }
+
+    VmaPool MemoryManager::getBufferPool(const VkBufferCreateInfo& buffer_info, vk::MemoryPropertyFlags memoryflags)
+    {
+        uint64_t key = static_cast<uint64_t>(buffer_info.usage) << 32 | static_cast<VkMemoryPropertyFlags>(memoryflags);
+        if (auto pool = buffer_pools.find(key); pool != buffer_pools.end())
+            return pool->second;
+
+        VmaAllocationCreateInfo vma_ci = {};
+        vma_ci.requiredFlags = (VkMemoryPropertyFlags)memoryflags;
+        uint32_t memory_type;
+        VmaPool pool = VK_NULL_HANDLE;
+        if (vmaFindMemoryTypeIndexForBufferInfo(allocator, &buffer_info, &vma_ci, &memory_type) == VK_SUCCESS)
+        {
+            bool device_address = (buffer_info.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) != 0;
+            pool = getPool(getPoolClass(device_address, memoryflags), memory_type);
+        }
+        buffer_pools.emplace(key, pool);
+        return pool;
+    }
+
+    uint64_t MemoryManager::getCacheKey(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryflags)
+    {
+        if (size == 0 || size > max_cached_size || !(memoryflags & vk::MemoryPropertyFlagBits::eHostVisible) || (usage & vk::BufferUsageFlagBits::eShaderDeviceAddress))
+            return 0;
+        //power of two size classes, from 256 bytes
+        uint64_t size_class = std::max<uint64_t>(std::bit_width(size - 1), 8);
+        return static_cast<uint64_t>(static_cast<VkBufferUsageFlags>(usage)) << 32 | static_cast<uint64_t>(static_cast<VkMemoryPropertyFlags>(memoryflags)) << 8 | size_class;
+    }
+
+    MemoryManager::ThreadCache& MemoryManager::getThreadCache()
+    {
+        thread_local std::shared_ptr<ThreadCache> cache;
+        if (!cache || cache->manager != this)
+        {
+            cache = std::make_shared<ThreadCache>();
+            cache->manager = this;
+            std::lock_guard lg(allocation_mutex);
+            thread_caches.push_back(cache);
+        }
+        return *cache;
+    }
+
+    void MemoryManager::refill(uint64_t key, std::vector<CachedBuffer>& free)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::lock_guard lg(allocation_mutex);
+        auto& released = depot[key];
+        while (!released.empty() && free.size() < cache_batch && released.front().released + frames_in_flight <= frame_serial)
+        {
+            free.push_back(released.front());
+            released.pop_front();
+        }
+
+        if (free.empty())
+        {
+            VkBufferCreateInfo buffer_create_info = {};
+            buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_create_info.size = 1ull << (key & 0xff);
+            buffer_create_info.usage = static_cast<VkBufferUsageFlags>(key >> 32);
+            buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            vk::MemoryPropertyFlags memoryflags{ static_cast<VkMemoryPropertyFlags>((key >> 8) & 0xffffff) };
+
+            VmaAllocationCreateInfo vma_ci = {};
+            vma_ci.requiredFlags = (VkMemoryPropertyFlags)memoryflags;
+            vma_ci.pool = getBufferPool(buffer_create_info, memoryflags);
+
+            for (size_t i = 0; i < cache_batch; ++i)
+            {
+                CachedBuffer cached{};
+                if (vmaCreateBuffer(allocator, &buffer_create_info, &vma_ci, &cached.buffer, &cached.allocation, nullptr) != VK_SUCCESS)
+                    break;
+                free.push_back(cached);
+            }
+        }
+        recordAllocation(start);
+    }
+
+    void MemoryManager::recycle(uint64_t key, VkBuffer buffer, VmaAllocation allocation)
+    {
+        auto& cache = getThreadCache();
+        std::lock_guard lk(cache.released_mutex);
+        cache.released.push_back({ key, { buffer, allocation, frame_serial } });
+        if (cache.released.size() >= cache_batch)
+            flushReleased(cache);
+    }
+
+    void MemoryManager::flushReleased(ThreadCache& cache)
+    {
+        if (cache.released.empty())
+            return;
+        std::lock_guard lg(allocation_mutex);
+        for (auto& [key, cached] : cache.released)
+        {
+            depot[key].push_back(cached);
+        }
+        cache.released.clear();
+    }
+
+    void MemoryManager::retireFrame()
+    {
+        ++frame_serial;
+        //partial batches are flushed every frame, so no thread (including ones that have exited) holds on to its last few
+        //  released buffers; the main thread releases most of them anyway (finished work items are destroyed there)
+        std::vector<std::shared_ptr<ThreadCache>> caches;
+        {
+            std::lock_guard lg(allocation_mutex);
+            caches = thread_caches;
+        }
+        for (const auto& cache : caches)
+        {
+            std::lock_guard lk(cache->released_mutex);
+            flushReleased(*cache);
+        }
+
+        //the driver's budget covers every process on the device, so it can shrink without anything allocating here
+        if (memory_budget && frame_serial % 30 == 0)
+        {
+            vk::DeviceSize excess = 0;
+            for (const auto& heap : getHeapStats())
+            {
+                if (heap.device_local && heap.usage > heap.budget)
+                    excess = std::max(excess, heap.usage - heap.budget);
+            }
+            if (excess > 0)
+            {
+                for (auto& request : eviction_requests)
+                {
+                    request = std::max<vk::DeviceSize>(request, excess);
+                }
+            }
+        }
+
+        std::array<std::function<void(vk::DeviceSize)>, category_count> callbacks;
+        {
+            std::lock_guard lg(allocation_mutex);
+            callbacks = evict_callbacks;
+        }
+        for (size_t i = 0; i < category_count; ++i)
+        {
+            if (!callbacks[i])
+                continue;
+            if (auto request = eviction_requests[i].exchange(0); request > 0)
+                callbacks[i](request);
+        }
+
+        if (log_interval.count() > 0 && std::chrono::steady_clock::now() - last_log >= log_interval)
+        {
+            last_log = std::chrono::steady_clock::now();
+            logStats();
+        }
+    }
+
+    void MemoryManager::track(Memory& memory, MemoryCategory category, vk::DeviceSize accounted_size)
+    {
+        auto index = static_cast<size_t>(category);
+        memory.category = category;
+        memory.accounted_size = accounted_size;
+        auto bytes = category_bytes[index] += accounted_size;
+        ++category_counts[index];
+        auto budget = category_budgets[index].load();
+        if (budget > 0 && bytes > budget)
+        {
+            auto excess = bytes - budget;
+            auto request = eviction_requests[index].load();
+            while (request < excess && !eviction_requests[index].compare_exchange_weak(request, excess));
+        }
+    }
+
+    void MemoryManager::untrack(MemoryCategory category, vk::DeviceSize accounted_size)
+    {
+        auto index = static_cast<size_t>(category);
+        category_bytes[index] -= accounted_size;
+        --category_counts[index];
+    }
+
+    void MemoryManager::setBudget(MemoryCategory category, vk::DeviceSize budget, std::function<void(vk::DeviceSize)> evict)
+    {
+        std::lock_guard lg(allocation_mutex);
+        category_budgets[static_cast<size_t>(category)] = budget;
+        evict_callbacks[static_cast<size_t>(category)] = std::move(evict);
+    }
+
+    bool MemoryManager::fitsBudget(MemoryCategory category, vk::DeviceSize size) const
+    {
+        auto index = static_cast<size_t>(category);
+        auto budget = category_budgets[index].load();
+        return budget == 0 || category_bytes[index] + size <= budget;
+    }
+
+    void MemoryManager::setLogInterval(std::chrono::seconds interval)
+    {
+        log_interval = interval;
+        last_log = std::chrono::steady_clock::now();
+    }
+
+    void MemoryManager::addLogSource(std::function<void(std::ostream&)> source)
+    {
+        std::lock_guard lg(allocation_mutex);
+        log_sources.push_back(std::move(source));
+    }
+
+    const char* MemoryManager::getCategoryName(MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::LandscapeMesh:
+            return "landscape mesh";
+        case MemoryCategory::ActorMesh:
+            return "actor mesh";
+        case MemoryCategory::SkinnedOutput:
+            return "skinned";
+        case MemoryCategory::AccelerationStructure:
+            return "acceleration structure";
+        case MemoryCategory::Scratch:
+            return "scratch";
+        case MemoryCategory::Texture:
+            return "texture";
+        case MemoryCategory::RenderTarget:
+            return "render target";
+        case MemoryCategory::Uniform:
+            return "uniform";
+        case MemoryCategory::Staging:
+            return "staging";
+        default:
+            return "other";
+        }
+    }
+
+    std::vector<MemoryManager::HeapStats> MemoryManager::getHeapStats() const
+    {
+        std::vector<HeapStats> heaps;
+        if (memory_budget)
+        {
+            vk::PhysicalDeviceMemoryProperties2 properties;
+            vk::PhysicalDeviceMemoryBudgetPropertiesEXT budget;
+            properties.pNext = &budget;
+            physical_device.getMemoryProperties2(&properties);
+            for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; ++i)
+            {
+                const auto& heap = properties.memoryProperties.memoryHeaps[i];
+                heaps.push_back({ heap.size, budget.heapUsage[i], budget.heapBudget[i], static_cast<bool>(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) });
+            }
+        }
+        else
+        {
+            auto properties = physical_device.getMemoryProperties();
+            VmaStats vma_stats;
+            vmaCalculateStats(allocator, &vma_stats);
+            for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+            {
+                const auto& heap = properties.memoryHeaps[i];
+                //without the extension, vma assumes 80% of a heap is usable too
+                heaps.push_back({ heap.size, vma_stats.memoryHeap[i].usedBytes + vma_stats.memoryHeap[i].unusedBytes, heap.size * 8 / 10, static_cast<bool>(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) });
+            }
+        }
+        return heaps;
+    }
+
+    void MemoryManager::logStats() const
+    {
+        constexpr double mb = 1024.0 * 1024.0;
+        auto current = getStats();
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << "memory:";
+        for (const auto& heap : current.heaps)
+        {
+            if (heap.device_local)
+                line << " vram " << heap.usage / mb << "/" << heap.budget / mb << " MB;";
+        }
+        for (size_t i = 0; i < category_count; ++i)
+        {
+            const auto& category = current.categories[i];
+            if (category.count == 0)
+                continue;
+            line << " " << getCategoryName(static_cast<MemoryCategory>(i)) << " " << category.bytes / mb << " MB (" << category.count << ")";
+            if (category.budget > 0)
+                line << "/" << category.budget / mb << " MB";
+            line << ";";
+        }
+        std::cout << line.str() << std::endl;
+
+        //the latencies cover every call that took the lock since startup, cache refills included
+        constexpr const char* pool_names[] = { "device address", "streaming", "static" };
+        static_assert(std::size(pool_names) == static_cast<size_t>(PoolClass::Count));
+        std::ostringstream allocation_line;
+        allocation_line << std::fixed << std::setprecision(1) << "allocations: " << current.allocations << " in " << current.blocks << " blocks (";
+        for (size_t i = 0; i < std::size(pool_names); ++i)
+        {
+            allocation_line << (i > 0 ? ", " : "") << pool_names[i] << " " << current.pool_allocations[i] << " in " << current.pool_blocks[i];
+        }
+        double average_us = current.allocation_calls > 0 ? std::chrono::duration<double, std::micro>(current.allocation_time).count() / current.allocation_calls : 0.0;
+        allocation_line << "), " << (current.used_bytes + current.unused_bytes) / mb << " MB in blocks, " << current.unused_bytes / mb << " MB unused;"
+            << " " << current.allocation_calls << " locked calls, avg " << average_us << " us, max "
+            << std::chrono::duration<double, std::micro>(current.max_allocation_time).count() << " us;"
+            << " " << current.cached_allocations << " from thread caches, " << current.depot_buffers << " in the depot;"
+            << " " << current.dedicated_fallbacks << " dedicated fallbacks";
+        std::cout << allocation_line.str() << std::endl;
+
+        std::vector<std::function<void(std::ostream&)>> sources;
+        {
+            std::lock_guard lg(allocation_mutex);
+            sources = log_sources;
+        }
+        for (const auto& source : sources)
+        {
+            std::ostringstream source_line;
+            source_line << std::fixed << std::setprecision(1);
+            source(source_line);
+            std::cout << source_line.str() << std::endl;
+        }
+    }
+
+    void MemoryManager::recordAllocation(std::chrono::steady_clock::time_point start)
+    {
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        ++stats.allocation_calls;
+        stats.allocation_time += time;
+        stats.max_allocation_time = std::max(stats.max_allocation_time, time);
+    }
+
     std::unique_ptr<Buffer> MemoryManager::GetBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
-        vk::MemoryPropertyFlags memoryflags)
+        vk::MemoryPropertyFlags memoryflags, MemoryCategory category)
     {
+        if (auto key = getCacheKey(size, usage, memoryflags))
+        {
+            auto& free = getThreadCache().free[key];
+            if (free.empty())
+                refill(key, free);
+            if (!free.empty())
+            {
+                auto cached = free.back();
+                free.pop_back();
+                ++cached_allocations;
+                VmaAllocationInfo alloc_info;
+                vmaGetAllocationInfo(allocator, cached.allocation, &alloc_info);
+                auto buffer = std::make_unique<Buffer>(this, cached.buffer, cached.allocation, alloc_info, size);
+                buffer->cache_key = key;
+                track(*buffer, category, alloc_info.size);
+                return buffer;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
         std::lock_guard lg(allocation_mutex);
         VkBufferCreateInfo buffer_create_info = {};
         buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -64,22 +488,33 @@ namespace lotus
 
         VmaAllocationCreateInfo vma_ci = {};
         vma_ci.requiredFlags = (VkMemoryPropertyFlags)memoryflags;
-        //TODO: temporarily always allocate (to ensure we get a block with allocation_device_address_bit) until vma is updated
-        if (usage | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-            vma_ci.flags |= VMA_ALLOCATION_DEVICE_ADDRESS_BIT | VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        vma_ci.pool = getBufferPool(buffer_create_info, memoryflags);
 
         VkBuffer buffer;
         VmaAllocation allocation;
         VmaAllocationInfo alloc_info;
 
-        vmaCreateBuffer(allocator, &buffer_create_info, &vma_ci, &buffer, &allocation, &alloc_info);
+        if (vmaCreateBuffer(allocator, &buffer_create_info, &vma_ci, &buffer, &allocation, &alloc_info) != VK_SUCCESS && vma_ci.pool)
+        {
+            //bigger than the pool's blocks
+            vma_ci.pool = VK_NULL_HANDLE;
+            vma_ci.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+            if (usage & vk::BufferUsageFlagBits::eShaderDeviceAddress)
+                vma_ci.flags |= VMA_ALLOCATION_DEVICE_ADDRESS_BIT;
+            vmaCreateBuffer(allocator, &buffer_create_info, &vma_ci, &buffer, &allocation, &alloc_info);
+            ++stats.dedicated_fallbacks;
+        }
+        recordAllocation(start);
 
-        return std::make_unique<Buffer>(this, buffer, allocation, alloc_info, size);
+        auto result = std::make_unique<Buffer>(this, buffer, allocation, alloc_info, size);
+        track(*result, category, alloc_info.size);
+        return result;
     }
 
     std::unique_ptr<Image> MemoryManager::GetImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage,
-        vk::MemoryPropertyFlags memoryflags, uint32_t arrayLayers)
+        vk::MemoryPropertyFlags memoryflags, uint32_t arrayLayers, uint32_t mipLevels, MemoryCategory category)
     {
+        auto start = std::chrono::steady_clock::now();
         std::lock_guard lg(allocation_mutex);
         VkImageCreateInfo image_info = {};
         image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -87,7 +522,7 @@ namespace lotus
         image_info.extent.width = width;
         image_info.extent.height = height;
         image_info.extent.depth = 1;
-        image_info.mipLevels = 1;
+        image_info.mipLevels = mipLevels;
         image_info.arrayLayers = arrayLayers;
         image_info.format = (VkFormat)format;
         image_info.tiling = (VkImageTiling)tiling;
@@ -104,23 +539,70 @@ namespace lotus
         VmaAllocationInfo alloc_info;
 
         vmaCreateImage(allocator, &image_info, &vma_ci, &image, &allocation, &alloc_info);
+        recordAllocation(start);
 
-        return std::make_unique<Image>(this, image, allocation, alloc_info, alloc_info.size);
+        auto result = std::make_unique<Image>(this, image, allocation, alloc_info, alloc_info.size);
+        track(*result, category, alloc_info.size);
+        return result;
     }
 
-    std::unique_ptr<GenericMemory> MemoryManager::GetMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags memoryflags, vk::MemoryAllocateFlags allocateflags)
+    std::unique_ptr<GenericMemory> MemoryManager::GetMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags memoryflags, vk::MemoryAllocateFlags allocateflags, MemoryCategory category)
     {
+        auto start = std::chrono::steady_clock::now();
         std::lock_guard lg(allocation_mutex);
+        bool device_address = static_cast<bool>(allocateflags & vk::MemoryAllocateFlagBits::eDeviceAddress);
         VmaAllocationCreateInfo vma_ci = {};
         vma_ci.requiredFlags = (VkMemoryPropertyFlags)memoryflags;
-        if (allocateflags | vk::MemoryAllocateFlagBits::eDeviceAddress)
-            vma_ci.flags |= VMA_ALLOCATION_DEVICE_ADDRESS_BIT | VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        uint32_t memory_type;
+        if (vmaFindMemoryTypeIndex(allocator, requirements.memoryTypeBits, &vma_ci, &memory_type) == VK_SUCCESS)
+            vma_ci.pool = getPool(getPoolClass(device_address, memoryflags), memory_type);
 
         VmaAllocation allocation;
         VmaAllocationInfo alloc_info;
 
-        vmaAllocateMemory(allocator, (VkMemoryRequirements*)& requirements, &vma_ci, &allocation, &alloc_info);
+        if (vmaAllocateMemory(allocator, (VkMemoryRequirements*)& requirements, &vma_ci, &allocation, &alloc_info) != VK_SUCCESS && vma_ci.pool)
+        {
+            vma_ci.pool = VK_NULL_HANDLE;
+            vma_ci.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+            if (device_address)
+                vma_ci.flags |= VMA_ALLOCATION_DEVICE_ADDRESS_BIT;
+            vmaAllocateMemory(allocator, (VkMemoryRequirements*)& requirements, &vma_ci, &allocation, &alloc_info);
+            ++stats.dedicated_fallbacks;
+        }
+        recordAllocation(start);
+
+        auto result = std::make_unique<GenericMemory>(this, allocation, alloc_info, requirements.size);
+        track(*result, category, alloc_info.size);
+        return result;
+    }
 
-        return std::make_unique<GenericMemory>(this, allocation, alloc_info, requirements.size);
+    MemoryManager::Stats MemoryManager::getStats() const
+    {
+        std::lock_guard lg(allocation_mutex);
+        Stats result = stats;
+        for (size_t i = 0; i < category_count; ++i)
+        {
+            result.categories[i] = { category_bytes[i], category_counts[i], category_budgets[i] };
+        }
+        result.heaps = getHeapStats();
+        result.cached_allocations = cached_allocations;
+        for (const auto& [key, buffers] : depot)
+        {
+            result.depot_buffers += buffers.size();
+        }
+        VmaStats vma_stats;
+        vmaCalculateStats(allocator, &vma_stats);
+        result.allocations = vma_stats.total.allocationCount;
+        result.blocks = vma_stats.total.blockCount;
+        result.used_bytes = vma_stats.total.usedBytes;
+        result.unused_bytes = vma_stats.total.unusedBytes;
+        for (const auto& [key, pool] : pools)
+        {
+            VmaPoolStats pool_stats;
+            vmaGetPoolStats(allocator, pool, &pool_stats);
+            result.pool_allocations[static_cast<size_t>(key.first)] += pool_stats.allocationCount;
+            result.pool_blocks[static_cast<size_t>(key.first)] += pool_stats.blockCount;
+        }
+        return result;
     }
 }
@@ -2,13 +2,40 @@
 #include <utility>
 #include <engine/renderer/vulkan/vulkan_inc.h>
 #include "vk_mem_alloc.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
 
 namespace lotus
 {
     class MemoryManager;
 
+    //what an allocation is for, for per-subsystem accounting and budgets
+    enum class MemoryCategory
+    {
+        LandscapeMesh,
+        ActorMesh,
+        //deformed vertex buffers, and the bone data they're skinned from
+        SkinnedOutput,
+        //acceleration structures and their instance buffers
+        AccelerationStructure,
+        Scratch,
+        Texture,
+        RenderTarget,
+        Uniform,
+        Staging,
+        Other,
+        Count
+    };
+
     class Memory
     {
     public:
@@ -22,17 +49,23 @@ namespace lotus
         Memory(Memory&&) = default;
         Memory& operator=(const Memory&) = delete;
         Memory& operator=(Memory&&) = default;
-        virtual ~Memory() = default;
+        virtual ~Memory();
         void* map(vk::DeviceSize offset, vk::DeviceSize size, vk::MemoryMapFlags flags);
         void unmap();
         void flush(vk::DeviceSize offset, vk::DeviceSize size);
         vk::DeviceSize getSize() { return size; }
+        MemoryCategory getCategory() const { return category; }
         VmaAllocation allocation;
     protected:
         vk::DeviceSize memory_offset;
         vk::DeviceMemory memory;
         vk::DeviceSize size;
         MemoryManager* manager{ nullptr };
+        MemoryCategory category{ MemoryCategory::Other };
+        //bytes counted against the category (the whole allocation, not just the requested size)
+        vk::DeviceSize accounted_size{ 0 };
+
+        friend class MemoryManager;
     };
 
     class Buffer : public Memory
@@ -43,6 +76,10 @@ namespace lotus
             buffer(_buffer) {}
         ~Buffer();
         vk::Buffer buffer;
+    private:
+        //nonzero if the buffer goes back to the manager's cache instead of being destroyed
+        uint64_t cache_key{ 0 };
+        friend class MemoryManager;
     };
 
     class Image : public Memory
@@ -66,21 +103,156 @@ namespace lotus
         vk::DeviceSize get_memory_offset() const { return memory_offset; }
     };
 
+    //buffers and generic memory are sub-allocated from a vma pool per usage class (and memory type), images from vma's default pools
+    //only allocations that don't fit a pool's blocks get memory of their own
+    //small host visible buffers (uniform buffers, staging for bone palettes and the like) are recycled through per-thread caches,
+    //  so the per-frame ones don't take the allocation lock
     class MemoryManager
     {
     public:
-        MemoryManager(vk::PhysicalDevice _physical_device, vk::Device _device);
+        enum class PoolClass
+        {
+            //acceleration structures and buffers the raytracer reads by address (every block can have an address, but these are kept together)
+            DeviceAddress,
+            //host visible (staging, uniform buffers)
+            Streaming,
+            //everything else: long-lived device local
+            Static,
+            Count
+        };
+
+        struct CategoryStats
+        {
+            vk::DeviceSize bytes{ 0 };
+            size_t count{ 0 };
+            //0 if the category has no budget
+            vk::DeviceSize budget{ 0 };
+        };
+
+        struct HeapStats
+        {
+            vk::DeviceSize size{ 0 };
+            //from VK_EXT_memory_budget when the device has it (so including other processes), otherwise this process' vma blocks
+            vk::DeviceSize usage{ 0 };
+            vk::DeviceSize budget{ 0 };
+            bool device_local{ false };
+        };
+
+        struct Stats
+        {
+            std::array<CategoryStats, static_cast<size_t>(MemoryCategory::Count)> categories{};
+            std::vector<HeapStats> heaps;
+            //live allocations, and the VkDeviceMemory blocks holding them
+            size_t allocations{ 0 };
+            size_t blocks{ 0 };
+            vk::DeviceSize used_bytes{ 0 };
+            vk::DeviceSize unused_bytes{ 0 };
+            std::array<size_t, static_cast<size_t>(PoolClass::Count)> pool_allocations{};
+            std::array<size_t, static_cast<size_t>(PoolClass::Count)> pool_blocks{};
+            //pool allocations that failed and fell back to memory of their own
+            uint64_t dedicated_fallbacks{ 0 };
+            //GetBuffer calls served from a thread's cache without taking the lock
+            uint64_t cached_allocations{ 0 };
+            //released cached buffers waiting in the shared depot
+            size_t depot_buffers{ 0 };
+            //every Get* call that took the lock (cache refills included), and the wait for it
+            uint64_t allocation_calls{ 0 };
+            std::chrono::nanoseconds allocation_time{ 0 };
+            std::chrono::nanoseconds max_allocation_time{ 0 };
+        };
+
+        //memory_budget: VK_EXT_memory_budget is enabled on the device
+        MemoryManager(vk::PhysicalDevice _physical_device, vk::Device _device, uint32_t _frames_in_flight, bool _memory_budget);
         ~MemoryManager();
-        std::unique_ptr<Buffer> GetBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryflags);
-        std::unique_ptr<Image> GetImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags memoryflags, uint32_t arrayLayers = 1);
-        std::unique_ptr<GenericMemory> GetMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags memoryflags, vk::MemoryAllocateFlags allocateflags = vk::MemoryAllocateFlagBits{});
+        std::unique_ptr<Buffer> GetBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryflags, MemoryCategory category = MemoryCategory::Other);
+        std::unique_ptr<Image> GetImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags memoryflags, uint32_t arrayLayers = 1, uint32_t mipLevels = 1, MemoryCategory category = MemoryCategory::Other);
+        std::unique_ptr<GenericMemory> GetMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags memoryflags, vk::MemoryAllocateFlags allocateflags = vk::MemoryAllocateFlagBits{}, MemoryCategory category = MemoryCategory::Other);
+        Stats getStats() const;
+        static const char* getCategoryName(MemoryCategory category);
+
+        //allocations are never refused outright: subsystems with optional allocations check fitsBudget first,
+        //  and evict (if given) is called from retireFrame with the bytes to free once the category goes over
+        //  (or a device local heap goes over its VK_EXT_memory_budget budget)
+        void setBudget(MemoryCategory category, vk::DeviceSize budget, std::function<void(vk::DeviceSize)> evict = {});
+        bool fitsBudget(MemoryCategory category, vk::DeviceSize size) const;
+        //0 disables the log line
+        void setLogInterval(std::chrono::seconds interval);
+        //adds a line of another subsystem's stats to the periodic log, written after the memory line
+        void addLogSource(std::function<void(std::ostream&)> source);
+
+        //called once a frame's fence has been waited on; released buffers are reused after frames_in_flight of these
+        void retireFrame();
 
         VmaAllocator allocator;
 
     private:
+        struct CachedBuffer
+        {
+            VkBuffer buffer;
+            VmaAllocation allocation;
+            //frame serial when it was released
+            uint64_t released;
+        };
+        struct ThreadCache
+        {
+            MemoryManager* manager{ nullptr };
+            //ready to hand out, by cache key
+            std::unordered_map<uint64_t, std::vector<CachedBuffer>> free;
+            //released on this thread, moved to the depot in batches (and whatever is left by retireFrame, so a thread that
+            //  stops releasing doesn't keep a partial batch forever)
+            std::vector<std::pair<uint64_t, CachedBuffer>> released;
+            //only contended when retireFrame flushes released from another thread
+            std::mutex released_mutex;
+        };
+        //buffers handed to (and taken from) the depot at once
+        static constexpr size_t cache_batch = 8;
+        static constexpr vk::DeviceSize max_cached_size = 64 * 1024;
+
+        //0 if the buffer isn't cached
+        static uint64_t getCacheKey(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryflags);
+        ThreadCache& getThreadCache();
+        void refill(uint64_t key, std::vector<CachedBuffer>& free);
+        void recycle(uint64_t key, VkBuffer buffer, VmaAllocation allocation);
+        //caller holds cache.released_mutex
+        void flushReleased(ThreadCache& cache);
+
+        static PoolClass getPoolClass(bool device_address, vk::MemoryPropertyFlags memoryflags);
+        //caller holds allocation_mutex
+        VmaPool getPool(PoolClass pool_class, uint32_t memory_type);
+        VmaPool getBufferPool(const VkBufferCreateInfo& buffer_info, vk::MemoryPropertyFlags memoryflags);
+        void recordAllocation(std::chrono::steady_clock::time_point start);
+        void track(Memory& memory, MemoryCategory category, vk::DeviceSize accounted_size);
+        void untrack(MemoryCategory category, vk::DeviceSize accounted_size);
+        std::vector<HeapStats> getHeapStats() const;
+        void logStats() const;
+
         vk::Device device;
         vk::PhysicalDevice physical_device;
-        std::mutex allocation_mutex;
+        mutable std::mutex allocation_mutex;
+        uint32_t frames_in_flight;
+        std::atomic<uint64_t> frame_serial{ 0 };
+        std::atomic<uint64_t> cached_allocations{ 0 };
+        bool memory_budget;
+
+        static constexpr size_t category_count = static_cast<size_t>(MemoryCategory::Count);
+        std::array<std::atomic<uint64_t>, category_count> category_bytes{};
+        std::array<std::atomic<uint64_t>, category_count> category_counts{};
+        std::array<std::atomic<uint64_t>, category_count> category_budgets{};
+        std::array<std::atomic<vk::DeviceSize>, category_count> eviction_requests{};
+        //guarded by allocation_mutex
+        std::array<std::function<void(vk::DeviceSize)>, category_count> evict_callbacks;
+        std::chrono::seconds log_interval{ 0 };
+        std::chrono::steady_clock::time_point last_log;
+        //guarded by allocation_mutex
+        std::vector<std::function<void(std::ostream&)>> log_sources;
+
+        std::map<std::pair<PoolClass, uint32_t>, VmaPool> pools;
+        //finding a buffer's memory type means creating a buffer, so it's only done once per usage/property combination
+        std::unordered_map<uint64_t, VmaPool> buffer_pools;
+        //released cached buffers, oldest first
+        std::unordered_map<uint64_t, std::deque<CachedBuffer>> depot;
+        std::vector<std::shared_ptr<ThreadCache>> thread_caches;
+        Stats stats;
 
         friend class Memory;
     };
@@ -1,4 +1,7 @@
 #include "mesh.h"
+#include <algorithm>
+#include "engine/core.h"
+#include "engine/hash.h"
 
 
 void lotus::Mesh::setVertexBuffer(uint8_t* buffer, size_t len)
@@ -17,3 +20,45 @@ void lotus::Mesh::setVertexBuffer(uint8_t* buffer, size_t len)
 
     //copyBuffer(*stagingBuffer->buffer, *vertexBuffer->buffer, bufferSize);
 }
+
+bool lotus::Mesh::createBuffers(Engine* engine, const std::vector<uint8_t>& vertex_data, const std::vector<uint8_t>& index_data, vk::BufferUsageFlags vertex_usage, vk::BufferUsageFlags index_usage, MemoryCategory category)
+{
+    //usage is part of the key since buffers created for a different use can't stand in
+    uint64_t usage[2] = { static_cast<VkBufferUsageFlags>(vertex_usage), static_cast<VkBufferUsageFlags>(index_usage) };
+    uint64_t hash = Hash::xxh64(usage, sizeof(usage));
+    hash = Hash::xxh64(vertex_data.data(), vertex_data.size(), hash);
+    uint64_t content_hash = Hash::xxh64(index_data.data(), index_data.size(), hash ^ vertex_data.size());
+
+    //uploads all go out through the batcher ahead of any work, so buffers can be shared before their data is even staged
+    std::lock_guard lk{ buffer_mutex };
+    if (auto found = buffer_map.find(content_hash); found != buffer_map.end())
+    {
+        auto shared_vertex = found->second.vertex_buffer.lock();
+        auto shared_index = found->second.index_buffer.lock();
+        auto shared_contents = found->second.contents.lock();
+        //the hash only narrows it down: the buffers have to hold exactly the same data, for the same usage
+        bool same = shared_contents && found->second.vertex_usage == vertex_usage && found->second.index_usage == index_usage &&
+            found->second.vertex_size == vertex_data.size() && shared_contents->size() == vertex_data.size() + index_data.size() &&
+            std::equal(vertex_data.begin(), vertex_data.end(), shared_contents->begin()) &&
+            std::equal(index_data.begin(), index_data.end(), shared_contents->begin() + vertex_data.size());
+        if (shared_vertex && shared_index && same)
+        {
+            vertex_buffer = std::move(shared_vertex);
+            index_buffer = std::move(shared_index);
+            contents = std::move(shared_contents);
+            shared_buffers = true;
+            deduplicated_bytes += vertex_data.size() + index_data.size();
+            return false;
+        }
+        buffer_map.erase(found);
+    }
+
+    vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertex_data.size(), vertex_usage, vk::MemoryPropertyFlagBits::eDeviceLocal, category);
+    index_buffer = engine->renderer.memory_manager->GetBuffer(index_data.size(), index_usage, vk::MemoryPropertyFlagBits::eDeviceLocal, category);
+    shared_buffers = false;
+    auto new_contents = std::make_shared<std::vector<uint8_t>>(vertex_data);
+    new_contents->insert(new_contents->end(), index_data.begin(), index_data.end());
+    contents = new_contents;
+    buffer_map.insert_or_assign(content_hash, SharedBuffers{ vertex_buffer, index_buffer, contents, vertex_usage, index_usage, vertex_data.size() });
+    return true;
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <engine/renderer/vulkan/vulkan_inc.h>
 #include "memory.h"
 #include "texture.h"
@@ -45,8 +48,15 @@ namespace lotus
 
         void setVertexBuffer(uint8_t* buffer, size_t len);
 
-        std::unique_ptr<Buffer> vertex_buffer;
-        std::unique_ptr<Buffer> index_buffer;
+        //allocates device local vertex/index buffers for the given data, or shares the buffers of a live mesh that was given identical data
+        //returns false if the buffers were shared (and are uploaded by whoever created them)
+        bool createBuffers(Engine* engine, const std::vector<uint8_t>& vertices, const std::vector<uint8_t>& indices, vk::BufferUsageFlags vertex_usage, vk::BufferUsageFlags index_usage, MemoryCategory category);
+        bool hasSharedBuffers() const { return shared_buffers; }
+        //vertex and index data that didn't have to be allocated (or uploaded) again
+        static uint64_t getDeduplicatedBytes() { return deduplicated_bytes; }
+
+        std::shared_ptr<Buffer> vertex_buffer;
+        std::shared_ptr<Buffer> index_buffer;
         std::unique_ptr<Buffer> aabbs_buffer;
 
         std::shared_ptr<Texture> texture;
@@ -64,6 +74,24 @@ namespace lotus
         std::vector<vk::VertexInputAttributeDescription> vertex_attributes;
         int indices{ 0 };
         int vertices{ 0 };
+        bool shared_buffers{ false };
+
+        //the data the buffers were created with (vertices, then indices), kept by the meshes sharing them
+        //  so a hash match can be checked byte for byte
+        std::shared_ptr<const std::vector<uint8_t>> contents;
+
+        struct SharedBuffers
+        {
+            std::weak_ptr<Buffer> vertex_buffer;
+            std::weak_ptr<Buffer> index_buffer;
+            std::weak_ptr<const std::vector<uint8_t>> contents;
+            vk::BufferUsageFlags vertex_usage;
+            vk::BufferUsageFlags index_usage;
+            size_t vertex_size{ 0 };
+        };
+        inline static std::unordered_map<uint64_t, SharedBuffers> buffer_map{};
+        inline static std::mutex buffer_mutex;
+        inline static std::atomic<uint64_t> deduplicated_bytes{ 0 };
     };
 
 }
@@ -0,0 +1,132 @@
+#include "mipmap.h"
+#include <algorithm>
+#include <bit>
+
+namespace lotus
+{
+    uint32_t Mipmap::getLevelCount(uint32_t width, uint32_t height)
+    {
+        return std::bit_width(std::max({ width, height, 1u }));
+    }
+
+    vk::DeviceSize Mipmap::getLevelSize(vk::Format format, uint32_t width, uint32_t height)
+    {
+        switch (format)
+        {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+            return static_cast<vk::DeviceSize>(BlockCompression::getBlockCount(width)) * BlockCompression::getBlockCount(height) * 8;
+        case vk::Format::eBc2UnormBlock:
+        case vk::Format::eBc3UnormBlock:
+        case vk::Format::eBc7UnormBlock:
+            return static_cast<vk::DeviceSize>(BlockCompression::getBlockCount(width)) * BlockCompression::getBlockCount(height) * 16;
+        default:
+            return static_cast<vk::DeviceSize>(width) * height * 4;
+        }
+    }
+
+    vk::DeviceSize Mipmap::getLevelOffset(vk::Format format, uint32_t width, uint32_t height, uint32_t level)
+    {
+        vk::DeviceSize offset = 0;
+        for (uint32_t i = 0; i < level; ++i)
+        {
+            offset += getLevelSize(format, getLevelDimension(width, i), getLevelDimension(height, i));
+        }
+        return offset;
+    }
+
+    std::vector<vk::BufferImageCopy> Mipmap::getCopyRegions(vk::Format format, uint32_t width, uint32_t height, uint32_t base_level, uint32_t level_count)
+    {
+        std::vector<vk::BufferImageCopy> regions;
+        vk::DeviceSize buffer_offset = 0;
+        for (uint32_t level = base_level; level < level_count; ++level)
+        {
+            uint32_t level_width = getLevelDimension(width, level);
+            uint32_t level_height = getLevelDimension(height, level);
+
+            vk::BufferImageCopy region;
+            region.bufferOffset = buffer_offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            region.imageSubresource.mipLevel = level - base_level;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = vk::Offset3D{ 0, 0, 0 };
+            region.imageExtent = vk::Extent3D{ level_width, level_height, 1 };
+            regions.push_back(region);
+            buffer_offset += getLevelSize(format, level_width, level_height);
+        }
+        return regions;
+    }
+
+    std::vector<uint8_t> Mipmap::downsampleRGBA(const uint8_t* rgba, uint32_t width, uint32_t height)
+    {
+        uint32_t next_width = std::max(width / 2, 1u);
+        uint32_t next_height = std::max(height / 2, 1u);
+        std::vector<uint8_t> next(static_cast<size_t>(next_width) * next_height * 4);
+
+        for (uint32_t y = 0; y < next_height; ++y)
+        {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < next_width; ++x)
+            {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                const uint8_t* p00 = rgba + (static_cast<size_t>(y0) * width + x0) * 4;
+                const uint8_t* p01 = rgba + (static_cast<size_t>(y0) * width + x1) * 4;
+                const uint8_t* p10 = rgba + (static_cast<size_t>(y1) * width + x0) * 4;
+                const uint8_t* p11 = rgba + (static_cast<size_t>(y1) * width + x1) * 4;
+                uint8_t* out = next.data() + (static_cast<size_t>(y) * next_width + x) * 4;
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    out[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                }
+            }
+        }
+        return next;
+    }
+
+    void Mipmap::generateRGBA(std::vector<uint8_t>& data, uint32_t width, uint32_t height, uint32_t level_count)
+    {
+        data.resize(getLevelSize(vk::Format::eR8G8B8A8Unorm, width, height));
+        size_t level_offset = 0;
+        for (uint32_t level = 1; level < level_count; ++level)
+        {
+            uint32_t level_width = getLevelDimension(width, level - 1);
+            uint32_t level_height = getLevelDimension(height, level - 1);
+            auto next = downsampleRGBA(data.data() + level_offset, level_width, level_height);
+            level_offset = data.size();
+            data.insert(data.end(), next.begin(), next.end());
+        }
+    }
+
+    void Mipmap::generateCompressed(std::vector<uint8_t>& data, vk::Format format, uint32_t width, uint32_t height, uint32_t level_count, BlockCompression::Quality quality)
+    {
+        data.resize(getLevelSize(format, width, height));
+        //filter from the decoded base each time rather than from re-encoded levels, so block errors don't accumulate
+        auto rgba = BlockCompression::decode(format, data.data(), width, height);
+        for (uint32_t level = 1; level < level_count; ++level)
+        {
+            rgba = downsampleRGBA(rgba.data(), getLevelDimension(width, level - 1), getLevelDimension(height, level - 1));
+            auto encoded = BlockCompression::encode(format, rgba.data(), getLevelDimension(width, level), getLevelDimension(height, level), quality);
+            data.insert(data.end(), encoded.begin(), encoded.end());
+        }
+    }
+
+    std::vector<uint8_t> Mipmap::compressRGBA(const std::vector<uint8_t>& data, vk::Format format, uint32_t width, uint32_t height, uint32_t level_count, BlockCompression::Quality quality)
+    {
+        std::vector<uint8_t> compressed;
+        size_t level_offset = 0;
+        for (uint32_t level = 0; level < level_count; ++level)
+        {
+            uint32_t level_width = getLevelDimension(width, level);
+            uint32_t level_height = getLevelDimension(height, level);
+            auto encoded = BlockCompression::encode(format, data.data() + level_offset, level_width, level_height, quality);
+            compressed.insert(compressed.end(), encoded.begin(), encoded.end());
+            level_offset += getLevelSize(vk::Format::eR8G8B8A8Unorm, level_width, level_height);
+        }
+        return compressed;
+    }
+}
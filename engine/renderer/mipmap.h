@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+#include "block_compression.h"
+
+namespace lotus
+{
+    //CPU mip chain generation for textures that are uploaded from memory
+    class Mipmap
+    {
+    public:
+        static uint32_t getLevelCount(uint32_t width, uint32_t height);
+        static uint32_t getLevelDimension(uint32_t dimension, uint32_t level) { return std::max(dimension >> level, 1u); }
+        //bytes of one level, for RGBA8 and the BCn formats
+        static vk::DeviceSize getLevelSize(vk::Format format, uint32_t width, uint32_t height);
+        //bytes of every level before level in a chain
+        static vk::DeviceSize getLevelOffset(vk::Format format, uint32_t width, uint32_t height, uint32_t level);
+        //copies for levels [base_level, level_count) packed back to back from offset 0, into an image whose level 0 is base_level
+        static std::vector<vk::BufferImageCopy> getCopyRegions(vk::Format format, uint32_t width, uint32_t height, uint32_t base_level, uint32_t level_count);
+
+        //data holds level 0, and the rest of the chain (up to level_count) is appended after it
+        static void generateRGBA(std::vector<uint8_t>& data, uint32_t width, uint32_t height, uint32_t level_count);
+        //BCn levels are decoded, box filtered as RGBA and re-encoded, since blocks can't be filtered directly
+        static void generateCompressed(std::vector<uint8_t>& data, vk::Format format, uint32_t width, uint32_t height, uint32_t level_count, BlockCompression::Quality quality);
+        //encodes an RGBA8 chain from generateRGBA level by level into format
+        static std::vector<uint8_t> compressRGBA(const std::vector<uint8_t>& data, vk::Format format, uint32_t width, uint32_t height, uint32_t level_count, BlockCompression::Quality quality);
+
+    private:
+        //2x2 box filter (clamped at odd edges)
+        static std::vector<uint8_t> downsampleRGBA(const uint8_t* rgba, uint32_t width, uint32_t height);
+    };
+}
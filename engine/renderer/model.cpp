@@ -5,5 +5,19 @@ namespace lotus
     Model::Model(const std::string& _name) : name(_name)
     {
     }
+
+    uint64_t Model::getMemorySize() const
+    {
+        uint64_t size = 0;
+        for (const auto& mesh : meshes)
+        {
+            //buffers shared with other meshes are counted in full, even though evicting this model alone won't free them
+            if (mesh->vertex_buffer)
+                size += mesh->vertex_buffer->getSize();
+            if (mesh->index_buffer)
+                size += mesh->index_buffer->getSize();
+        }
+        return size;
+    }
 }
 
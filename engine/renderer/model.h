@@ -2,6 +2,8 @@
 
 #include "engine/renderer/mesh.h"
 #include "acceleration_structure.h"
+#include "bounds.h"
+#include "asset_cache.h"
 #include "engine/types.h"
 
 namespace lotus
@@ -9,68 +11,65 @@ namespace lotus
     class Model
     {
     public:
-        //TODO: when to clean up dead weak_ptrs?
         //TODO: figure out how to get engine out of this call
         template<typename ModelLoader, typename... Args>
         static std::shared_ptr<Model> LoadModel(Engine* engine, const std::string& modelname, Args... args)
         {
-            if (!modelname.empty())
+            auto load = [&]()
             {
-                if (auto found = model_map.find(modelname); found != model_map.end())
-                {
-                    auto ptr = found->second.lock();
-                    if (ptr)
-                        return ptr;
-                }
-            }
-            auto new_model = std::shared_ptr<Model>(new Model(modelname));
-            ModelLoader loader{args...};
-            loader.setEngine(engine);
-            loader.LoadModel(new_model);
+                auto new_model = std::shared_ptr<Model>(new Model(modelname));
+                ModelLoader loader{args...};
+                loader.setEngine(engine);
+                loader.LoadModel(new_model);
+                return new_model;
+            };
             if (!modelname.empty())
             {
-                return model_map.emplace(modelname, new_model).first->second.lock();
+                return model_cache.findOrLoad(modelname, load);
             }
             else
             {
-                return new_model;
+                return load();
             }
         }
 
         static std::shared_ptr<Model> getModel(const std::string& modelname)
         {
-            if (auto found = model_map.find(modelname); found != model_map.end())
-            {
-                return found->second.lock();
-            }
-            return {};
+            return model_cache.find(modelname);
         }
 
         template<typename T>
         static void forEachModel(T func)
         {
-            for (const auto& [name, model] : model_map)
-            {
-                if (auto ptr = model.lock())
-                {
-                    func(ptr);
-                }
-            }
+            model_cache.forEach(func);
         }
 
+        //only while nothing in flight can be using a model that's no longer referenced
+        static void pruneCache() { model_cache.prune(); }
+        static void clearCache() { model_cache.clear(); }
+        static void setCacheBudget(uint64_t bytes) { model_cache.setBudget(bytes); }
+        static AssetCache<Model>::Stats getCacheStats() { return model_cache.getStats(); }
+
+        //vertex and index buffers, counted against the cache budget once nothing uses the model
+        uint64_t getMemorySize() const;
+
         std::string name;
         std::vector<std::unique_ptr<Mesh>> meshes;
         bool weighted{ false };
         Lifetime lifetime {Lifetime::Short};
         bool rendered{ true };
         uint32_t light_offset{ 0 };
+        //model space bounds of all meshes, filled in by the loader
+        //for weighted models, these are relative to each vertex's bone instead
+        AABB bounds;
+        BoundingSphere bounding_sphere;
 
         std::unique_ptr<BottomLevelAccelerationStructure> bottom_level_as;
 
     protected:
         explicit Model(const std::string& name);
 
-        inline static std::unordered_map<std::string, std::weak_ptr<Model>> model_map{};
+        inline static AssetCache<Model> model_cache{};
     };
 
     class ModelLoader
@@ -68,7 +68,7 @@ namespace lotus
             vk::DeviceSize shader_offset_miss = (((shader_stride * shader_raygencount) / engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment) + 1) * engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment;
             vk::DeviceSize shader_offset_hit = shader_offset_miss + (((shader_stride * shader_misscount) / engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment) + 1) * engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment;
             vk::DeviceSize sbt_size = (shader_stride * shader_hitcount) + shader_offset_hit;
-            shader_binding_table = engine->renderer.memory_manager->GetBuffer(sbt_size, vk::BufferUsageFlagBits::eRayTracingKHR, vk::MemoryPropertyFlagBits::eHostVisible);
+            shader_binding_table = engine->renderer.memory_manager->GetBuffer(sbt_size, vk::BufferUsageFlagBits::eRayTracingKHR, vk::MemoryPropertyFlagBits::eHostVisible, MemoryCategory::Other);
 
             vk::DescriptorSetLayoutBinding acceleration_structure_binding;
             acceleration_structure_binding.binding = 0;
@@ -163,7 +163,7 @@ namespace lotus
             missSBT = vk::StridedBufferRegionKHR{ shader_binding_table->buffer, shader_offset_miss, shader_stride, shader_stride * shader_misscount };
             hitSBT = vk::StridedBufferRegionKHR{ shader_binding_table->buffer, shader_offset_hit, shader_stride, shader_stride * shader_hitcount };
         }
-        auto [graphics_queue_idx, present_queue_idx, compute_queue_idx] = engine->renderer.getQueueFamilies(engine->renderer.physical_device);
+        auto [graphics_queue_idx, present_queue_idx, compute_queue_idx, transfer_queue_idx] = engine->renderer.getQueueFamilies(engine->renderer.physical_device);
         raytrace_query_queue = engine->renderer.device->getQueue(compute_queue_idx.value(), 1);
         vk::FenceCreateInfo fence_info;
         fence = engine->renderer.device->createFenceUnique(fence_info, nullptr);
@@ -179,11 +179,11 @@ namespace lotus
         queries.emplace_back(object_flags, origin, direction, min, max, callback);
     }
 
-    void Raytracer::runQueries(uint32_t image)
+    void Raytracer::runQueries(uint32_t frame)
     {
         if (engine->renderer.RaytraceEnabled())
         {
-            if (engine->game->scene->top_level_as[image])
+            if (engine->game->scene->top_level_as[frame])
             {
                 while (!queries.empty())
                 {
@@ -192,8 +192,8 @@ namespace lotus
 
                     size_t input_buffer_size = sizeof(RaytraceInput) * processing_queries.size();
                     size_t output_buffer_size = sizeof(RaytraceOutput) * processing_queries.size();
-                    input_buffer = engine->renderer.memory_manager->GetBuffer(input_buffer_size, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-                    output_buffer = engine->renderer.memory_manager->GetBuffer(output_buffer_size, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+                    input_buffer = engine->renderer.memory_manager->GetBuffer(input_buffer_size, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Uniform);
+                    output_buffer = engine->renderer.memory_manager->GetBuffer(output_buffer_size, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Other);
                     RaytraceInput* input_mapped = static_cast<RaytraceInput*>(input_buffer->map(0, input_buffer_size, {}));
                     for (size_t i = 0; i < processing_queries.size(); ++i)
                     {
@@ -228,7 +228,7 @@ namespace lotus
 
                     vk::WriteDescriptorSetAccelerationStructureKHR write_as;
                     write_as.accelerationStructureCount = 1;
-                    write_as.pAccelerationStructures = &*engine->game->scene->top_level_as[image]->acceleration_structure;
+                    write_as.pAccelerationStructures = &*engine->game->scene->top_level_as[frame]->acceleration_structure;
                     write_info_as.pNext = &write_as;
 
                     vk::DescriptorBufferInfo input_buffer_info;
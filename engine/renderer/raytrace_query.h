@@ -23,7 +23,7 @@ namespace lotus
         Raytracer(Engine* engine);
         void query(ObjectFlags object_flags, glm::vec3 origin, glm::vec3 direction, float min, float max, std::function<void(float)> callback);
         bool hasQueries() const { return !queries.empty(); }
-        void runQueries(uint32_t image);
+        void runQueries(uint32_t frame);
 
     private:
         class RaytraceQuery
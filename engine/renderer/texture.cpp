@@ -0,0 +1,15 @@
+#include "texture.h"
+
+namespace lotus
+{
+    void Texture::request(uint64_t frame, float distance)
+    {
+        if (requested_frame.exchange(frame) != frame)
+        {
+            requested_distance = distance;
+            return;
+        }
+        float current = requested_distance;
+        while (distance < current && !requested_distance.compare_exchange_weak(current, distance));
+    }
+}
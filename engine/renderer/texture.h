@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <engine/renderer/vulkan/vulkan_inc.h>
 #include "memory.h"
+#include "asset_cache.h"
 #include "../work_item.h"
 
 namespace lotus
@@ -18,48 +23,104 @@ namespace lotus
         template<typename TextureLoader, typename... Args>
         static std::shared_ptr<Texture> LoadTexture(Engine* engine, const std::string& texturename, Args... args)
         {
-            if (auto found = texture_map.find(texturename); found != texture_map.end())
+            return texture_cache.findOrLoad(texturename, [&]()
             {
-                return { found->second.lock(), nullptr };
-            }
-            auto new_texture = std::shared_ptr<Texture>(new Texture());
-            TextureLoader loader{args...};
-            loader.setEngine(engine);
-            loader.LoadTexture(new_texture);
-            return texture_map.emplace(texturename, new_texture).first->second.lock();
+                TextureLoader loader{args...};
+                loader.setEngine(engine);
+                //the same image is often stored under different names (and in different DATs), so those all alias one texture
+                uint64_t content_hash = loader.getContentHash();
+                if (content_hash != 0)
+                {
+                    ContentEntry found_entry;
+                    {
+                        std::lock_guard lk{ content_mutex };
+                        if (auto found = content_map.find(content_hash); found != content_map.end())
+                            found_entry = found->second;
+                    }
+                    //the hash only narrows it down: the texture it found has to have been loaded from exactly the same content
+                    auto texture = found_entry.texture.lock();
+                    if (texture && found_entry.read && loader.matchesContent(found_entry.read()))
+                    {
+                        deduplicated_bytes += loader.getContentSize();
+                        return texture;
+                    }
+                }
+                auto new_texture = std::shared_ptr<Texture>(new Texture());
+                loader.LoadTexture(new_texture);
+                if (content_hash != 0)
+                {
+                    std::lock_guard lk{ content_mutex };
+                    content_map.insert_or_assign(content_hash, ContentEntry{ new_texture, loader.getContentReader() });
+                }
+                return new_texture;
+            });
         }
 
+        //texture data that didn't have to be loaded again because an identical texture was already resident
+        static uint64_t getDeduplicatedBytes() { return deduplicated_bytes; }
+
+        //a texture still being loaded on another thread is waited for
         static std::shared_ptr<Texture> getTexture(const std::string& texturename)
         {
-            if (auto found = texture_map.find(texturename); found != texture_map.end())
-            {
-                return found->second.lock();
-            }
-            return texture_map.at("default").lock();
+            if (auto texture = texture_cache.findOrWait(texturename))
+                return texture;
+            return texture_cache.find("default");
         }
 
+        //only while nothing in flight can be using a texture that's no longer referenced
+        static void pruneCache() { texture_cache.prune(); }
+        static void clearCache() { texture_cache.clear(); }
+        static void setCacheBudget(uint64_t bytes) { texture_cache.setBudget(bytes); }
+        static AssetCache<Texture>::Stats getCacheStats() { return texture_cache.getStats(); }
+
         Texture(const Texture&) = delete;
         Texture& operator=(const Texture&) = delete;
-        Texture(Texture&&) = default;
-        Texture& operator=(Texture&&) = default;
+        Texture(Texture&&) = delete;
+        Texture& operator=(Texture&&) = delete;
         virtual ~Texture() = default;
 
         uint32_t getWidth() const { return width; }
         uint32_t getHeight() const { return height; }
         void setWidth(uint32_t _width) { width = _width; }
         void setHeight(uint32_t _height) { height = _height; }
+        uint32_t getMipLevels() const { return mip_levels; }
+        void setMipLevels(uint32_t _mip_levels) { mip_levels = _mip_levels; }
+        //first mip level held by image (the image's level 0); levels above it aren't resident
+        uint32_t getBaseLevel() const { return base_level; }
+        void setBaseLevel(uint32_t _base_level) { base_level = _base_level; }
+        //marks the texture as needed by something drawn this frame, keeping the nearest distance
+        void request(uint64_t frame, float distance);
+        //resident image, counted against the cache budget once nothing uses the texture
+        uint64_t getMemorySize() const { return image ? image->getSize() : 0; }
 
         std::unique_ptr<Image> image;
         vk::UniqueHandle<vk::ImageView, vk::DispatchLoaderDynamic> image_view;
         vk::UniqueHandle<vk::Sampler, vk::DispatchLoaderDynamic> sampler;
+        //static raytracing texture array indices that sample this texture (guarded by Renderer::acceleration_binding_mutex)
+        std::vector<uint32_t> static_bindings;
 
     protected:
         Texture() = default;
 
         uint32_t width {0};
         uint32_t height {0};
+        uint32_t mip_levels {1};
+        uint32_t base_level {0};
+        std::atomic<uint64_t> requested_frame {0};
+        std::atomic<float> requested_distance {0.f};
+
+        struct ContentEntry
+        {
+            std::weak_ptr<Texture> texture;
+            //the content the texture was loaded from, read again (empty if it can't be, so it's never aliased)
+            std::function<std::vector<uint8_t>()> read;
+        };
 
-        inline static std::unordered_map<std::string, std::weak_ptr<Texture>> texture_map{};
+        friend class TextureStreamer;
+        inline static AssetCache<Texture> texture_cache{};
+        inline static std::unordered_map<uint64_t, ContentEntry> content_map{};
+        inline static std::mutex content_mutex;
+        inline static std::atomic<uint64_t> deduplicated_bytes{ 0 };
     };
 
     class TextureLoader
@@ -69,6 +130,13 @@ namespace lotus
         void setEngine(Engine* _engine) { engine = _engine; }
         virtual ~TextureLoader() = default;
         virtual void LoadTexture(std::shared_ptr<Texture>&) = 0;
+        //hash of everything that determines the loaded texture, so identical ones can be shared (0 never matches)
+        virtual uint64_t getContentHash() const { return 0; }
+        virtual size_t getContentSize() const { return 0; }
+        //reads the hashed content again later, for checking a texture with the same hash byte for byte
+        //  (kept by the texture instead of a copy of the content)
+        virtual std::function<std::vector<uint8_t>()> getContentReader() const { return {}; }
+        virtual bool matchesContent(const std::vector<uint8_t>& content) const { return false; }
     protected:
         Engine* engine {nullptr};
     };
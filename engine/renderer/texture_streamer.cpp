@@ -0,0 +1,371 @@
+#include "texture_streamer.h"
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+#include "mipmap.h"
+#include "upload_batcher.h"
+#include "engine/core.h"
+#include "engine/game.h"
+#include "engine/entity/renderable_entity.h"
+
+namespace lotus
+{
+    TextureStreamer::TextureStreamer(Engine* _engine, uint32_t frames_in_flight) : engine(_engine), retired(frames_in_flight), descriptor_updates(frames_in_flight)
+    {
+    }
+
+    uint32_t TextureStreamer::getInitialLevel(uint32_t width, uint32_t height, uint32_t mip_levels) const
+    {
+        const auto& config = engine->config->renderer;
+        if (!config.texture_streaming)
+            return 0;
+        uint32_t level = 0;
+        while (level + 1 < mip_levels && std::max(Mipmap::getLevelDimension(width, level), Mipmap::getLevelDimension(height, level)) > config.texture_streaming_min_dimension)
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    std::pair<std::unique_ptr<Image>, vk::UniqueHandle<vk::ImageView, vk::DispatchLoaderDynamic>> TextureStreamer::createImage(const Texture& texture, vk::Format format, uint32_t base_level) const
+    {
+        uint32_t levels = texture.getMipLevels() - base_level;
+        auto image = engine->renderer.memory_manager->GetImage(Mipmap::getLevelDimension(texture.getWidth(), base_level), Mipmap::getLevelDimension(texture.getHeight(), base_level), format,
+            vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, levels, MemoryCategory::Texture);
+
+        vk::ImageViewCreateInfo image_view_info;
+        image_view_info.image = image->image;
+        image_view_info.viewType = vk::ImageViewType::e2D;
+        image_view_info.format = format;
+        image_view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+        image_view_info.subresourceRange.baseMipLevel = 0;
+        image_view_info.subresourceRange.levelCount = levels;
+        image_view_info.subresourceRange.baseArrayLayer = 0;
+        image_view_info.subresourceRange.layerCount = 1;
+
+        auto image_view = engine->renderer.device->createImageViewUnique(image_view_info, nullptr);
+        return { std::move(image), std::move(image_view) };
+    }
+
+    void TextureStreamer::registerTexture(const std::shared_ptr<Texture>& texture, vk::Format format, std::vector<uint8_t>&& data, Reload reload)
+    {
+        Entry entry;
+        entry.texture = texture;
+        entry.format = format;
+        entry.size = data.size();
+        entry.data = std::move(data);
+        entry.reload = std::move(reload);
+        for (uint32_t level = 0; level < texture->getMipLevels(); ++level)
+        {
+            entry.level_offsets.push_back(Mipmap::getLevelOffset(format, texture->getWidth(), texture->getHeight(), level));
+        }
+        entry.min_level = texture->getBaseLevel();
+        entry.target_level = texture->getBaseLevel();
+
+        std::lock_guard lk{ mutex };
+        entries.push_back(std::move(entry));
+    }
+
+    vk::DeviceSize TextureStreamer::getResidentSize(const Entry& entry, uint32_t level) const
+    {
+        return entry.size - entry.level_offsets[level];
+    }
+
+    bool TextureStreamer::hasLevels(Entry& entry, uint32_t level)
+    {
+        if (entry.reloading && entry.reloading->done)
+        {
+            //a source that can't be read again leaves the texture at the levels it still has
+            if (entry.reloading->data.size() == entry.size)
+            {
+                entry.data = std::move(entry.reloading->data);
+                entry.data_level = 0;
+                ++reloads;
+            }
+            else
+            {
+                entry.reload = {};
+            }
+            entry.reloading.reset();
+        }
+        if (level >= entry.data_level)
+            return true;
+        if (!entry.reloading && entry.reload)
+        {
+            auto result = std::make_shared<ReloadResult>();
+            entry.reloading = result;
+            engine->worker_pool.addWork(std::make_unique<LambdaWorkItem>([result, reload = entry.reload](WorkerThread*)
+            {
+                result->data = reload();
+                result->done = true;
+            }));
+        }
+        return false;
+    }
+
+    void TextureStreamer::schedule(Entry& entry, const std::shared_ptr<Texture>& texture, uint32_t level)
+    {
+        auto [image, image_view] = createImage(*texture, entry.format, level);
+        auto offset = entry.level_offsets[level] - entry.level_offsets[entry.data_level];
+        std::vector<uint8_t> data(entry.data.begin() + offset, entry.data.end());
+        uploaded_bytes += data.size();
+        auto regions = Mipmap::getCopyRegions(entry.format, texture->getWidth(), texture->getHeight(), level, texture->getMipLevels());
+        entry.upload_ticket = engine->renderer.upload_batcher->streamImage(image->image, std::move(regions), std::move(data));
+        entry.pending_image = std::move(image);
+        entry.pending_image_view = std::move(image_view);
+        entry.target_level = level;
+    }
+
+    void TextureStreamer::retire(uint32_t frame_index)
+    {
+        std::lock_guard lk{ mutex };
+        auto& frame_retired = retired[frame_index];
+        frame_retired.command_buffers.clear();
+        frame_retired.image_views.clear();
+        frame_retired.images.clear();
+    }
+
+    void TextureStreamer::swapPending(uint32_t frame_index)
+    {
+        //every swapped upload was submitted in an earlier frame, so it's copied before this frame's work reads the new image
+        //  and frames still in flight keep using the old one until this frame's slot is retired
+        auto& frame_retired = retired[frame_index];
+        std::unordered_set<Texture*> swapped;
+        for (auto& entry : entries)
+        {
+            //the batcher may still be holding the upload back for budget
+            if (!entry.pending_image || !engine->renderer.upload_batcher->isSubmitted(entry.upload_ticket))
+                continue;
+            if (auto texture = entry.texture.lock())
+            {
+                frame_retired.images.push_back(std::move(texture->image));
+                frame_retired.image_views.push_back(std::move(texture->image_view));
+                texture->image = std::move(entry.pending_image);
+                texture->image_view = std::move(entry.pending_image_view);
+                texture->setBaseLevel(entry.target_level);
+                swapped.insert(texture.get());
+                for (auto& updates : descriptor_updates)
+                {
+                    updates.push_back(texture);
+                }
+                //with the whole chain resident, the CPU only needs what an eviction uploads
+                if (entry.target_level == 0 && entry.reload && entry.data_level < entry.min_level)
+                {
+                    auto offset = entry.level_offsets[entry.min_level] - entry.level_offsets[entry.data_level];
+                    entry.data.erase(entry.data.begin(), entry.data.begin() + offset);
+                    entry.data.shrink_to_fit();
+                    entry.data_level = entry.min_level;
+                }
+            }
+            else
+            {
+                //the copy into it may still be running
+                frame_retired.images.push_back(std::move(entry.pending_image));
+                frame_retired.image_views.push_back(std::move(entry.pending_image_view));
+            }
+            entry.pending_image.reset();
+            entry.pending_image_view.reset();
+        }
+        //an unsubmitted upload still has its image in the batcher, so the entry waits for it
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const auto& entry) { return entry.texture.expired() && !entry.pending_image; }), entries.end());
+        {
+            std::lock_guard content_lk{ Texture::content_mutex };
+            std::erase_if(Texture::content_map, [](const auto& texture) { return texture.second.texture.expired(); });
+        }
+
+        //static command buffers push the image views directly, so anything drawing a swapped texture has to be re-recorded
+        //  (the old buffers may still be executing, so they're retired with the images)
+        bool rerecord = false;
+        engine->game->scene->forEachEntity([this, &swapped, &frame_retired, &rerecord](std::shared_ptr<Entity>& entity)
+        {
+            auto renderable_entity = dynamic_cast<RenderableEntity*>(entity.get());
+            if (!renderable_entity)
+                return;
+            bool uses_swapped = std::any_of(renderable_entity->models.begin(), renderable_entity->models.end(), [&swapped](const auto& model)
+            {
+                return std::any_of(model->meshes.begin(), model->meshes.end(), [&swapped](const auto& mesh) { return swapped.contains(mesh->texture.get()); });
+            });
+            if (uses_swapped)
+            {
+                if (auto work = entity->recreate_command_buffers(entity))
+                {
+                    std::move(renderable_entity->command_buffers.begin(), renderable_entity->command_buffers.end(), std::back_inserter(frame_retired.command_buffers));
+                    std::move(renderable_entity->shadowmap_buffers.begin(), renderable_entity->shadowmap_buffers.end(), std::back_inserter(frame_retired.command_buffers));
+                    engine->worker_pool.addWork(std::move(work));
+                    rerecord = true;
+                }
+            }
+        });
+        //the pool is otherwise idle here, so this only waits for the re-recording this frame's render needs
+        if (rerecord)
+            engine->worker_pool.waitIdle();
+    }
+
+    void TextureStreamer::updateDescriptors(uint32_t frame_index)
+    {
+        auto& updates = descriptor_updates[frame_index];
+        if (updates.empty())
+            return;
+        //each frame's set is only written once its fence has been waited on, so nothing in flight is reading it
+        if (engine->renderer.RaytraceEnabled())
+        {
+            std::lock_guard lk{ engine->renderer.acceleration_binding_mutex };
+            std::vector<std::shared_ptr<Texture>> textures;
+            for (const auto& weak : updates)
+            {
+                if (auto texture = weak.lock())
+                    textures.push_back(std::move(texture));
+            }
+            std::vector<vk::DescriptorImageInfo> image_infos;
+            for (const auto& texture : textures)
+            {
+                image_infos.insert(image_infos.end(), texture->static_bindings.size(), vk::DescriptorImageInfo{ *texture->sampler, *texture->image_view, vk::ImageLayout::eShaderReadOnlyOptimal });
+            }
+            std::vector<vk::WriteDescriptorSet> writes;
+            size_t info_index = 0;
+            for (const auto& texture : textures)
+            {
+                for (auto binding : texture->static_bindings)
+                {
+                    vk::WriteDescriptorSet write_info_texture;
+                    write_info_texture.dstSet = *engine->renderer.rtx_descriptor_sets_const[frame_index];
+                    write_info_texture.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                    write_info_texture.dstArrayElement = binding;
+                    write_info_texture.dstBinding = 3;
+                    write_info_texture.descriptorCount = 1;
+                    write_info_texture.pImageInfo = &image_infos[info_index];
+                    writes.push_back(write_info_texture);
+                    ++info_index;
+                }
+            }
+            if (!writes.empty())
+                engine->renderer.device->updateDescriptorSets(writes, nullptr);
+        }
+        updates.clear();
+    }
+
+    void TextureStreamer::update(uint32_t frame_index)
+    {
+        std::lock_guard lk{ mutex };
+
+        bool pending = std::any_of(entries.begin(), entries.end(), [this](const auto& entry)
+        {
+            return entry.pending_image && engine->renderer.upload_batcher->isSubmitted(entry.upload_ticket);
+        });
+        if (pending)
+            swapPending(frame_index);
+        updateDescriptors(frame_index);
+
+        const vk::DeviceSize budget = static_cast<vk::DeviceSize>(engine->config->renderer.texture_budget) * 1024 * 1024;
+        const vk::DeviceSize upload_budget = static_cast<vk::DeviceSize>(engine->config->renderer.upload_budget) * 1024 * 1024;
+        vk::DeviceSize resident = 0;
+
+        struct Candidate
+        {
+            Entry* entry;
+            std::shared_ptr<Texture> texture;
+            bool requested;
+            float distance;
+        };
+        std::vector<Candidate> upgrades;
+        std::vector<Candidate> evictable;
+        for (auto& entry : entries)
+        {
+            resident += getResidentSize(entry, entry.target_level);
+            auto texture = entry.texture.lock();
+            //a texture can only have one upload in flight
+            if (!texture || entry.pending_image)
+                continue;
+            //requests made while rendering last frame
+            bool requested = texture->requested_frame == frame;
+            Candidate candidate{ &entry, texture, requested, texture->requested_distance };
+            if (requested && entry.target_level > 0)
+                upgrades.push_back(candidate);
+            else if (entry.target_level < entry.min_level)
+                evictable.push_back(candidate);
+        }
+
+        //nearest first for uploads; unrequested (oldest first) then farthest first for evictions
+        std::sort(upgrades.begin(), upgrades.end(), [](const auto& a, const auto& b) { return a.distance < b.distance; });
+        std::sort(evictable.begin(), evictable.end(), [](const auto& a, const auto& b)
+        {
+            if (a.requested != b.requested)
+                return !a.requested;
+            if (!a.requested)
+                return a.texture->requested_frame < b.texture->requested_frame;
+            return a.distance > b.distance;
+        });
+
+        size_t evict_index = 0;
+        auto evict = [&](const Candidate* incoming)
+        {
+            auto& victim = evictable[evict_index];
+            //never give up something at least as close as what it would make room for
+            if (victim.requested && (!incoming || victim.distance <= incoming->distance))
+                return false;
+            ++evict_index;
+            resident -= getResidentSize(*victim.entry, victim.entry->target_level) - getResidentSize(*victim.entry, victim.entry->min_level);
+            schedule(*victim.entry, victim.texture, victim.entry->min_level);
+            ++evictions;
+            return true;
+        };
+
+        //don't queue more behind uploads the batcher hasn't caught up with yet, or while memory is being asked back
+        if (engine->renderer.upload_batcher->getStats().deferred_uploads > 0 || eviction_request > 0)
+            upgrades.clear();
+
+        vk::DeviceSize uploaded = 0;
+        for (const auto& candidate : upgrades)
+        {
+            vk::DeviceSize size = getResidentSize(*candidate.entry, 0);
+            vk::DeviceSize needed = size - getResidentSize(*candidate.entry, candidate.entry->target_level);
+            //more than a frame's upload budget would only sit in the batcher with its image already allocated
+            if (uploaded > 0 && uploaded + size > upload_budget)
+                break;
+            //dropped levels are reloaded first, and the texture is picked up again once they're back
+            if (!hasLevels(*candidate.entry, 0))
+                continue;
+            while (resident + needed > budget && evict_index < evictable.size() && evict(&candidate));
+            //the texture category's budget also counts textures that aren't streamed
+            if (resident + needed > budget || !engine->renderer.memory_manager->fitsBudget(MemoryCategory::Texture, size))
+                break;
+            resident += needed;
+            uploaded += size;
+            schedule(*candidate.entry, candidate.texture, 0);
+        }
+
+        //the budget can also shrink, or loads can add more than it allows
+        vk::DeviceSize target = std::min(budget, resident - std::min(resident, eviction_request));
+        eviction_request = 0;
+        while (resident > target && evict_index < evictable.size() && evict(nullptr));
+
+        ++frame;
+    }
+
+    void TextureStreamer::requestEviction(vk::DeviceSize bytes)
+    {
+        std::lock_guard lk{ mutex };
+        eviction_request = std::max(eviction_request, bytes);
+    }
+
+    TextureStreamer::Stats TextureStreamer::getStats() const
+    {
+        std::lock_guard lk{ mutex };
+        Stats stats;
+        stats.textures = entries.size();
+        stats.budget = static_cast<vk::DeviceSize>(engine->config->renderer.texture_budget) * 1024 * 1024;
+        stats.uploaded_bytes = uploaded_bytes;
+        stats.evictions = evictions;
+        stats.reloads = reloads;
+        for (const auto& entry : entries)
+        {
+            stats.resident_bytes += getResidentSize(entry, entry.target_level);
+            stats.cpu_bytes += entry.data.size();
+            if (entry.target_level < entry.min_level)
+                ++stats.streamed;
+            if (entry.pending_image)
+                ++stats.pending;
+        }
+        return stats;
+    }
+}
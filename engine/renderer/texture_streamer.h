@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+#include "texture.h"
+
+namespace lotus
+{
+    class Engine;
+
+    //keeps every registered texture's smallest mips resident, and streams in the full chain for textures that visible meshes request
+    //nearest textures win when over budget, and unrequested ones are evicted least recently used first
+    class TextureStreamer
+    {
+    public:
+        struct Stats
+        {
+            size_t textures{ 0 };
+            //textures with their full chain resident (or on the way)
+            size_t streamed{ 0 };
+            //uploads waiting to be swapped in
+            size_t pending{ 0 };
+            vk::DeviceSize resident_bytes{ 0 };
+            vk::DeviceSize budget{ 0 };
+            //mip data kept on the CPU to stream from
+            size_t cpu_bytes{ 0 };
+            uint64_t uploaded_bytes{ 0 };
+            uint64_t evictions{ 0 };
+            //full chains read back from their source after being dropped
+            uint64_t reloads{ 0 };
+        };
+
+        //returns the full mip chain again, after the streamer has dropped the levels it no longer needed
+        using Reload = std::function<std::vector<uint8_t>()>;
+
+        TextureStreamer(Engine* engine, uint32_t frames_in_flight);
+
+        //level a new texture's image should start from (0 if streaming is off or the texture is small already)
+        uint32_t getInitialLevel(uint32_t width, uint32_t height, uint32_t mip_levels) const;
+        //image and view holding levels [base_level, mip_levels) of the texture
+        std::pair<std::unique_ptr<Image>, vk::UniqueHandle<vk::ImageView, vk::DispatchLoaderDynamic>> createImage(const Texture& texture, vk::Format format, uint32_t base_level) const;
+        //data is the full mip chain to upload levels from as the texture streams in and out
+        //with reload, only the low levels are kept once the full chain is resident, and the rest is reloaded (on a worker) when needed again
+        void registerTexture(const std::shared_ptr<Texture>& texture, vk::Format format, std::vector<uint8_t>&& data, Reload reload = {});
+        void request(Texture* texture, float distance) { texture->request(frame, distance); }
+
+        //frame_index's fence has been waited on, so the images (and command buffers) it replaced can be destroyed
+        void retire(uint32_t frame_index);
+        //once per frame, while no work is running: swaps in finished uploads and starts the next ones
+        void update(uint32_t frame_index);
+        //the next update evicts at least this much (if it has anything unrequested left to evict)
+        void requestEviction(vk::DeviceSize bytes);
+        Stats getStats() const;
+
+    private:
+        struct ReloadResult
+        {
+            std::vector<uint8_t> data;
+            std::atomic<bool> done{ false };
+        };
+        struct Entry
+        {
+            std::weak_ptr<Texture> texture;
+            vk::Format format{};
+            //levels [data_level, mip_levels) of the chain
+            std::vector<uint8_t> data;
+            uint32_t data_level{ 0 };
+            Reload reload;
+            std::shared_ptr<ReloadResult> reloading;
+            //offsets into the full chain, and its size
+            std::vector<size_t> level_offsets;
+            size_t size{ 0 };
+            uint32_t min_level{ 0 };
+            //level the texture has once its pending upload is swapped in
+            uint32_t target_level{ 0 };
+            std::unique_ptr<Image> pending_image;
+            vk::UniqueHandle<vk::ImageView, vk::DispatchLoaderDynamic> pending_image_view;
+            uint64_t upload_ticket{ 0 };
+        };
+
+        //what a swap replaced, kept until every frame that could have used it has finished
+        struct Retired
+        {
+            std::vector<std::unique_ptr<Image>> images;
+            std::vector<vk::UniqueHandle<vk::ImageView, vk::DispatchLoaderDynamic>> image_views;
+            std::vector<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>> command_buffers;
+        };
+
+        vk::DeviceSize getResidentSize(const Entry& entry, uint32_t level) const;
+        //false if the levels have been dropped (a reload is started for them)
+        bool hasLevels(Entry& entry, uint32_t level);
+        void schedule(Entry& entry, const std::shared_ptr<Texture>& texture, uint32_t level);
+        void swapPending(uint32_t frame_index);
+        void updateDescriptors(uint32_t frame_index);
+
+        Engine* engine;
+        mutable std::mutex mutex;
+        std::vector<Entry> entries;
+        //by frame in flight
+        std::vector<Retired> retired;
+        //swapped textures whose raytracing descriptors still point at the old view in that frame's set
+        std::vector<std::vector<std::weak_ptr<Texture>>> descriptor_updates;
+        //requests are tagged with the frame they were made in; 0 is never
+        uint64_t frame{ 1 };
+        uint64_t uploaded_bytes{ 0 };
+        uint64_t evictions{ 0 };
+        uint64_t reloads{ 0 };
+        vk::DeviceSize eviction_request{ 0 };
+    };
+}
@@ -0,0 +1,435 @@
+#include "upload_batcher.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+#include "engine/core.h"
+
+namespace lotus
+{
+    UploadBatcher::UploadBatcher(Engine* _engine, uint32_t frames_in_flight) : engine(_engine)
+    {
+        //buffer -> image copies need offsets aligned to the texel block size, which 16 covers for every format used
+        alignment = std::max<vk::DeviceSize>(alignment, engine->renderer.properties.properties.limits.optimalBufferCopyOffsetAlignment);
+        ring_size = static_cast<vk::DeviceSize>(std::max(engine->config->renderer.staging_buffer_size, 1u)) * 1024 * 1024 / alignment * alignment;
+        ring = engine->renderer.memory_manager->GetBuffer(ring_size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging);
+        ring_data = static_cast<uint8_t*>(ring->map(0, ring_size, {}));
+
+        auto [graphics, present, compute, transfer] = engine->renderer.getQueueFamilies(engine->renderer.physical_device);
+        graphics_family = graphics.value();
+        if (engine->config->renderer.async_uploads && engine->renderer.transfer_queue)
+        {
+            transfer_family = transfer;
+        }
+
+        vk::CommandPoolCreateInfo pool_info = {};
+        pool_info.queueFamilyIndex = graphics_family;
+        pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+        command_pool = engine->renderer.device->createCommandPoolUnique(pool_info, nullptr);
+
+        vk::CommandBufferAllocateInfo alloc_info = {};
+        alloc_info.level = vk::CommandBufferLevel::ePrimary;
+        alloc_info.commandPool = *command_pool;
+        alloc_info.commandBufferCount = frames_in_flight;
+        auto command_buffers = engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
+
+        frames.resize(frames_in_flight);
+        for (uint32_t i = 0; i < frames_in_flight; ++i)
+        {
+            frames[i].command_buffer = std::move(command_buffers[i]);
+        }
+
+        if (transfer_family)
+        {
+            pool_info.queueFamilyIndex = transfer_family.value();
+            transfer_command_pool = engine->renderer.device->createCommandPoolUnique(pool_info, nullptr);
+            alloc_info.commandPool = *transfer_command_pool;
+            auto transfer_command_buffers = engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
+            for (uint32_t i = 0; i < frames_in_flight; ++i)
+            {
+                frames[i].transfer_command_buffer = std::move(transfer_command_buffers[i]);
+                frames[i].transfer_semaphore = engine->renderer.device->createSemaphoreUnique({}, nullptr);
+            }
+            stats.async = true;
+        }
+
+        if (engine->renderer.physical_device.getQueueFamilyProperties()[graphics_family].timestampValidBits > 0)
+        {
+            vk::QueryPoolCreateInfo query_info;
+            query_info.queryType = vk::QueryType::eTimestamp;
+            query_info.queryCount = frames_in_flight * 2;
+            query_pool = engine->renderer.device->createQueryPoolUnique(query_info, nullptr);
+            timestamp_period = engine->renderer.properties.properties.limits.timestampPeriod;
+        }
+    }
+
+    UploadBatcher::~UploadBatcher()
+    {
+        for (auto& frame : frames)
+        {
+            for (auto& buffer : frame.overflow)
+                buffer->unmap();
+        }
+        for (auto& buffer : overflow)
+            buffer->unmap();
+        ring->unmap();
+    }
+
+    std::optional<vk::DeviceSize> UploadBatcher::allocateRing(vk::DeviceSize size)
+    {
+        vk::DeviceSize aligned = (size + alignment - 1) / alignment * alignment;
+        if (aligned > ring_size)
+            return {};
+        uint64_t start = ring_head;
+        //allocations never wrap around the end, the remainder is skipped instead
+        if (start % ring_size + aligned > ring_size)
+            start += ring_size - start % ring_size;
+        if (start + aligned - ring_tail > ring_size)
+            return {};
+        ring_head = start + aligned;
+        return start % ring_size;
+    }
+
+    UploadBatcher::Staging UploadBatcher::allocate(vk::DeviceSize size)
+    {
+        if (auto offset = allocateRing(size))
+        {
+            return { ring->buffer, ring_data + *offset, *offset };
+        }
+        auto buffer = engine->renderer.memory_manager->GetBuffer(size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging);
+        Staging staging{ buffer->buffer, static_cast<uint8_t*>(buffer->map(0, size, {})), 0 };
+        overflow.push_back(std::move(buffer));
+        ++stats.overflow_uploads;
+        return staging;
+    }
+
+    void UploadBatcher::rebase(std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize offset)
+    {
+        for (auto& region : regions)
+        {
+            region.bufferOffset += offset;
+        }
+    }
+
+    void UploadBatcher::uploadBuffer(vk::Buffer target, vk::DeviceSize target_offset, const void* data, vk::DeviceSize size)
+    {
+        if (size == 0)
+            return;
+        std::unique_lock lk{ mutex };
+        auto staging = allocate(size);
+        staged_bytes += size;
+        ++staging_in_progress;
+        //the space is ours now, so the copy into it doesn't need to hold up other threads
+        lk.unlock();
+        memcpy(staging.data, data, size);
+        lk.lock();
+        buffer_uploads.push_back({ staging.buffer, target, vk::BufferCopy{ staging.offset, target_offset, size } });
+        if (--staging_in_progress == 0)
+            staging_done.notify_all();
+    }
+
+    void UploadBatcher::uploadImage(vk::Image target, std::vector<vk::BufferImageCopy> regions, const void* data, vk::DeviceSize size)
+    {
+        if (size == 0 || regions.empty())
+            return;
+        std::unique_lock lk{ mutex };
+        auto staging = allocate(size);
+        staged_bytes += size;
+        ++staging_in_progress;
+        lk.unlock();
+        memcpy(staging.data, data, size);
+        rebase(regions, staging.offset);
+        lk.lock();
+        image_uploads.push_back({ staging.buffer, target, std::move(regions) });
+        if (--staging_in_progress == 0)
+            staging_done.notify_all();
+    }
+
+    uint64_t UploadBatcher::streamImage(vk::Image target, std::vector<vk::BufferImageCopy> regions, std::vector<uint8_t>&& data)
+    {
+        std::lock_guard lk{ mutex };
+        uint64_t ticket = next_ticket++;
+        deferred.push_back({ ticket, { nullptr, target, std::move(regions) }, std::move(data) });
+        return ticket;
+    }
+
+    bool UploadBatcher::isSubmitted(uint64_t ticket) const
+    {
+        std::lock_guard lk{ mutex };
+        return ticket <= submitted_ticket;
+    }
+
+    void UploadBatcher::retire(uint32_t frame)
+    {
+        std::lock_guard lk{ mutex };
+        auto& retired = frames[frame];
+        ring_tail = std::max(ring_tail, retired.ring_head);
+        for (auto& buffer : retired.overflow)
+            buffer->unmap();
+        retired.overflow.clear();
+
+        if (retired.timed)
+        {
+            std::array<uint64_t, 2> timestamps{};
+            if (engine->renderer.device->getQueryPoolResults(*query_pool, frame * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess)
+            {
+                stats.graphics_time += std::chrono::nanoseconds(static_cast<int64_t>((timestamps[1] - timestamps[0]) * static_cast<double>(timestamp_period)));
+                ++stats.timed_frames;
+            }
+            retired.timed = false;
+        }
+    }
+
+    void UploadBatcher::stageDeferred()
+    {
+        //streaming uploads get whatever budget is left after this frame's loads, but an otherwise empty frame always takes one
+        const vk::DeviceSize budget = static_cast<vk::DeviceSize>(engine->config->renderer.upload_budget) * 1024 * 1024;
+        while (!deferred.empty())
+        {
+            auto& upload = deferred.front();
+            vk::DeviceSize size = upload.data.size();
+            std::optional<Staging> staging;
+            if (staged_bytes == 0)
+            {
+                staging = allocate(size);
+            }
+            else if (staged_bytes + size <= budget)
+            {
+                if (auto offset = allocateRing(size))
+                    staging = Staging{ ring->buffer, ring_data + *offset, *offset };
+            }
+            if (!staging)
+                break;
+            memcpy(staging->data, upload.data.data(), size);
+            upload.upload.source = staging->buffer;
+            rebase(upload.upload.regions, staging->offset);
+            image_uploads.push_back(std::move(upload.upload));
+            staged_bytes += size;
+            submitted_ticket = upload.ticket;
+            deferred.pop_front();
+        }
+    }
+
+    void UploadBatcher::recordCopies(vk::CommandBuffer command_buffer, std::vector<vk::ImageMemoryBarrier>& barriers)
+    {
+        for (const auto& upload : image_uploads)
+        {
+            auto [min_level, max_level] = std::minmax_element(upload.regions.begin(), upload.regions.end(), [](const auto& a, const auto& b)
+            {
+                return a.imageSubresource.mipLevel < b.imageSubresource.mipLevel;
+            });
+            vk::ImageMemoryBarrier barrier;
+            barrier.oldLayout = vk::ImageLayout::eUndefined;
+            barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = upload.target;
+            barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+            barrier.subresourceRange.baseMipLevel = min_level->imageSubresource.mipLevel;
+            barrier.subresourceRange.levelCount = max_level->imageSubresource.mipLevel - min_level->imageSubresource.mipLevel + 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+            barrier.srcAccessMask = {};
+            barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barriers.push_back(barrier);
+        }
+        if (!barriers.empty())
+            command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barriers);
+
+        //one copy command per source/target pair
+        std::sort(buffer_uploads.begin(), buffer_uploads.end(), [](const auto& a, const auto& b)
+        {
+            return std::tie(a.target, a.source) < std::tie(b.target, b.source);
+        });
+        std::vector<vk::BufferCopy> regions;
+        for (size_t i = 0; i < buffer_uploads.size(); ++i)
+        {
+            const auto& upload = buffer_uploads[i];
+            regions.push_back(upload.region);
+            if (i + 1 == buffer_uploads.size() || buffer_uploads[i + 1].target != upload.target || buffer_uploads[i + 1].source != upload.source)
+            {
+                command_buffer.copyBuffer(upload.source, upload.target, regions);
+                regions.clear();
+            }
+        }
+
+        //every copy covers a whole mip level, so even a transfer queue's image granularity allows it
+        for (const auto& upload : image_uploads)
+        {
+            command_buffer.copyBufferToImage(upload.source, upload.target, vk::ImageLayout::eTransferDstOptimal, upload.regions);
+        }
+
+        for (auto& barrier : barriers)
+        {
+            barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+            barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        }
+    }
+
+    UploadBatcher::Submission UploadBatcher::flush(uint32_t frame)
+    {
+        std::unique_lock lk{ mutex };
+        //space allocated before this point is charged to this frame, so its copy has to be recorded here too
+        staging_done.wait(lk, [this]() { return staging_in_progress == 0; });
+
+        stageDeferred();
+
+        auto& current = frames[frame];
+        current.ring_head = ring_head;
+        std::move(overflow.begin(), overflow.end(), std::back_inserter(current.overflow));
+        overflow.clear();
+        stats.frame_bytes = staged_bytes;
+        stats.uploaded_bytes += staged_bytes;
+        stats.deferred_uploads = deferred.size();
+        staged_bytes = 0;
+
+        if (buffer_uploads.empty() && image_uploads.empty())
+            return {};
+
+        //covers everything drawn, built or traced from the new data, since all of it is submitted after this
+        vk::AccessFlags buffer_access = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead;
+        vk::PipelineStageFlags dst_stages = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eFragmentShader;
+        if (engine->renderer.RaytraceEnabled())
+        {
+            buffer_access |= vk::AccessFlagBits::eAccelerationStructureReadKHR;
+            dst_stages |= vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR | vk::PipelineStageFlagBits::eRayTracingShaderKHR;
+        }
+
+        vk::CommandBufferBeginInfo begin_info = {};
+        begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+        auto command_buffer = *current.command_buffer;
+        command_buffer.reset({});
+        std::vector<vk::ImageMemoryBarrier> image_barriers;
+        Submission submission;
+        submission.command_buffer = command_buffer;
+        auto begin_recording = [&]()
+        {
+            command_buffer.begin(begin_info);
+            if (query_pool)
+            {
+                command_buffer.resetQueryPool(*query_pool, frame * 2, 2);
+                command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *query_pool, frame * 2);
+            }
+        };
+        auto end_recording = [&]()
+        {
+            if (query_pool)
+            {
+                command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *query_pool, frame * 2 + 1);
+                current.timed = true;
+            }
+            command_buffer.end();
+        };
+
+        if (!transfer_family)
+        {
+            begin_recording();
+            recordCopies(command_buffer, image_barriers);
+            vk::MemoryBarrier buffer_barrier;
+            buffer_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            buffer_barrier.dstAccessMask = buffer_access;
+            command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dst_stages, {}, buffer_barrier, nullptr, image_barriers);
+            end_recording();
+        }
+        else
+        {
+            auto transfer_command_buffer = *current.transfer_command_buffer;
+            transfer_command_buffer.reset({});
+            transfer_command_buffer.begin(begin_info);
+            recordCopies(transfer_command_buffer, image_barriers);
+
+            //release: the same barriers are repeated on the graphics queue to acquire
+            auto buffer_barriers = getBufferBarriers();
+            for (auto& barrier : buffer_barriers)
+            {
+                barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                barrier.srcQueueFamilyIndex = transfer_family.value();
+                barrier.dstQueueFamilyIndex = graphics_family;
+            }
+            for (auto& barrier : image_barriers)
+            {
+                barrier.srcQueueFamilyIndex = transfer_family.value();
+                barrier.dstQueueFamilyIndex = graphics_family;
+                barrier.dstAccessMask = {};
+            }
+            transfer_command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, buffer_barriers, image_barriers);
+            transfer_command_buffer.end();
+
+            vk::SubmitInfo submit_info;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &transfer_command_buffer;
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &*current.transfer_semaphore;
+            engine->renderer.transfer_queue.submit(submit_info, nullptr);
+
+            //acquire
+            for (auto& barrier : buffer_barriers)
+            {
+                barrier.srcAccessMask = {};
+                barrier.dstAccessMask = buffer_access;
+            }
+            for (auto& barrier : image_barriers)
+            {
+                barrier.srcAccessMask = {};
+                barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            }
+            begin_recording();
+            command_buffer.pipelineBarrier(dst_stages, dst_stages, {}, nullptr, buffer_barriers, image_barriers);
+            end_recording();
+
+            submission.wait_semaphore = *current.transfer_semaphore;
+            submission.wait_stages = dst_stages;
+        }
+
+        buffer_uploads.clear();
+        image_uploads.clear();
+        return submission;
+    }
+
+    std::vector<vk::BufferMemoryBarrier> UploadBatcher::getBufferBarriers() const
+    {
+        std::vector<vk::BufferCopy> ranges;
+        std::vector<vk::BufferMemoryBarrier> barriers;
+        auto merge = [&](vk::Buffer target)
+        {
+            std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.dstOffset < b.dstOffset; });
+            for (const auto& range : ranges)
+            {
+                if (!barriers.empty() && barriers.back().buffer == target)
+                {
+                    auto& last = barriers.back();
+                    //a range written twice would need the first write's ownership kept
+                    assert(range.dstOffset >= last.offset + last.size);
+                    if (range.dstOffset == last.offset + last.size)
+                    {
+                        last.size += range.size;
+                        continue;
+                    }
+                }
+                barriers.emplace_back(vk::AccessFlags{}, vk::AccessFlags{}, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, target, range.dstOffset, range.size);
+            }
+            ranges.clear();
+        };
+        //sorted by target by recordCopies
+        for (size_t i = 0; i < buffer_uploads.size(); ++i)
+        {
+            ranges.push_back(buffer_uploads[i].region);
+            if (i + 1 == buffer_uploads.size() || buffer_uploads[i + 1].target != buffer_uploads[i].target)
+                merge(buffer_uploads[i].target);
+        }
+        return barriers;
+    }
+
+    UploadBatcher::Stats UploadBatcher::getStats() const
+    {
+        std::lock_guard lk{ mutex };
+        auto current = stats;
+        current.deferred_uploads = deferred.size();
+        return current;
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <engine/renderer/vulkan/vulkan_inc.h>
+#include "memory.h"
+
+namespace lotus
+{
+    class Engine;
+
+    //stages every asset upload through one persistently mapped ring buffer, and records a frame's copies into a single command buffer
+    //ring space is handed back once the frame that copied out of it has finished (by its frame fence)
+    //on devices with a transfer-only queue family, the copies run there and ownership is handed to the graphics queue afterwards
+    class UploadBatcher
+    {
+    public:
+        struct Stats
+        {
+            uint64_t uploaded_bytes{ 0 };
+            //bytes copied by the last flushed frame
+            vk::DeviceSize frame_bytes{ 0 };
+            //uploads that didn't fit the ring and got a staging buffer of their own
+            uint64_t overflow_uploads{ 0 };
+            //streaming uploads waiting for a frame with budget left
+            size_t deferred_uploads{ 0 };
+            //copies run on the transfer queue
+            bool async{ false };
+            //GPU time the graphics queue spent on frames' uploads (all the copies, or only the acquire barriers when async),
+            //  summed over the frames that uploaded anything (none if the queue can't write timestamps)
+            std::chrono::nanoseconds graphics_time{ 0 };
+            uint64_t timed_frames{ 0 };
+        };
+
+        struct Submission
+        {
+            //goes ahead of the work items' graphics command buffers (null if nothing was uploaded)
+            vk::CommandBuffer command_buffer;
+            //set when the copies ran on the transfer queue; command_buffer then only acquires ownership, and has to wait on this
+            vk::Semaphore wait_semaphore;
+            vk::PipelineStageFlags wait_stages;
+        };
+
+        UploadBatcher(Engine* engine, uint32_t frames_in_flight);
+        ~UploadBatcher();
+
+        //targets are expected to be freshly created: their previous contents (and queue family ownership) aren't kept,
+        //  so nothing may have used a target before, and a frame's copies into it can't overlap
+        //the data is staged immediately and copied before any work item recorded this frame runs (so regardless of the budget)
+        void uploadBuffer(vk::Buffer target, vk::DeviceSize target_offset, const void* data, vk::DeviceSize size);
+        //regions' buffer offsets are relative to data; the levels they cover end up in eShaderReadOnlyOptimal
+        void uploadImage(vk::Image target, std::vector<vk::BufferImageCopy> regions, const void* data, vk::DeviceSize size);
+        //for uploads nothing waits on: held back until a frame has budget (and ring space) left, oldest first
+        //returns a ticket for isSubmitted
+        uint64_t streamImage(vk::Image target, std::vector<vk::BufferImageCopy> regions, std::vector<uint8_t>&& data);
+        bool isSubmitted(uint64_t ticket) const;
+
+        //frame's fence has been waited on, so everything it copied from can be reused
+        void retire(uint32_t frame);
+        //records (and on the transfer queue, submits) this frame's uploads
+        Submission flush(uint32_t frame);
+        Stats getStats() const;
+
+    private:
+        struct ImageUpload
+        {
+            vk::Buffer source;
+            vk::Image target;
+            std::vector<vk::BufferImageCopy> regions;
+        };
+        struct BufferUpload
+        {
+            vk::Buffer source;
+            vk::Buffer target;
+            vk::BufferCopy region;
+        };
+        struct Staging
+        {
+            vk::Buffer buffer;
+            uint8_t* data;
+            vk::DeviceSize offset;
+        };
+        struct StreamUpload
+        {
+            uint64_t ticket;
+            ImageUpload upload;
+            std::vector<uint8_t> data;
+        };
+        struct Frame
+        {
+            //ring head once the frame's uploads were staged; the ring tail can move up to it when the frame retires
+            uint64_t ring_head{ 0 };
+            std::vector<std::unique_ptr<Buffer>> overflow;
+            vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic> command_buffer;
+            vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic> transfer_command_buffer;
+            vk::UniqueHandle<vk::Semaphore, vk::DispatchLoaderDynamic> transfer_semaphore;
+            //command_buffer wrote this frame's pair of timestamps
+            bool timed{ false };
+        };
+
+        //ring space, or a dedicated buffer for this frame if the ring is full (caller holds the mutex)
+        Staging allocate(vk::DeviceSize size);
+        std::optional<vk::DeviceSize> allocateRing(vk::DeviceSize size);
+        void rebase(std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize offset);
+        //moves streaming uploads into this frame while it has budget left
+        void stageDeferred();
+        //transitions the images for writing and copies everything, filling barriers with each image's subresources
+        void recordCopies(vk::CommandBuffer command_buffer, std::vector<vk::ImageMemoryBarrier>& barriers);
+        //the merged ranges this frame's buffer copies write, by target
+        std::vector<vk::BufferMemoryBarrier> getBufferBarriers() const;
+
+        Engine* engine;
+        mutable std::mutex mutex;
+        vk::DeviceSize alignment{ 16 };
+
+        std::unique_ptr<Buffer> ring;
+        uint8_t* ring_data{ nullptr };
+        vk::DeviceSize ring_size{ 0 };
+        //monotonic byte positions (taken modulo ring_size)
+        uint64_t ring_head{ 0 };
+        uint64_t ring_tail{ 0 };
+
+        std::vector<BufferUpload> buffer_uploads;
+        std::vector<ImageUpload> image_uploads;
+        std::vector<std::unique_ptr<Buffer>> overflow;
+        vk::DeviceSize staged_bytes{ 0 };
+        //uploads with staging space already taken that are still copying into it (outside the mutex)
+        //flush waits for them, so the space and the copy out of it end up in the same frame
+        uint32_t staging_in_progress{ 0 };
+        std::condition_variable staging_done;
+        std::deque<StreamUpload> deferred;
+        uint64_t next_ticket{ 1 };
+        uint64_t submitted_ticket{ 0 };
+
+        uint32_t graphics_family{ 0 };
+        std::optional<uint32_t> transfer_family;
+        vk::UniqueHandle<vk::CommandPool, vk::DispatchLoaderDynamic> command_pool;
+        vk::UniqueHandle<vk::CommandPool, vk::DispatchLoaderDynamic> transfer_command_pool;
+        std::vector<Frame> frames;
+        //two timestamps per frame, around command_buffer
+        vk::UniqueHandle<vk::QueryPool, vk::DispatchLoaderDynamic> query_pool;
+        //nanoseconds per timestamp tick
+        float timestamp_period{ 0.f };
+        Stats stats;
+    };
+}
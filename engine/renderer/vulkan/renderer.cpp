@@ -7,6 +7,13 @@
 #include "engine/core.h"
 #include "engine/game.h"
 #include "engine/config.h"
+#include "engine/renderer/texture_streamer.h"
+#include "engine/renderer/upload_batcher.h"
+#include "engine/renderer/constant_arena.h"
+#include "engine/renderer/bone_palette.h"
+#include "engine/renderer/frame_allocator.h"
+#include "engine/renderer/animation.h"
+#include "engine/entity/renderable_entity.h"
 
 constexpr size_t shadowmap_dimension = 2048;
 
@@ -60,7 +67,7 @@ namespace lotus
         createPhysicalDevice();
         createDevice();
 
-        memory_manager = std::make_unique<MemoryManager>(physical_device, *device);
+        memory_manager = std::make_unique<MemoryManager>(physical_device, *device, max_pending_frames, memory_budget_supported);
 
         createSwapchain();
         createRenderpasses();
@@ -76,13 +83,95 @@ namespace lotus
         createRayTracingResources();
         createAnimationResources();
 
-        render_commandbuffers.resize(getImageCount());
+        render_commandbuffers.resize(getFrameCount());
         raytracer = std::make_unique<Raytracer>(engine);
+        upload_batcher = std::make_unique<UploadBatcher>(engine, max_pending_frames);
+        texture_streamer = std::make_unique<TextureStreamer>(engine, max_pending_frames);
+        constant_arena = std::make_unique<ConstantArena>(engine, max_pending_frames, sizeof(RenderableEntity::UniformBufferObject));
+        bone_palette = std::make_unique<BonePalette>(engine, max_pending_frames);
+        frame_allocator = std::make_unique<FrameAllocator>(engine, max_pending_frames);
+        //covers every texture, not only the streamed ones the streamer keeps to texture_budget itself
+        memory_manager->setBudget(MemoryCategory::Texture, static_cast<vk::DeviceSize>(engine->config->renderer.texture_budget) * 1024 * 1024, [this](vk::DeviceSize bytes)
+        {
+            texture_streamer->requestEviction(bytes);
+        });
+        memory_manager->setLogInterval(std::chrono::seconds(engine->config->renderer.memory_log_interval));
+        memory_manager->addLogSource([this](std::ostream& line)
+        {
+            constexpr double mb = 1024.0 * 1024.0;
+            auto stats = texture_streamer->getStats();
+            line << "textures: " << stats.textures << " (" << stats.streamed << " streamed, " << stats.pending << " pending) " << stats.resident_bytes / mb << "/" << stats.budget / mb << " MB;"
+                << " cpu " << stats.cpu_bytes / mb << " MB; uploaded " << stats.uploaded_bytes / mb << " MB; " << stats.evictions << " evictions, " << stats.reloads << " reloads";
+        });
+        memory_manager->addLogSource([this](std::ostream& line)
+        {
+            constexpr double mb = 1024.0 * 1024.0;
+            auto stats = upload_batcher->getStats();
+            line << "uploads: " << stats.uploaded_bytes / mb << " MB (" << stats.frame_bytes / mb << " MB last frame) on the " << (stats.async ? "transfer" : "graphics") << " queue; "
+                << stats.overflow_uploads << " overflowed, " << stats.deferred_uploads << " deferred;";
+            //with async uploads, this is only the acquire barriers
+            if (stats.timed_frames > 0)
+                line << " graphics queue " << std::chrono::duration<double, std::milli>(stats.graphics_time).count() / stats.timed_frames << " ms/upload frame";
+        });
+        memory_manager->addLogSource([this](std::ostream& line)
+        {
+            auto stats = frame_allocator->getStats();
+            line << "frame allocator: last frame " << stats.frame_heap_allocations << " heap allocations, down from " << stats.frame_allocations
+                << " before the arenas (" << stats.frame_bytes / 1024.0 << " KB); " << stats.reserved / 1024.0 << " KB reserved over " << stats.threads << " threads";
+        });
+        memory_manager->addLogSource([this](std::ostream& line)
+        {
+            //logged from drawFrame (through retireFrame), so this doesn't race the frame timing
+            line << "frames: " << logged_frames << " since the last line";
+            if (logged_frames > 0)
+            {
+                line << ", avg " << std::chrono::duration<double, std::milli>(logged_frame_time).count() / logged_frames << " ms, max "
+                    << std::chrono::duration<double, std::milli>(max_frame_time).count() << " ms";
+            }
+            line << "; uploads on the " << (upload_batcher->getStats().async ? "transfer" : "graphics") << " queue";
+            if (engine->config->renderer.synthetic_upload_load > 0)
+                line << ", " << engine->config->renderer.synthetic_upload_load << " MB/frame of synthetic uploads";
+            logged_frames = 0;
+            logged_frame_time = {};
+            max_frame_time = {};
+        });
+        memory_manager->addLogSource([](std::ostream& line)
+        {
+            auto stats = Animation::getStats();
+            line << "animation: " << stats.clips << " clips, " << stats.memory_bytes / 1024.0 << " KB (" << stats.uncompressed_bytes / 1024.0 << " KB uncompressed); "
+                << stats.poses << " poses (" << stats.bones << " bones) sampled";
+            if (stats.poses > 0)
+                line << ", " << std::chrono::duration<double, std::micro>(stats.sample_time).count() / stats.poses << " us/pose";
+        });
+        memory_manager->addLogSource([](std::ostream& line)
+        {
+            constexpr double mb = 1024.0 * 1024.0;
+            auto log_cache = [&line, mb](const char* name, const auto& stats)
+            {
+                line << name << stats.resident << " resident, " << stats.evictable << " evictable (" << stats.evictable_bytes / mb << "/" << stats.budget / mb << " MB), "
+                    << stats.loading << " loading; " << stats.hits << " hits, " << stats.warm_hits << " warm hits, " << stats.misses << " misses, "
+                    << stats.coalesced << " coalesced, " << stats.evictions << " evictions";
+            };
+            log_cache("asset caches: models ", Model::getCacheStats());
+            log_cache("; textures ", Texture::getCacheStats());
+        });
+        memory_manager->addLogSource([this](std::ostream& line)
+        {
+            constexpr double kb = 1024.0;
+            auto constants = constant_arena->getStats();
+            auto bones = bone_palette->getStats();
+            line << "constant arena: " << constants.slots << " slots over " << constants.pages << " pages (" << constants.bytes / kb << " KB); "
+                << "bone palette: " << bones.frame_bytes / kb << "/" << bones.capacity / kb << " KB last frame, " << bones.overflow_allocations << " overflowed";
+        });
+        Model::setCacheBudget(static_cast<uint64_t>(engine->config->renderer.model_cache_budget) * 1024 * 1024);
+        Texture::setCacheBudget(static_cast<uint64_t>(engine->config->renderer.texture_cache_budget) * 1024 * 1024);
     }
 
     Renderer::~Renderer()
     {
         device->waitIdle();
+        Model::clearCache();
+        Texture::clearCache();
         if (mesh_info_buffer)
             mesh_info_buffer->unmap();
     }
@@ -119,7 +208,7 @@ namespace lotus
                 vk::DeviceSize shader_offset_miss = (((nonhit_shader_stride * shader_raygencount) / engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment) + 1) * engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment;
                 vk::DeviceSize shader_offset_hit = shader_offset_miss + (((nonhit_shader_stride * shader_misscount) / engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment) + 1) * engine->renderer.ray_tracing_properties.shaderGroupBaseAlignment;
                 vk::DeviceSize sbt_size = (hit_shader_stride * shader_hitcount) + shader_offset_hit;
-                shader_binding_table = engine->renderer.memory_manager->GetBuffer(sbt_size, vk::BufferUsageFlagBits::eRayTracingKHR, vk::MemoryPropertyFlagBits::eHostVisible);
+                shader_binding_table = engine->renderer.memory_manager->GetBuffer(sbt_size, vk::BufferUsageFlagBits::eRayTracingKHR, vk::MemoryPropertyFlagBits::eHostVisible, MemoryCategory::Other);
 
                 uint8_t* shader_mapped = static_cast<uint8_t*>(shader_binding_table->map(0, sbt_size, {}));
 
@@ -151,18 +240,18 @@ namespace lotus
                 pool_sizes_const.emplace_back(vk::DescriptorType::eUniformBuffer, 1);
 
                 vk::DescriptorPoolCreateInfo pool_ci;
-                pool_ci.maxSets = 3;
+                pool_ci.maxSets = getFrameCount();
                 pool_ci.poolSizeCount = static_cast<uint32_t>(pool_sizes_const.size());
                 pool_ci.pPoolSizes = pool_sizes_const.data();
                 pool_ci.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
 
                 rtx_descriptor_pool_const = device->createDescriptorPoolUnique(pool_ci, nullptr);
 
-                std::array<vk::DescriptorSetLayout, 3> layouts = { *rtx_descriptor_layout_const, *rtx_descriptor_layout_const, *rtx_descriptor_layout_const };
+                std::vector<vk::DescriptorSetLayout> layouts(getFrameCount(), *rtx_descriptor_layout_const);
 
                 vk::DescriptorSetAllocateInfo set_ci;
                 set_ci.descriptorPool = *rtx_descriptor_pool_const;
-                set_ci.descriptorSetCount = 3;
+                set_ci.descriptorSetCount = static_cast<uint32_t>(layouts.size());
                 set_ci.pSetLayouts = layouts.data();
                 rtx_descriptor_sets_const = device->allocateDescriptorSetsUnique<std::allocator<vk::UniqueHandle<vk::DescriptorSet, vk::DispatchLoaderDynamic>>>(set_ci);
             }
@@ -214,7 +303,7 @@ namespace lotus
         auto physical_devices = instance->enumeratePhysicalDevices();
 
         physical_device = *std::find_if(physical_devices.begin(), physical_devices.end(), [this](auto& device) {
-            auto [graphics, present, compute] = getQueueFamilies(device);
+            auto [graphics, present, compute, transfer] = getQueueFamilies(device);
             auto extensions_supported = extensionsSupported(device);
             auto swap_chain_info = getSwapChainInfo(device);
             auto supported_features = device.getFeatures();
@@ -234,9 +323,11 @@ namespace lotus
 
     void Renderer::createDevice()
     {
-        auto [graphics_queue_idx, present_queue_idx, compute_queue_idx] = getQueueFamilies(physical_device);
+        auto [graphics_queue_idx, present_queue_idx, compute_queue_idx, transfer_queue_idx] = getQueueFamilies(physical_device);
         //deduplicate queues
         std::set<uint32_t> queues = { graphics_queue_idx.value(), present_queue_idx.value(), compute_queue_idx.value() };
+        if (transfer_queue_idx)
+            queues.insert(transfer_queue_idx.value());
 
         std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
         float queue_priority = 0.f;
@@ -292,6 +383,14 @@ namespace lotus
             device_extensions2.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
             device_extensions2.push_back(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
         }
+        for (const auto& supported_extension : physical_device.enumerateDeviceExtensionProperties(nullptr))
+        {
+            if (std::string(supported_extension.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+            {
+                device_extensions2.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                memory_budget_supported = true;
+            }
+        }
 
         vk::DeviceCreateInfo device_create_info;
         device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
@@ -314,6 +413,8 @@ namespace lotus
         graphics_queue = device->getQueue(graphics_queue_idx.value(), 0);
         present_queue = device->getQueue(present_queue_idx.value(), 0);
         compute_queue = device->getQueue(compute_queue_idx.value(), 0);
+        if (transfer_queue_idx)
+            transfer_queue = device->getQueue(transfer_queue_idx.value(), 0);
 
         if (enableValidationLayers)
         {
@@ -406,7 +507,7 @@ namespace lotus
             swapchain_create_info.oldSwapchain = *old_swapchain;
         }
 
-        auto [graphics, present, compute] = getQueueFamilies(physical_device);
+        auto [graphics, present, compute, transfer] = getQueueFamilies(physical_device);
         uint32_t queueIndices[] = { graphics.value(), present.value() };
         if (graphics.value() != present.value())
         {
@@ -1839,7 +1940,7 @@ namespace lotus
     {
         auto format = getDepthFormat();
 
-        depth_image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        depth_image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
 
         vk::ImageViewCreateInfo image_view_info;
         image_view_info.viewType = vk::ImageViewType::e2D;
@@ -1906,7 +2007,7 @@ namespace lotus
 
             auto format = getDepthFormat();
 
-            shadowmap_image = memory_manager->GetImage(shadowmap_dimension, shadowmap_dimension, format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, shadowmap_cascades);
+            shadowmap_image = memory_manager->GetImage(shadowmap_dimension, shadowmap_dimension, format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, shadowmap_cascades, 1, MemoryCategory::RenderTarget);
 
             vk::ImageViewCreateInfo image_view_info;
             image_view_info.image = shadowmap_image->image;
@@ -1962,14 +2063,14 @@ namespace lotus
 
     void Renderer::createGBufferResources()
     {
-        gbuffer.position.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.normal.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.face_normal.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.albedo.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.accumulation.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16G16B16A16Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.revealage.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.material.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16Uint, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        gbuffer.depth.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, getDepthFormat(), vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        gbuffer.position.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.normal.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.face_normal.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.albedo.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.accumulation.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16G16B16A16Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.revealage.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.material.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR16Uint, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+        gbuffer.depth.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, getDepthFormat(), vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
 
         vk::ImageViewCreateInfo image_view_info;
         image_view_info.image = gbuffer.position.image->image;
@@ -2033,8 +2134,8 @@ namespace lotus
 
         if (RaytraceEnabled())
         {
-            rtx_gbuffer.albedo.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::MemoryPropertyFlagBits::eDeviceLocal);
-            rtx_gbuffer.light.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::MemoryPropertyFlagBits::eDeviceLocal);
+            rtx_gbuffer.albedo.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
+            rtx_gbuffer.light.image = memory_manager->GetImage(swapchain_extent.width, swapchain_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, MemoryCategory::RenderTarget);
 
             vk::ImageViewCreateInfo image_view_info;
             image_view_info.image = rtx_gbuffer.albedo.image->image;
@@ -2067,8 +2168,8 @@ namespace lotus
             rtx_gbuffer.sampler = device->createSamplerUnique(sampler_info, nullptr);
         }
 
-        mesh_info_buffer = memory_manager->GetBuffer(max_acceleration_binding_index * sizeof(MeshInfo) * getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible);
-        mesh_info_buffer_mapped = (MeshInfo*)mesh_info_buffer->map(0, max_acceleration_binding_index * sizeof(MeshInfo) * getImageCount(), {});
+        mesh_info_buffer = memory_manager->GetBuffer(max_acceleration_binding_index * sizeof(MeshInfo) * getFrameCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, MemoryCategory::Uniform);
+        mesh_info_buffer_mapped = (MeshInfo*)mesh_info_buffer->map(0, max_acceleration_binding_index * sizeof(MeshInfo) * getFrameCount(), {});
     }
 
     void Renderer::createDeferredCommandBuffer()
@@ -2076,15 +2177,17 @@ namespace lotus
         vk::CommandBufferAllocateInfo alloc_info = {};
         alloc_info.commandPool = *command_pool;
         alloc_info.level = vk::CommandBufferLevel::ePrimary;
-        alloc_info.commandBufferCount = getImageCount();
+        //one per frame in flight for each swapchain image: the framebuffer follows the image, the uniforms follow the frame
+        alloc_info.commandBufferCount = getFrameCount() * getImageCount();
 
         deferred_command_buffers = device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
 
         if (render_mode == RenderMode::Rasterization)
         {
-            for (int i = 0; i < deferred_command_buffers.size(); ++i)
+            for (uint32_t i = 0; i < deferred_command_buffers.size(); ++i)
             {
                 vk::CommandBuffer buffer = *deferred_command_buffers[i];
+                uint32_t frame = i / getImageCount();
                 vk::CommandBufferBeginInfo begin_info = {};
                 begin_info.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
 
@@ -2100,7 +2203,7 @@ namespace lotus
                 renderpass_info.pClearValues = clearValues.data();
                 renderpass_info.renderArea.offset = vk::Offset2D{ 0, 0 };
                 renderpass_info.renderArea.extent = swapchain_extent;
-                renderpass_info.framebuffer = *frame_buffers[i];
+                renderpass_info.framebuffer = *frame_buffers[i % getImageCount()];
                 buffer.beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
 
                 vk::DescriptorImageInfo pos_info;
@@ -2135,7 +2238,7 @@ namespace lotus
 
                 vk::DescriptorBufferInfo camera_buffer_info;
                 camera_buffer_info.buffer = engine->camera->view_proj_ubo->buffer;
-                camera_buffer_info.offset = i * uniform_buffer_align_up(sizeof(Camera::CameraData));
+                camera_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(Camera::CameraData));
                 camera_buffer_info.range = sizeof(Camera::CameraData);
 
                 std::vector<vk::WriteDescriptorSet> descriptorWrites{ 10 };
@@ -2191,7 +2294,7 @@ namespace lotus
 
                 vk::DescriptorBufferInfo light_buffer_info;
                 light_buffer_info.buffer = engine->lights.light_buffer->buffer;
-                light_buffer_info.offset = i * uniform_buffer_align_up(sizeof(engine->lights.light));
+                light_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(engine->lights.light));
                 light_buffer_info.range = sizeof(engine->lights.light);
 
                 vk::DescriptorImageInfo shadowmap_image_info;
@@ -2201,7 +2304,7 @@ namespace lotus
 
                 vk::DescriptorBufferInfo cascade_buffer_info;
                 cascade_buffer_info.buffer = engine->camera->cascade_data_ubo->buffer;
-                cascade_buffer_info.offset = i * uniform_buffer_align_up(sizeof(engine->camera->cascade_data));
+                cascade_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(engine->camera->cascade_data));
                 cascade_buffer_info.range = sizeof(engine->camera->cascade_data);
 
                 descriptorWrites[7].dstSet = nullptr;
@@ -2240,9 +2343,10 @@ namespace lotus
         }
         else if (render_mode == RenderMode::Raytrace)
         {
-            for (int i = 0; i < deferred_command_buffers.size(); ++i)
+            for (uint32_t i = 0; i < deferred_command_buffers.size(); ++i)
             {
                 vk::CommandBuffer buffer = *deferred_command_buffers[i];
+                uint32_t frame = i / getImageCount();
 
                 vk::CommandBufferBeginInfo begin_info = {};
                 begin_info.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
@@ -2259,7 +2363,7 @@ namespace lotus
                 renderpass_info.pClearValues = clear_values.data();
                 renderpass_info.renderArea.offset = vk::Offset2D{ 0, 0 };
                 renderpass_info.renderArea.extent = swapchain_extent;
-                renderpass_info.framebuffer = *frame_buffers[i];
+                renderpass_info.framebuffer = *frame_buffers[i % getImageCount()];
                 buffer.beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
 
                 buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *rtx_deferred_pipeline);
@@ -2281,7 +2385,7 @@ namespace lotus
 
                 vk::DescriptorBufferInfo mesh_info;
                 mesh_info.buffer = mesh_info_buffer->buffer;
-                mesh_info.offset = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index * i;
+                mesh_info.offset = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index * frame;
                 mesh_info.range = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index;
 
                 std::vector<vk::WriteDescriptorSet> descriptorWrites {4};
@@ -2324,9 +2428,10 @@ namespace lotus
         }
         else if (render_mode == RenderMode::Hybrid)
         {
-            for (int i = 0; i < deferred_command_buffers.size(); ++i)
+            for (uint32_t i = 0; i < deferred_command_buffers.size(); ++i)
             {
                 vk::CommandBuffer buffer = *deferred_command_buffers[i];
+                uint32_t frame = i / getImageCount();
 
                 vk::CommandBufferBeginInfo begin_info = {};
                 begin_info.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
@@ -2343,7 +2448,7 @@ namespace lotus
                 renderpass_info.pClearValues = clear_values.data();
                 renderpass_info.renderArea.offset = vk::Offset2D{ 0, 0 };
                 renderpass_info.renderArea.extent = swapchain_extent;
-                renderpass_info.framebuffer = *frame_buffers[i];
+                renderpass_info.framebuffer = *frame_buffers[i % getImageCount()];
                 buffer.beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
 
                 buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *rtx_deferred_pipeline);
@@ -2380,17 +2485,17 @@ namespace lotus
 
                 vk::DescriptorBufferInfo mesh_info;
                 mesh_info.buffer = mesh_info_buffer->buffer;
-                mesh_info.offset = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index * i;
+                mesh_info.offset = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index * frame;
                 mesh_info.range = sizeof(Renderer::MeshInfo) * max_acceleration_binding_index;
 
                 vk::DescriptorBufferInfo light_buffer_info;
                 light_buffer_info.buffer = engine->lights.light_buffer->buffer;
-                light_buffer_info.offset = i * uniform_buffer_align_up(sizeof(engine->lights.light));
+                light_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(engine->lights.light));
                 light_buffer_info.range = sizeof(engine->lights.light);
 
                 vk::DescriptorBufferInfo camera_buffer_info;
                 camera_buffer_info.buffer = engine->camera->view_proj_ubo->buffer;
-                camera_buffer_info.offset = i * uniform_buffer_align_up(sizeof(Camera::CameraData));
+                camera_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(Camera::CameraData));
                 camera_buffer_info.range = sizeof(Camera::CameraData);
 
                 std::vector<vk::WriteDescriptorSet> descriptorWrites {9};
@@ -2487,7 +2592,7 @@ namespace lotus
             {{1.f, -1.f, 1.f}, {0.f, 0.f, 0.f}, {1.f, 1.f, 1.f}, {1.f, 0.f}, 0.f}
         };
 
-        quad.vertex_buffer = memory_manager->GetBuffer(vertex_buffer.size() * sizeof(Vertex), vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        quad.vertex_buffer = memory_manager->GetBuffer(vertex_buffer.size() * sizeof(Vertex), vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Other);
         void* buf_mem = quad.vertex_buffer->map(0, vertex_buffer.size() * sizeof(Vertex), {});
         memcpy(buf_mem, vertex_buffer.data(), vertex_buffer.size() * sizeof(Vertex));
         quad.vertex_buffer->unmap();
@@ -2503,7 +2608,7 @@ namespace lotus
         }
         quad.index_count = static_cast<uint32_t>(index_buffer.size());
 
-        quad.index_buffer = memory_manager->GetBuffer(index_buffer.size() * sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        quad.index_buffer = memory_manager->GetBuffer(index_buffer.size() * sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Other);
         buf_mem = quad.index_buffer->map(0, index_buffer.size() * sizeof(uint32_t), {});
         memcpy(buf_mem, index_buffer.data(), index_buffer.size() * sizeof(uint32_t));
         quad.index_buffer->unmap();
@@ -2646,7 +2751,7 @@ namespace lotus
         };
     }
 
-    vk::CommandBuffer Renderer::getRenderCommandbuffer(uint32_t image_index)
+    vk::CommandBuffer Renderer::getRenderCommandbuffer(uint32_t frame)
     {
         vk::CommandBufferAllocateInfo alloc_info = {};
         alloc_info.commandPool = *command_pool;
@@ -2676,14 +2781,14 @@ namespace lotus
                 renderpass_info.clearValueCount = static_cast<uint32_t>(clearValue.size());
                 renderpass_info.pClearValues = clearValue.data();
 
-                auto shadowmap_buffers = engine->worker_pool.getShadowmapGraphicsBuffers(image_index);
-
                 for (uint32_t i = 0; i < shadowmap_cascades; ++i)
                 {
+                    //the cascade index is pushed by each secondary buffer, since they only draw what's inside this cascade
+                    auto shadowmap_buffers = engine->worker_pool.getShadowmapGraphicsBuffers(frame, i);
                     renderpass_info.framebuffer = *cascades[i].shadowmap_frame_buffer;
-                    buffer[0]->pushConstants<uint32_t>(*shadowmap_pipeline_layout, vk::ShaderStageFlagBits::eVertex, sizeof(uint32_t), i);
                     buffer[0]->beginRenderPass(renderpass_info, vk::SubpassContents::eSecondaryCommandBuffers);
-                    buffer[0]->executeCommands(shadowmap_buffers);
+                    if (!shadowmap_buffers.empty())
+                        buffer[0]->executeCommands(shadowmap_buffers);
                     buffer[0]->endRenderPass();
                 }
             }
@@ -2705,11 +2810,11 @@ namespace lotus
             renderpass_info.renderArea.extent = swapchain_extent;
 
             buffer[0]->beginRenderPass(renderpass_info, vk::SubpassContents::eSecondaryCommandBuffers);
-            auto secondary_buffers = engine->worker_pool.getSecondaryGraphicsBuffers(image_index);
+            auto secondary_buffers = engine->worker_pool.getSecondaryGraphicsBuffers(frame);
             if (!secondary_buffers.empty())
                 buffer[0]->executeCommands(secondary_buffers);
             buffer[0]->nextSubpass(vk::SubpassContents::eSecondaryCommandBuffers);
-            auto particle_buffers = engine->worker_pool.getParticleGraphicsBuffers(image_index);
+            auto particle_buffers = engine->worker_pool.getParticleGraphicsBuffers(frame);
             if (!particle_buffers.empty())
                 buffer[0]->executeCommands(particle_buffers);
             buffer[0]->endRenderPass();
@@ -2718,7 +2823,7 @@ namespace lotus
         {
             buffer[0]->bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline);
 
-            buffer[0]->bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline_layout, 0, *rtx_descriptor_sets_const[image_index], {});
+            buffer[0]->bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline_layout, 0, *rtx_descriptor_sets_const[frame], {});
 
             vk::WriteDescriptorSet write_info_target_albedo;
             write_info_target_albedo.descriptorCount = 1;
@@ -2742,7 +2847,7 @@ namespace lotus
 
             vk::DescriptorBufferInfo cam_buffer_info;
             cam_buffer_info.buffer = engine->camera->view_proj_ubo->buffer;
-            cam_buffer_info.offset = uniform_buffer_align_up(sizeof(Camera::CameraData)) * getCurrentImage();
+            cam_buffer_info.offset = uniform_buffer_align_up(sizeof(Camera::CameraData)) * frame;
             cam_buffer_info.range = sizeof(Camera::CameraData);
 
             vk::WriteDescriptorSet write_info_cam;
@@ -2754,7 +2859,7 @@ namespace lotus
 
             vk::DescriptorBufferInfo light_buffer_info_global;
             light_buffer_info_global.buffer = engine->lights.light_buffer->buffer;
-            light_buffer_info_global.offset = getCurrentImage() * uniform_buffer_align_up(sizeof(engine->lights.light));
+            light_buffer_info_global.offset = frame * uniform_buffer_align_up(sizeof(engine->lights.light));
             light_buffer_info_global.range = sizeof(engine->lights.light);
 
             vk::WriteDescriptorSet write_info_light;
@@ -2773,7 +2878,7 @@ namespace lotus
         {
             buffer[0]->bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline);
 
-            buffer[0]->bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline_layout, 0, *rtx_descriptor_sets_const[image_index], {});
+            buffer[0]->bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, *rtx_pipeline_layout, 0, *rtx_descriptor_sets_const[frame], {});
 
             vk::WriteDescriptorSet write_info_target_light;
             write_info_target_light.descriptorCount = 1;
@@ -2788,7 +2893,7 @@ namespace lotus
 
             vk::DescriptorBufferInfo light_buffer_info;
             light_buffer_info.buffer = engine->lights.light_buffer->buffer;
-            light_buffer_info.offset = getCurrentImage() * uniform_buffer_align_up(sizeof(engine->lights.light));
+            light_buffer_info.offset = frame * uniform_buffer_align_up(sizeof(engine->lights.light));
             light_buffer_info.range = sizeof(engine->lights.light);
 
             vk::WriteDescriptorSet write_info_light;
@@ -2852,8 +2957,8 @@ namespace lotus
         }
 
         buffer[0]->end();
-        render_commandbuffers[image_index] = std::move(buffer[0]);
-        return *render_commandbuffers[image_index];
+        render_commandbuffers[frame] = std::move(buffer[0]);
+        return *render_commandbuffers[frame];
     }
 
     bool Renderer::checkValidationLayerSupport() const
@@ -2896,13 +3001,14 @@ namespace lotus
         return extensions;
     }
 
-    std::tuple<std::optional<uint32_t>, std::optional<std::uint32_t>, std::optional<std::uint32_t>> Renderer::getQueueFamilies(vk::PhysicalDevice device) const
+    std::tuple<std::optional<uint32_t>, std::optional<std::uint32_t>, std::optional<std::uint32_t>, std::optional<std::uint32_t>> Renderer::getQueueFamilies(vk::PhysicalDevice device) const
     {
         auto queue_families = device.getQueueFamilyProperties();
         std::optional<uint32_t> graphics;
         std::optional<uint32_t> present;
         std::optional<uint32_t> compute;
         std::optional<uint32_t> compute_dedicated;
+        std::optional<uint32_t> transfer;
 
         for (size_t i = 0; i < queue_families.size(); ++i)
         {
@@ -2922,6 +3028,12 @@ namespace lotus
                 compute_dedicated = static_cast<uint32_t>(i);
             }
 
+            //graphics and compute families can transfer too, but a family that only transfers is usually a separate DMA engine
+            if (family.queueFlags & vk::QueueFlagBits::eTransfer && (family.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) == vk::QueueFlags{} && family.queueCount > 0)
+            {
+                transfer = static_cast<uint32_t>(i);
+            }
+
             if (device.getSurfaceSupportKHR(static_cast<uint32_t>(i), *surface) && family.queueCount > 0 && !present)
             {
                 present = static_cast<uint32_t>(i);
@@ -2929,7 +3041,7 @@ namespace lotus
         }
         if (compute_dedicated)
             compute = compute_dedicated;
-        return { graphics, present, compute };
+        return { graphics, present, compute, transfer };
     }
 
     size_t lotus::Renderer::uniform_buffer_align_up(size_t in_size) const
@@ -2955,10 +3067,32 @@ namespace lotus
         if (!engine->game || !engine->game->scene)
             return;
 
+        auto frame_start = std::chrono::steady_clock::now();
+        if (last_frame_start != std::chrono::steady_clock::time_point{})
+        {
+            auto frame_time = std::chrono::duration_cast<std::chrono::nanoseconds>(frame_start - last_frame_start);
+            ++logged_frames;
+            logged_frame_time += frame_time;
+            max_frame_time = std::max(max_frame_time, frame_time);
+        }
+        last_frame_start = frame_start;
+
         engine->worker_pool.deleteFinished();
         device->waitForFences(*frame_fences[current_frame], true, std::numeric_limits<uint64_t>::max());
+        upload_batcher->retire(current_frame);
+        texture_streamer->retire(current_frame);
+        bone_palette->retire(current_frame);
+        frame_allocator->retire(current_frame);
+        memory_manager->retireFrame();
+        if (++frames_since_asset_prune >= asset_prune_interval)
+        {
+            //anything only the caches reference has had every frame that used it retired (entities are kept alive by their work items until then)
+            //models go first, since evicting one releases its textures
+            Model::pruneCache();
+            Texture::pruneCache();
+            frames_since_asset_prune = 0;
+        }
 
-        auto prev_image = current_image;
         auto [result, value] = device->acquireNextImageKHR(*swapchain, std::numeric_limits<uint64_t>::max(), *image_ready_sem[current_frame], nullptr);
         current_image = value;
 
@@ -2967,25 +3101,26 @@ namespace lotus
             recreateRenderer();
             return;
         }
-        engine->worker_pool.clearProcessed(current_image);
+        engine->worker_pool.clearProcessed(current_frame);
         if (old_swapchain && old_swapchain_image == current_image)
         {
             old_swapchain.reset();
         }
         engine->worker_pool.waitIdle();
+        texture_streamer->update(current_frame);
         if (raytracer->hasQueries())
         {
-            raytracer->runQueries(prev_image);
+            raytracer->runQueries((current_frame + max_pending_frames - 1) % max_pending_frames);
         }
         engine->game->scene->render();
 
         engine->worker_pool.waitIdle();
-        engine->worker_pool.startProcessing(current_image);
+        engine->worker_pool.startProcessing(current_frame);
         engine->lights.UpdateLightBuffer();
 
-        std::vector<vk::Semaphore> waitSemaphores = { *image_ready_sem[current_frame]};
-        std::vector<vk::PipelineStageFlags> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eRayTracingShaderKHR };
-        auto buffers = engine->worker_pool.getPrimaryComputeBuffers(current_image);
+        std::pmr::vector<vk::Semaphore> waitSemaphores({ *image_ready_sem[current_frame] }, frame_allocator->getResource());
+        std::pmr::vector<vk::PipelineStageFlags> waitStages({ vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eRayTracingShaderKHR }, frame_allocator->getResource());
+        auto buffers = engine->worker_pool.getPrimaryComputeBuffers(current_frame);
         if (!buffers.empty())
         {
             vk::SubmitInfo submitInfo = {};
@@ -3001,14 +3136,25 @@ namespace lotus
             waitStages.push_back(vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR | vk::PipelineStageFlagBits::eVertexInput);
         }
 
+        buffers = engine->worker_pool.getPrimaryGraphicsBuffers(current_frame);
+        if (engine->config->renderer.synthetic_upload_load > 0)
+            uploadSyntheticLoad();
+        //every upload staged this frame is copied (or acquired from the transfer queue) before any work item's commands
+        auto upload = upload_batcher->flush(current_frame);
+        if (upload.command_buffer)
+            buffers.insert(buffers.begin(), upload.command_buffer);
+        if (upload.wait_semaphore)
+        {
+            waitSemaphores.push_back(upload.wait_semaphore);
+            waitStages.push_back(upload.wait_stages);
+        }
+        buffers.push_back(getRenderCommandbuffer(current_frame));
+
         vk::SubmitInfo submitInfo = {};
         submitInfo.waitSemaphoreCount = waitSemaphores.size();
         submitInfo.pWaitSemaphores = waitSemaphores.data();
         submitInfo.pWaitDstStageMask = waitStages.data();
 
-        buffers = engine->worker_pool.getPrimaryGraphicsBuffers(current_image);
-        buffers.push_back(getRenderCommandbuffer(current_image));
-
         submitInfo.commandBufferCount = static_cast<uint32_t>(buffers.size());
         submitInfo.pCommandBuffers = buffers.data();
 
@@ -3021,7 +3167,7 @@ namespace lotus
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = gbuffer_semaphores;
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &*deferred_command_buffers[current_image];
+        submitInfo.pCommandBuffers = &*deferred_command_buffers[current_frame * getImageCount() + current_image];
 
         vk::Semaphore signalSemaphores[] = { *frame_finish_sem[current_frame] };
         submitInfo.signalSemaphoreCount = 1;
@@ -3061,6 +3207,23 @@ namespace lotus
         current_frame = (current_frame + 1) % max_pending_frames;
     }
 
+    void Renderer::uploadSyntheticLoad()
+    {
+        size_t size = static_cast<size_t>(engine->config->renderer.synthetic_upload_load) * 1024 * 1024;
+        if (synthetic_upload_data.size() != size)
+        {
+            synthetic_upload_data.assign(size, 0x5A);
+            synthetic_upload_targets.clear();
+            synthetic_upload_targets.resize(max_pending_frames);
+        }
+        //the previous copy into this frame's target finished with its fence; nothing ever reads the targets, so it doesn't
+        //  matter that their contents (and queue family ownership) aren't kept from one upload to the next
+        auto& target = synthetic_upload_targets[current_frame];
+        if (!target)
+            target = memory_manager->GetBuffer(size, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        upload_batcher->uploadBuffer(target->buffer, 0, synthetic_upload_data.data(), size);
+    }
+
     vk::Format Renderer::getDepthFormat() const
     {
         for (vk::Format format : {vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint})
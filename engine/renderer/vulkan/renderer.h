@@ -2,6 +2,7 @@
 
 #include <string>
 #include <optional>
+#include <chrono>
 #include <cstdint>
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
@@ -10,6 +11,11 @@
 namespace lotus
 {
     class Engine;
+    class TextureStreamer;
+    class UploadBatcher;
+    class ConstantArena;
+    class BonePalette;
+    class FrameAllocator;
 
     enum class RenderMode
     {
@@ -38,7 +44,11 @@ namespace lotus
         uint32_t getImageCount() const { return static_cast<uint32_t>(swapchain_images.size()); }
         uint32_t getCurrentImage() const { return current_image; }
         void setCurrentImage(int _current_image) { current_image = _current_image; }
-        std::tuple<std::optional<uint32_t>, std::optional<std::uint32_t>, std::optional<uint32_t>> getQueueFamilies(vk::PhysicalDevice device) const;
+        //per-frame resources (uniforms, skinned vertices, work items) are kept per frame in flight rather than per swapchain image
+        uint32_t getFrameCount() const { return max_pending_frames; }
+        uint32_t getCurrentFrame() const { return current_frame; }
+        //graphics, present, compute, transfer (a transfer-only family, if the device has one)
+        std::tuple<std::optional<uint32_t>, std::optional<std::uint32_t>, std::optional<uint32_t>, std::optional<uint32_t>> getQueueFamilies(vk::PhysicalDevice device) const;
         size_t uniform_buffer_align_up(size_t in_size) const;
         size_t storage_buffer_align_up(size_t in_size) const;
         size_t align_up(size_t in_size, size_t alignment) const;
@@ -59,6 +69,8 @@ namespace lotus
         vk::Queue graphics_queue;
         vk::Queue present_queue;
         vk::Queue compute_queue;
+        //null if the device has no transfer-only family
+        vk::Queue transfer_queue;
         vk::UniqueHandle<vk::SwapchainKHR, vk::DispatchLoaderDynamic> swapchain;
         vk::UniqueHandle<vk::SwapchainKHR, vk::DispatchLoaderDynamic> old_swapchain;
         uint32_t old_swapchain_image{ 0 };
@@ -139,6 +151,11 @@ namespace lotus
         /* Animation pipeline */
 
         std::unique_ptr<Raytracer> raytracer;
+        std::unique_ptr<UploadBatcher> upload_batcher;
+        std::unique_ptr<TextureStreamer> texture_streamer;
+        std::unique_ptr<ConstantArena> constant_arena;
+        std::unique_ptr<BonePalette> bone_palette;
+        std::unique_ptr<FrameAllocator> frame_allocator;
 
         struct MeshInfo
         {
@@ -215,6 +232,8 @@ namespace lotus
 
         void recreateRenderer();
         void recreateStaticCommandBuffers();
+        //stages synthetic_upload_load's throwaway copies for the current frame
+        void uploadSyntheticLoad();
 
         bool checkValidationLayerSupport() const;
         std::vector<const char*> getRequiredExtensions() const;
@@ -230,7 +249,7 @@ namespace lotus
 
         swapChainInfo getSwapChainInfo(vk::PhysicalDevice device) const;
 
-        vk::CommandBuffer getRenderCommandbuffer(uint32_t image_index);
+        vk::CommandBuffer getRenderCommandbuffer(uint32_t frame);
 
         Engine* engine;
         vk::UniqueDebugUtilsMessengerEXT debug_messenger;
@@ -241,6 +260,19 @@ namespace lotus
         uint32_t current_image{ 0 };
         uint32_t max_pending_frames{ 2 };
         uint32_t current_frame{ 0 };
+        bool memory_budget_supported{ false };
+        //unused models and textures are moved to their caches' evictable lists every few frames, not every frame
+        static constexpr uint32_t asset_prune_interval{ 60 };
+        uint32_t frames_since_asset_prune{ 0 };
+
+        //frame times (start of one drawFrame to the next) since the last "frames:" log line
+        std::chrono::steady_clock::time_point last_frame_start;
+        uint64_t logged_frames{ 0 };
+        std::chrono::nanoseconds logged_frame_time{ 0 };
+        std::chrono::nanoseconds max_frame_time{ 0 };
+        std::vector<uint8_t> synthetic_upload_data;
+        //one per frame in flight
+        std::vector<std::unique_ptr<Buffer>> synthetic_upload_targets;
 
         struct
         {
@@ -2,57 +2,123 @@
 #include "entity/renderable_entity.h"
 #include "entity/deformable_entity.h"
 #include "entity/particle.h"
+#include "entity/landscape_entity.h"
+#include "entity/camera.h"
+#include "entity/component/animation_component.h"
 #include "core.h"
 #include "renderer/vulkan/renderer.h"
 #include "task/acceleration_build.h"
+#include "renderer/texture_streamer.h"
 
 namespace lotus
 {
     Scene::Scene(Engine* _engine) : engine(_engine)
     {
-        top_level_as.resize(engine->renderer.getImageCount());
+        top_level_as.resize(engine->renderer.getFrameCount());
     }
 
     void Scene::render()
     {
-        uint32_t image_index = engine->renderer.getCurrentImage();
+        uint32_t frame_index = engine->renderer.getCurrentFrame();
+        cullEntities();
         if (engine->renderer.RaytraceEnabled())
         {
-            top_level_as[image_index] = std::make_shared<TopLevelAccelerationStructure>(engine, true);
-            Model::forEachModel([this, image_index](const std::shared_ptr<Model>& model)
+            top_level_as[frame_index] = std::make_shared<TopLevelAccelerationStructure>(engine, true);
+            Model::forEachModel([this, frame_index](const std::shared_ptr<Model>& model)
             {
                 //TODO: review if this is needed
                 //if (model->bottom_level_as && model->lifetime != Lifetime::Long)
                 //{
-                //    top_level_as[image_index]->AddBLASResource(model.get());
+                //    top_level_as[frame_index]->AddBLASResource(model.get());
                 //}
             });
             for (const auto& entity : entities)
             {
                 if (auto deformable_entity = dynamic_cast<DeformableEntity*>(entity.get()))
                 {
-                    top_level_as[image_index]->AddBLASResource(deformable_entity);
+                    top_level_as[frame_index]->AddBLASResource(deformable_entity);
                 }
                 if (auto particle = dynamic_cast<Particle*>(entity.get()))
                 {
-                    top_level_as[image_index]->AddBLASResource(particle);
+                    top_level_as[frame_index]->AddBLASResource(particle);
                 }
             }
         }
         for (auto& entity : entities)
         {
+            auto renderable_entity = dynamic_cast<RenderableEntity*>(entity.get());
+            //raytraced entities can still show up in reflections/shadows, so only raster-only entities can be skipped entirely
+            if (renderable_entity && !engine->renderer.RaytraceEnabled() && !renderable_entity->visible && !renderable_entity->shadow_visible)
+                continue;
             entity->render_all(engine, entity);
-            if (auto renderable_entity = dynamic_cast<RenderableEntity*>(entity.get()))
+            if (renderable_entity)
             {
                 if (engine->renderer.RaytraceEnabled())
                 {
-                    renderable_entity->populate_AS(top_level_as[image_index].get(), image_index);
+                    renderable_entity->populate_AS(top_level_as[frame_index].get(), frame_index);
                 }
             }
         }
         if (engine->renderer.RaytraceEnabled())
         {
-           engine->worker_pool.addWork(std::make_unique<AccelerationBuildTask>(top_level_as[image_index]));
+           engine->worker_pool.addWork(std::make_unique<AccelerationBuildTask>(top_level_as[frame_index]));
+        }
+    }
+
+    void Scene::cullEntities()
+    {
+        auto camera = engine->camera;
+        bool shadowmaps = engine->renderer.render_mode == RenderMode::Rasterization;
+
+        for (const auto& entity : entities)
+        {
+            if (auto renderable_entity = dynamic_cast<RenderableEntity*>(entity.get()))
+            {
+                renderable_entity->updateBounds();
+                if (!camera || !renderable_entity->world_bounds.valid())
+                {
+                    //landscape requests its textures per visible instance instead
+                    if (!dynamic_cast<LandscapeEntity*>(renderable_entity))
+                        requestTextures(renderable_entity, 0.f);
+                    renderable_entity->visible = true;
+                    renderable_entity->shadow_visible = true;
+                    renderable_entity->cascade_visible.fill(true);
+                    continue;
+                }
+                renderable_entity->visible = camera->frustum.intersects(renderable_entity->world_sphere);
+                if (renderable_entity->visible)
+                {
+                    float distance = std::max(glm::distance(camera->getPos(), renderable_entity->world_sphere.center) - renderable_entity->world_sphere.radius, 0.f);
+                    requestTextures(renderable_entity, distance);
+                }
+                if (shadowmaps)
+                {
+                    //the cascade frustums already reach back towards the light, so anything casting into them is inside
+                    renderable_entity->shadow_visible = false;
+                    for (uint32_t i = 0; i < Renderer::shadowmap_cascades; ++i)
+                    {
+                        renderable_entity->cascade_visible[i] = camera->cascade_frustums[i].intersects(renderable_entity->world_sphere);
+                        renderable_entity->shadow_visible |= renderable_entity->cascade_visible[i];
+                    }
+                }
+                else
+                {
+                    renderable_entity->shadow_visible = renderable_entity->visible;
+                    renderable_entity->cascade_visible.fill(renderable_entity->visible);
+                }
+            }
+        }
+    }
+
+    void Scene::requestTextures(RenderableEntity* entity, float distance)
+    {
+        for (const auto& model : entity->models)
+        {
+            for (const auto& mesh : model->meshes)
+            {
+                if (mesh->texture)
+                    engine->renderer.texture_streamer->request(mesh->texture.get(), distance);
+            }
         }
     }
 
@@ -63,12 +129,67 @@ namespace lotus
         {
             entity->tick_all(time, delta);
         }
-        entities.erase(std::remove_if(entities.begin(), entities.end(), [](auto& entity)
+        updateAnimations(time);
+        entities.erase(std::remove_if(entities.begin(), entities.end(), [this](auto& entity)
         {
-            return entity->should_remove();
+            if (entity->should_remove())
+            {
+                spatial_grid.remove(entity.get());
+                return true;
+            }
+            return false;
         }), entities.end());
+        //batch the index updates so entities moving several times in a tick only get re-binned once
+        for (const auto& entity : entities)
+        {
+            if (entity->has_moved())
+            {
+                spatial_grid.update(entity.get(), entity->getPos());
+                entity->clear_moved();
+            }
+        }
+        for (const auto& entity : new_entities)
+        {
+            spatial_grid.insert(entity, entity->getPos());
+            entity->clear_moved();
+        }
         entities.insert(entities.end(), std::move_iterator(new_entities.begin()), std::move_iterator(new_entities.end()));
         new_entities.clear();
     }
+
+    void Scene::updateAnimations(time_point time)
+    {
+        animation_components.clear();
+        for (const auto& entity : entities)
+        {
+            if (auto deformable_entity = dynamic_cast<DeformableEntity*>(entity.get()); deformable_entity && deformable_entity->animation_component)
+            {
+                animation_components.push_back(deformable_entity->animation_component);
+            }
+        }
+        //each pose only depends on its own component and the tick time, so the result doesn't depend on how the chunks get split up
+        engine->worker_pool.parallelFor(animation_components.size(), animation_chunk_size, [this, time](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                animation_components[i]->updatePose(time);
+            }
+        });
+    }
+
+    std::vector<std::shared_ptr<Entity>> Scene::getEntitiesInRange(const AABB& range, const SpatialGrid::Filter& filter) const
+    {
+        return spatial_grid.queryRange(range, filter);
+    }
+
+    std::vector<std::shared_ptr<Entity>> Scene::getEntitiesInRadius(glm::vec3 center, float radius, const SpatialGrid::Filter& filter) const
+    {
+        return spatial_grid.queryRadius(center, radius, filter);
+    }
+
+    std::shared_ptr<Entity> Scene::getNearestEntity(glm::vec3 center, float max_radius, const SpatialGrid::Filter& filter) const
+    {
+        return spatial_grid.queryNearest(center, max_radius, filter);
+    }
 }
 
@@ -3,10 +3,13 @@
 #include <memory>
 #include <vector>
 #include "renderer/acceleration_structure.h"
+#include "spatial_grid.h"
 
 namespace lotus
 {
     class Engine;
+    class RenderableEntity;
+    class AnimationComponent;
 
     class Scene
     {
@@ -29,12 +32,28 @@ namespace lotus
                 func(entity);
             }
         }
+
+        //spatial queries use entity positions as of the last tick_all
+        std::vector<std::shared_ptr<Entity>> getEntitiesInRange(const AABB& range, const SpatialGrid::Filter& filter = {}) const;
+        std::vector<std::shared_ptr<Entity>> getEntitiesInRadius(glm::vec3 center, float radius, const SpatialGrid::Filter& filter = {}) const;
+        std::shared_ptr<Entity> getNearestEntity(glm::vec3 center, float max_radius, const SpatialGrid::Filter& filter = {}) const;
+
         std::vector<std::shared_ptr<TopLevelAccelerationStructure>> top_level_as;
     protected:
         virtual void tick(time_point time, duration delta) {}
+        void cullEntities();
+        //samples every animated entity's pose across the worker pool, once all entities have ticked
+        void updateAnimations(time_point time);
+        //marks the entity's textures as wanted by the streamer this frame
+        void requestTextures(RenderableEntity* entity, float distance);
 
         Engine* engine;
         std::vector<std::shared_ptr<Entity>> entities;
         std::vector<std::shared_ptr<Entity>> new_entities;
+        SpatialGrid spatial_grid;
+        //reused by updateAnimations every tick
+        std::vector<AnimationComponent*> animation_components;
+        //few enough that a chunk is worth handing to a worker, enough that the actors spread over all of them
+        static constexpr size_t animation_chunk_size{ 16 };
     };
 }
@@ -0,0 +1,181 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include "entity/entity.h"
+
+namespace lotus
+{
+    SpatialGrid::SpatialGrid(float _cell_size) : cell_size(_cell_size)
+    {
+    }
+
+    void SpatialGrid::insert(const std::shared_ptr<Entity>& entity, glm::vec3 pos)
+    {
+        if (entity_cells.contains(entity.get()))
+        {
+            update(entity.get(), pos);
+            return;
+        }
+        auto key = getCellKey(getCellCoord(pos));
+        cells[key].push_back({ entity, pos });
+        occupied.extend(pos);
+        entity_cells[entity.get()] = key;
+    }
+
+    void SpatialGrid::update(Entity* entity, glm::vec3 pos)
+    {
+        auto found = entity_cells.find(entity);
+        if (found == entity_cells.end())
+            return;
+
+        auto& old_cell = cells[found->second];
+        auto entry = std::find_if(old_cell.begin(), old_cell.end(), [entity](const auto& entry) { return entry.entity.get() == entity; });
+        auto new_key = getCellKey(getCellCoord(pos));
+        occupied.extend(pos);
+
+        if (new_key == found->second)
+        {
+            entry->pos = pos;
+            return;
+        }
+
+        auto entity_sp = std::move(entry->entity);
+        *entry = std::move(old_cell.back());
+        old_cell.pop_back();
+        if (old_cell.empty())
+            cells.erase(found->second);
+
+        cells[new_key].push_back({ std::move(entity_sp), pos });
+        found->second = new_key;
+    }
+
+    void SpatialGrid::remove(Entity* entity)
+    {
+        auto found = entity_cells.find(entity);
+        if (found == entity_cells.end())
+            return;
+
+        auto& cell = cells[found->second];
+        auto entry = std::find_if(cell.begin(), cell.end(), [entity](const auto& entry) { return entry.entity.get() == entity; });
+        *entry = std::move(cell.back());
+        cell.pop_back();
+        if (cell.empty())
+            cells.erase(found->second);
+        entity_cells.erase(found);
+    }
+
+    void SpatialGrid::clear()
+    {
+        cells.clear();
+        entity_cells.clear();
+        occupied = {};
+    }
+
+    glm::ivec3 SpatialGrid::getCellCoord(glm::vec3 pos) const
+    {
+        return glm::ivec3(glm::floor(pos / cell_size));
+    }
+
+    SpatialGrid::CellKey SpatialGrid::getCellKey(glm::ivec3 coord)
+    {
+        //21 bits per axis
+        constexpr uint64_t mask = (1ull << 21) - 1;
+        return (static_cast<uint64_t>(coord.x) & mask) | ((static_cast<uint64_t>(coord.y) & mask) << 21) | ((static_cast<uint64_t>(coord.z) & mask) << 42);
+    }
+
+    template<typename F>
+    void SpatialGrid::forEachEntryInRange(const AABB& range, F func) const
+    {
+        //clamped to where entities are before converting to cells, so huge (or infinite) ranges stay representable
+        AABB clamped{ glm::max(range.min, occupied.min), glm::min(range.max, occupied.max) };
+        if (!clamped.valid())
+            return;
+        glm::ivec3 min_cell = getCellCoord(clamped.min);
+        glm::ivec3 max_cell = getCellCoord(clamped.max);
+        glm::i64vec3 extent = glm::i64vec3(max_cell - min_cell) + glm::i64vec3(1);
+
+        //for large ranges it's cheaper to walk the occupied cells than every cell in the range
+        if (extent.x * extent.y * extent.z > static_cast<int64_t>(cells.size()))
+        {
+            for (const auto& [key, cell] : cells)
+            {
+                for (const auto& entry : cell)
+                {
+                    func(entry);
+                }
+            }
+            return;
+        }
+
+        for (int x = min_cell.x; x <= max_cell.x; ++x)
+        {
+            for (int y = min_cell.y; y <= max_cell.y; ++y)
+            {
+                for (int z = min_cell.z; z <= max_cell.z; ++z)
+                {
+                    if (auto found = cells.find(getCellKey({ x, y, z })); found != cells.end())
+                    {
+                        for (const auto& entry : found->second)
+                        {
+                            func(entry);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<Entity>> SpatialGrid::queryRange(const AABB& range, const Filter& filter) const
+    {
+        std::vector<std::shared_ptr<Entity>> results;
+        forEachEntryInRange(range, [&](const Entry& entry)
+        {
+            if (glm::all(glm::greaterThanEqual(entry.pos, range.min)) && glm::all(glm::lessThanEqual(entry.pos, range.max)) &&
+                (!filter || filter(entry.entity)))
+            {
+                results.push_back(entry.entity);
+            }
+        });
+        return results;
+    }
+
+    std::vector<std::shared_ptr<Entity>> SpatialGrid::queryRadius(glm::vec3 center, float radius, const Filter& filter) const
+    {
+        std::vector<std::shared_ptr<Entity>> results;
+        float radius2 = radius * radius;
+        forEachEntryInRange({ center - radius, center + radius }, [&](const Entry& entry)
+        {
+            glm::vec3 diff = entry.pos - center;
+            if (glm::dot(diff, diff) <= radius2 && (!filter || filter(entry.entity)))
+            {
+                results.push_back(entry.entity);
+            }
+        });
+        return results;
+    }
+
+    std::shared_ptr<Entity> SpatialGrid::queryNearest(glm::vec3 center, float max_radius, const Filter& filter) const
+    {
+        //grow the search box until something is found - anything found within radius r is guaranteed closest once the box covers r
+        float radius = std::min(cell_size, max_radius);
+        while (true)
+        {
+            std::shared_ptr<Entity> nearest;
+            float nearest_dist2 = radius * radius;
+            forEachEntryInRange({ center - radius, center + radius }, [&](const Entry& entry)
+            {
+                glm::vec3 diff = entry.pos - center;
+                float dist2 = glm::dot(diff, diff);
+                if (dist2 <= nearest_dist2 && (!filter || filter(entry.entity)))
+                {
+                    nearest = entry.entity;
+                    nearest_dist2 = dist2;
+                }
+            });
+            //once the box covers every entity there's nothing further out to find
+            bool covers_all = glm::all(glm::lessThanEqual(center - radius, occupied.min)) && glm::all(glm::greaterThanEqual(center + radius, occupied.max));
+            if (nearest || radius >= max_radius || covers_all)
+                return nearest;
+            radius = std::min(radius * 2.f, max_radius);
+        }
+    }
+}
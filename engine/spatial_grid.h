@@ -0,0 +1,53 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <glm/glm.hpp>
+#include "renderer/bounds.h"
+
+namespace lotus
+{
+    class Entity;
+
+    //uniform hash grid of entity positions, updated incrementally as entities move
+    class SpatialGrid
+    {
+    public:
+        explicit SpatialGrid(float cell_size = 16.f);
+
+        void insert(const std::shared_ptr<Entity>& entity, glm::vec3 pos);
+        void update(Entity* entity, glm::vec3 pos);
+        void remove(Entity* entity);
+        void clear();
+
+        using Filter = std::function<bool(const std::shared_ptr<Entity>&)>;
+
+        std::vector<std::shared_ptr<Entity>> queryRange(const AABB& range, const Filter& filter = {}) const;
+        std::vector<std::shared_ptr<Entity>> queryRadius(glm::vec3 center, float radius, const Filter& filter = {}) const;
+        std::shared_ptr<Entity> queryNearest(glm::vec3 center, float max_radius, const Filter& filter = {}) const;
+
+        size_t size() const { return entity_cells.size(); }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<Entity> entity;
+            glm::vec3 pos;
+        };
+
+        using CellKey = uint64_t;
+
+        glm::ivec3 getCellCoord(glm::vec3 pos) const;
+        static CellKey getCellKey(glm::ivec3 coord);
+
+        template<typename F>
+        void forEachEntryInRange(const AABB& range, F func) const;
+
+        float cell_size;
+        std::unordered_map<CellKey, std::vector<Entry>> cells;
+        std::unordered_map<Entity*, CellKey> entity_cells;
+        //every position ever inserted (only grows until clear), so unbounded queries can be clamped to it
+        AABB occupied;
+    };
+}
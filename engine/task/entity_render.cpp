@@ -7,6 +7,7 @@
 
 #include "engine/game.h"
 #include "engine/entity/component/animation_component.h"
+#include "engine/renderer/bone_palette.h"
 
 namespace lotus
 {
@@ -17,34 +18,40 @@ namespace lotus
 
     void EntityRenderTask::Process(WorkerThread* thread)
     {
-        auto image_index = thread->engine->renderer.getCurrentImage();
-        updateUniformBuffer(thread, image_index, entity.get());
+        auto frame_index = thread->engine->renderer.getCurrentFrame();
+        updateUniformBuffer(thread, frame_index, entity.get());
         if (auto deformable = dynamic_cast<DeformableEntity*>(entity.get()))
         {
-            updateAnimationVertices(thread, image_index, deformable);
+            updateAnimationVertices(thread, frame_index, deformable);
         }
         if (thread->engine->renderer.RasterizationEnabled())
         {
             if (dynamic_cast<Particle*>(entity.get()))
             {
-                graphics.particle = *entity->command_buffers[image_index];
+                if (entity->visible)
+                    graphics.particle = *entity->command_buffers[frame_index];
             }
             else
             {
-                graphics.secondary = *entity->command_buffers[image_index];
-                graphics.shadow = *entity->shadowmap_buffers[image_index];
+                if (entity->visible)
+                    graphics.secondary = *entity->command_buffers[frame_index];
+                for (uint32_t i = 0; i < Renderer::shadowmap_cascades; ++i)
+                {
+                    if (entity->cascade_visible[i])
+                        graphics.shadow[i] = *entity->shadowmap_buffers[frame_index * Renderer::shadowmap_cascades + i];
+                }
             }
         }
     }
 
-    void EntityRenderTask::updateUniformBuffer(WorkerThread* thread, int image_index, RenderableEntity* entity)
+    void EntityRenderTask::updateUniformBuffer(WorkerThread* thread, int frame_index, RenderableEntity* entity)
     {
-        RenderableEntity::UniformBufferObject* ubo = reinterpret_cast<RenderableEntity::UniformBufferObject*>(entity->uniform_buffer_mapped + (image_index * thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject))));
+        RenderableEntity::UniformBufferObject* ubo = reinterpret_cast<RenderableEntity::UniformBufferObject*>(entity->constants.getModel(frame_index));
         ubo->model = entity->getModelMatrix();
         ubo->modelIT = glm::transpose(glm::inverse(glm::mat3(ubo->model)));
     }
 
-    void EntityRenderTask::updateAnimationVertices(WorkerThread* thread, int image_index, DeformableEntity* entity)
+    void EntityRenderTask::updateAnimationVertices(WorkerThread* thread, int frame_index, DeformableEntity* entity)
     {
         auto component = entity->animation_component;
         auto& skeleton = component->skeleton;
@@ -64,10 +71,14 @@ namespace lotus
 
         command_buffer->bindPipeline(vk::PipelineBindPoint::eCompute, *thread->engine->renderer.animation_pipeline);
 
+        //the bones go straight into this frame's part of the palette, which the dispatches below read from
+        auto bones = thread->engine->renderer.bone_palette->allocate(sizeof(AnimationComponent::BufferBone) * skeleton->bones.size());
+        component->writeBones(static_cast<AnimationComponent::BufferBone*>(bones.data));
+
         vk::DescriptorBufferInfo skeleton_buffer_info;
-        skeleton_buffer_info.buffer = entity->animation_component->skeleton_bone_buffer->buffer;
-        skeleton_buffer_info.offset = sizeof(AnimationComponent::BufferBone) * skeleton->bones.size() * image_index;
-        skeleton_buffer_info.range = sizeof(AnimationComponent::BufferBone) * skeleton->bones.size();
+        skeleton_buffer_info.buffer = bones.buffer;
+        skeleton_buffer_info.offset = bones.offset;
+        skeleton_buffer_info.range = bones.size;
 
         vk::WriteDescriptorSet skeleton_descriptor_set = {};
 
@@ -86,7 +97,7 @@ namespace lotus
             for (size_t j = 0; j < entity->models[i]->meshes.size(); ++j)
             {
                 auto& mesh = entity->models[i]->meshes[j];
-                auto& vertex_buffer = component->transformed_geometries[i].vertex_buffers[j][image_index];
+                auto& vertex_buffer = component->transformed_geometries[i].vertex_buffers[j][frame_index];
 
                 vk::DescriptorBufferInfo vertex_weights_buffer_info;
                 vertex_weights_buffer_info.buffer = mesh->vertex_buffer->buffer;
@@ -130,7 +141,7 @@ namespace lotus
             }
             if (thread->engine->renderer.RaytraceEnabled())
             {
-                component->transformed_geometries[i].bottom_level_as[image_index]->Update(*command_buffer);
+                component->transformed_geometries[i].bottom_level_as[frame_index]->Update(*command_buffer);
             }
         }
         command_buffer->end();
@@ -14,13 +14,10 @@ namespace lotus
 
     void LandscapeEntityInitTask::Process(WorkerThread* thread)
     {
-        entity->uniform_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-        entity->mesh_index_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-        entity->uniform_buffer_mapped = static_cast<uint8_t*>(entity->uniform_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), {}));
-        entity->mesh_index_buffer_mapped = static_cast<uint8_t*>(entity->mesh_index_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), {}));
+        entity->constants = thread->engine->renderer.constant_arena->allocate();
 
         populateInstanceBuffer(thread);
+        populateVisibleInstanceBuffers(thread);
         createCommandBuffers(thread);
     }
 
@@ -29,9 +26,10 @@ namespace lotus
         vk::CommandBufferAllocateInfo alloc_info;
         alloc_info.level = vk::CommandBufferLevel::eSecondary;
         alloc_info.commandPool = *thread->graphics_pool;
-        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getImageCount());
+        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getFrameCount());
 
         entity->command_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
+        alloc_info.commandBufferCount *= Renderer::shadowmap_cascades;
         entity->shadowmap_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
 
         if (thread->engine->renderer.RasterizationEnabled())
@@ -79,11 +77,11 @@ namespace lotus
 
                 command_buffer->pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.pipeline_layout, 0, descriptorWrites);
 
-                drawModel(thread, *command_buffer, false, *thread->engine->renderer.pipeline_layout);
+                drawModel(thread, *command_buffer, false, *thread->engine->renderer.pipeline_layout, i);
 
                 command_buffer->bindPipeline(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.landscape_pipeline_group.blended_graphics_pipeline);
 
-                drawModel(thread, *command_buffer, true, *thread->engine->renderer.pipeline_layout);
+                drawModel(thread, *command_buffer, true, *thread->engine->renderer.pipeline_layout, i);
 
                 command_buffer->end();
             }
@@ -94,10 +92,11 @@ namespace lotus
             for (size_t i = 0; i < entity->shadowmap_buffers.size(); ++i)
             {
                 auto& command_buffer = entity->shadowmap_buffers[i];
+                uint32_t frame = static_cast<uint32_t>(i / Renderer::shadowmap_cascades);
+                uint32_t cascade = static_cast<uint32_t>(i % Renderer::shadowmap_cascades);
                 vk::CommandBufferInheritanceInfo inheritInfo = {};
                 inheritInfo.renderPass = *thread->engine->renderer.shadowmap_render_pass;
-                //used in multiple framebuffers so we can't give the hint
-                //inheritInfo.framebuffer = *thread->engine->renderer.shadowmap_frame_buffer;
+                inheritInfo.framebuffer = *thread->engine->renderer.cascades[cascade].shadowmap_frame_buffer;
 
                 vk::CommandBufferBeginInfo beginInfo = {};
                 beginInfo.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
@@ -106,13 +105,13 @@ namespace lotus
                 command_buffer->begin(beginInfo);
 
                 vk::DescriptorBufferInfo buffer_info;
-                buffer_info.buffer = entity->uniform_buffer->buffer;
-                buffer_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject));
+                buffer_info.buffer = entity->constants.getBuffer();
+                buffer_info.offset = entity->constants.getModelOffset(frame);
                 buffer_info.range = sizeof(RenderableEntity::UniformBufferObject);
 
                 vk::DescriptorBufferInfo cascade_buffer_info;
                 cascade_buffer_info.buffer = thread->engine->camera->cascade_data_ubo->buffer;
-                cascade_buffer_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(thread->engine->camera->cascade_data));
+                cascade_buffer_info.offset = frame * thread->engine->renderer.uniform_buffer_align_up(sizeof(thread->engine->camera->cascade_data));
                 cascade_buffer_info.range = sizeof(thread->engine->camera->cascade_data);
 
                 std::array<vk::WriteDescriptorSet, 2> descriptorWrites = {};
@@ -133,26 +132,35 @@ namespace lotus
 
                 command_buffer->pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.shadowmap_pipeline_layout, 0, descriptorWrites);
 
+                command_buffer->pushConstants<uint32_t>(*thread->engine->renderer.shadowmap_pipeline_layout, vk::ShaderStageFlagBits::eVertex, sizeof(uint32_t), cascade);
                 command_buffer->setDepthBias(1.25f, 0, 1.75f);
 
                 command_buffer->bindPipeline(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.landscape_pipeline_group.shadowmap_pipeline);
-                drawModel(thread, *command_buffer, false, *thread->engine->renderer.shadowmap_pipeline_layout);
+                drawModel(thread, *command_buffer, false, *thread->engine->renderer.shadowmap_pipeline_layout, frame, LandscapeEntity::getCascadeView(cascade));
                 command_buffer->bindPipeline(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.landscape_pipeline_group.blended_shadowmap_pipeline);
-                drawModel(thread, *command_buffer, true, *thread->engine->renderer.shadowmap_pipeline_layout);
+                drawModel(thread, *command_buffer, true, *thread->engine->renderer.shadowmap_pipeline_layout, frame, LandscapeEntity::getCascadeView(cascade));
 
                 command_buffer->end();
             }
         }
     }
 
-    void LandscapeEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer command_buffer, bool transparency, vk::PipelineLayout layout)
+    void LandscapeEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer command_buffer, bool transparency, vk::PipelineLayout layout, std::optional<uint32_t> frame, uint32_t view)
     {
-        for (const auto& model : entity->models)
+        //fall back to drawing every instance if there's nothing to cull into
+        if (!entity->visible_instance_buffer || !entity->indirect_buffer)
+            frame.reset();
+
+        for (size_t model_i = 0; model_i < entity->models.size(); ++model_i)
         {
+            const auto& model = entity->models[model_i];
             auto [offset, count] = entity->instance_offsets[model->name];
             if (count > 0 && !model->meshes.empty())
             {
-                command_buffer.bindVertexBuffers(1, entity->instance_buffer->buffer, offset * sizeof(LandscapeEntity::InstanceInfo));
+                if (frame)
+                    command_buffer.bindVertexBuffers(1, entity->visible_instance_buffer->buffer, entity->getVisibleInstanceOffset(*frame, view, offset));
+                else
+                    command_buffer.bindVertexBuffers(1, entity->instance_buffer->buffer, offset * sizeof(LandscapeEntity::InstanceInfo));
                 uint32_t material_index = 1;
                 for (size_t i = 0; i < model->meshes.size(); ++i)
                 {
@@ -163,14 +171,17 @@ namespace lotus
                         {
                             material_index = model->bottom_level_as->resource_index + i;
                         }
-                        drawMesh(thread, command_buffer, *mesh, count, layout, material_index);
+                        if (frame)
+                            drawMesh(thread, command_buffer, *mesh, count, layout, material_index, entity->getIndirectOffset(*frame, view, entity->model_draw_offsets[model_i] + static_cast<uint32_t>(i)));
+                        else
+                            drawMesh(thread, command_buffer, *mesh, count, layout, material_index);
                     }
                 }
             }
         }
     }
 
-    void LandscapeEntityInitTask::drawMesh(WorkerThread* thread, vk::CommandBuffer command_buffer, const Mesh& mesh, uint32_t count, vk::PipelineLayout layout, uint32_t material_index)
+    void LandscapeEntityInitTask::drawMesh(WorkerThread* thread, vk::CommandBuffer command_buffer, const Mesh& mesh, uint32_t count, vk::PipelineLayout layout, uint32_t material_index, std::optional<vk::DeviceSize> indirect_offset)
     {
         vk::DescriptorImageInfo image_info;
         image_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
@@ -198,14 +209,20 @@ namespace lotus
         command_buffer.bindVertexBuffers(0, mesh.vertex_buffer->buffer, {0});
         command_buffer.bindIndexBuffer(mesh.index_buffer->buffer, {0}, vk::IndexType::eUint16);
 
-        command_buffer.drawIndexed(mesh.getIndexCount(), count, 0, 0, 0);
+        if (indirect_offset)
+            command_buffer.drawIndexedIndirect(entity->indirect_buffer->buffer, *indirect_offset, 1, sizeof(vk::DrawIndexedIndirectCommand));
+        else
+            command_buffer.drawIndexed(mesh.getIndexCount(), count, 0, 0, 0);
     }
 
     void LandscapeEntityInitTask::populateInstanceBuffer(WorkerThread* thread)
     {
         vk::DeviceSize buffer_size = sizeof(LandscapeEntity::InstanceInfo) * instance_info.size();
 
-        staging_buffer = thread->engine->renderer.memory_manager->GetBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        entity->instance_buffer = thread->engine->renderer.memory_manager->GetBuffer(buffer_size,
+            vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::LandscapeMesh);
+
+        staging_buffer = thread->engine->renderer.memory_manager->GetBuffer(buffer_size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging);
 
         void* data = staging_buffer->map(0, buffer_size, {});
         memcpy(data, instance_info.data(), buffer_size);
@@ -245,6 +262,52 @@ namespace lotus
         graphics.primary = *command_buffer;
     }
 
+    void LandscapeEntityInitTask::populateVisibleInstanceBuffers(WorkerThread* thread)
+    {
+        auto frame_count = thread->engine->renderer.getFrameCount();
+
+        std::vector<vk::DrawIndexedIndirectCommand> draws;
+        entity->model_draw_offsets.clear();
+        entity->model_instance_ranges.clear();
+        for (const auto& model : entity->models)
+        {
+            auto [offset, count] = entity->instance_offsets[model->name];
+            entity->model_draw_offsets.push_back(static_cast<uint32_t>(draws.size()));
+            entity->model_instance_ranges.emplace_back(offset, count);
+            for (const auto& mesh : model->meshes)
+            {
+                draws.emplace_back(static_cast<uint32_t>(mesh->getIndexCount()), count, 0, 0, 0);
+            }
+        }
+        entity->draw_count = static_cast<uint32_t>(draws.size());
+        entity->view_count = 1;
+        if (thread->engine->renderer.render_mode == RenderMode::Rasterization)
+            entity->view_count += Renderer::shadowmap_cascades;
+
+        if (entity->instance_info.empty() || draws.empty())
+            return;
+
+        //every frame/view starts with the full instance list so nothing is culled until the entity writes its own
+        vk::DeviceSize instance_size = sizeof(LandscapeEntity::InstanceInfo) * entity->instance_info.size();
+        vk::DeviceSize draw_size = sizeof(vk::DrawIndexedIndirectCommand) * draws.size();
+        uint32_t slot_count = frame_count * entity->view_count;
+
+        entity->visible_instance_buffer = thread->engine->renderer.memory_manager->GetBuffer(instance_size * slot_count,
+            vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::LandscapeMesh);
+        entity->indirect_buffer = thread->engine->renderer.memory_manager->GetBuffer(draw_size * slot_count,
+            vk::BufferUsageFlagBits::eIndirectBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::LandscapeMesh);
+
+        auto instances_mapped = static_cast<uint8_t*>(entity->visible_instance_buffer->map(0, instance_size * slot_count, {}));
+        auto draws_mapped = static_cast<uint8_t*>(entity->indirect_buffer->map(0, draw_size * slot_count, {}));
+        for (uint32_t i = 0; i < slot_count; ++i)
+        {
+            memcpy(instances_mapped + instance_size * i, entity->instance_info.data(), instance_size);
+            memcpy(draws_mapped + draw_size * i, draws.data(), draw_size);
+        }
+        entity->visible_instance_buffer_mapped = reinterpret_cast<LandscapeEntity::InstanceInfo*>(instances_mapped);
+        entity->indirect_buffer_mapped = reinterpret_cast<vk::DrawIndexedIndirectCommand*>(draws_mapped);
+    }
+
     LandscapeEntityReInitTask::LandscapeEntityReInitTask(const std::shared_ptr<LandscapeEntity>& entity) : LandscapeEntityInitTask(entity, {})
     {
     }
@@ -1,4 +1,5 @@
 #pragma once
+#include <optional>
 #include "engine/work_item.h"
 #include "engine/entity/landscape_entity.h"
 
@@ -11,9 +12,11 @@ namespace lotus
         virtual void Process(WorkerThread*) override;
     protected:
         void createCommandBuffers(WorkerThread* thread);
-        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout);
-        void drawMesh(WorkerThread* thread, vk::CommandBuffer buffer, const Mesh& mesh, uint32_t count, vk::PipelineLayout, uint32_t material_index);
+        //with a frame index, instances and counts come from the entity's per-frame visible buffers for that view
+        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout, std::optional<uint32_t> frame = {}, uint32_t view = LandscapeEntity::gbuffer_view);
+        void drawMesh(WorkerThread* thread, vk::CommandBuffer buffer, const Mesh& mesh, uint32_t count, vk::PipelineLayout, uint32_t material_index, std::optional<vk::DeviceSize> indirect_offset = {});
         void populateInstanceBuffer(WorkerThread* thread);
+        void populateVisibleInstanceBuffers(WorkerThread* thread);
         std::shared_ptr<LandscapeEntity> entity;
         std::vector<LandscapeEntity::InstanceInfo> instance_info;
         std::unique_ptr<Buffer> staging_buffer;
@@ -2,11 +2,12 @@
 #include <utility>
 #include "../worker_thread.h"
 #include "../core.h"
+#include "../renderer/upload_batcher.h"
 
 namespace lotus
 {
-    ModelInitTask::ModelInitTask(int _image_index, std::shared_ptr<Model> _model, std::vector<std::vector<uint8_t>>&& _vertex_buffers, std::vector<std::vector<uint8_t>>&& _index_buffers, uint32_t _vertex_stride) :
-        WorkItem(), image_index(_image_index), model(std::move(_model)), vertex_buffers(std::move(_vertex_buffers)), index_buffers(std::move(_index_buffers)), vertex_stride(_vertex_stride)
+    ModelInitTask::ModelInitTask(int _frame_index, std::shared_ptr<Model> _model, std::vector<std::vector<uint8_t>>&& _vertex_buffers, std::vector<std::vector<uint8_t>>&& _index_buffers, uint32_t _vertex_stride) :
+        WorkItem(), frame_index(_frame_index), model(std::move(_model)), vertex_buffers(std::move(_vertex_buffers)), index_buffers(std::move(_index_buffers)), vertex_stride(_vertex_stride)
     {
         priority = -1;
     }
@@ -18,32 +19,6 @@ namespace lotus
             std::vector<vk::AccelerationStructureGeometryKHR> raytrace_geometry;
             std::vector<vk::AccelerationStructureBuildOffsetInfoKHR> raytrace_offset_info;
             std::vector<vk::AccelerationStructureCreateGeometryTypeInfoKHR> raytrace_create_info;
-            vk::CommandBufferAllocateInfo alloc_info = {};
-            alloc_info.level = vk::CommandBufferLevel::ePrimary;
-            alloc_info.commandPool = *thread->graphics_pool;
-            alloc_info.commandBufferCount = 1;
-
-            auto command_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
-
-            vk::DeviceSize staging_buffer_size = 0;
-            for (int i = 0; i < vertex_buffers.size(); ++i)
-            {
-                auto& vertex_buffer = vertex_buffers[i];
-                auto& index_buffer = index_buffers[i];
-                staging_buffer_size += vertex_buffer.size() + index_buffer.size();
-            }
-
-            staging_buffer = thread->engine->renderer.memory_manager->GetBuffer(staging_buffer_size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-            uint8_t* staging_buffer_data = static_cast<uint8_t*>(staging_buffer->map(0, staging_buffer_size, {}));
-
-            vk::DeviceSize staging_buffer_offset = 0;
-
-            command_buffer = std::move(command_buffers[0]);
-
-            vk::CommandBufferBeginInfo begin_info = {};
-            begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-
-            command_buffer->begin(begin_info);
 
             for (int i = 0; i < vertex_buffers.size(); ++i)
             {
@@ -51,16 +26,12 @@ namespace lotus
                 auto& index_buffer = index_buffers[i];
                 auto& mesh = model->meshes[i];
 
-                memcpy(staging_buffer_data + staging_buffer_offset, vertex_buffer.data(), vertex_buffer.size());
-                memcpy(staging_buffer_data + staging_buffer_offset + vertex_buffer.size(), index_buffer.data(), index_buffer.size());
-
-                vk::BufferCopy copy_region;
-                copy_region.srcOffset = staging_buffer_offset;
-                copy_region.size = vertex_buffer.size();
-                command_buffer->copyBuffer(staging_buffer->buffer, mesh->vertex_buffer->buffer, copy_region);
-                copy_region.size = index_buffer.size();
-                copy_region.srcOffset = vertex_buffer.size() + staging_buffer_offset;
-                command_buffer->copyBuffer(staging_buffer->buffer, mesh->index_buffer->buffer, copy_region);
+                //shared buffers were uploaded by the mesh that created them
+                if (!mesh->hasSharedBuffers())
+                {
+                    thread->engine->renderer.upload_batcher->uploadBuffer(mesh->vertex_buffer->buffer, 0, vertex_buffer.data(), vertex_buffer.size());
+                    thread->engine->renderer.upload_batcher->uploadBuffer(mesh->index_buffer->buffer, 0, index_buffer.data(), index_buffer.size());
+                }
 
                 if (thread->engine->renderer.RaytraceEnabled() && !model->weighted)
                 {
@@ -77,18 +48,24 @@ namespace lotus
                     raytrace_create_info.emplace_back(vk::GeometryTypeKHR::eTriangles, static_cast<uint32_t>((index_buffer.size() / sizeof(uint16_t)) / 3),
                         vk::IndexType::eUint16, static_cast<uint32_t>(vertex_buffer.size() / vertex_stride), vk::Format::eR32G32B32Sfloat, false);
                 }
-
-                staging_buffer_offset += vertex_buffer.size() + index_buffer.size();
             }
-            staging_buffer->unmap();
 
+            //the batcher's copies are submitted ahead of this with a barrier, so the acceleration structure can be built from them straight away
             if (thread->engine->renderer.RaytraceEnabled() && !model->weighted)
             {
-                //TODO: test if just buffermemorybarrier is faster
-                vk::MemoryBarrier barrier;
-                barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-                barrier.dstAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR | vk::AccessFlagBits::eAccelerationStructureReadKHR;
-                command_buffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, {}, barrier, nullptr, nullptr);
+                vk::CommandBufferAllocateInfo alloc_info = {};
+                alloc_info.level = vk::CommandBufferLevel::ePrimary;
+                alloc_info.commandPool = *thread->graphics_pool;
+                alloc_info.commandBufferCount = 1;
+
+                auto command_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
+                command_buffer = std::move(command_buffers[0]);
+
+                vk::CommandBufferBeginInfo begin_info = {};
+                begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+                command_buffer->begin(begin_info);
+
                 model->bottom_level_as = std::make_unique<BottomLevelAccelerationStructure>(thread->engine, *command_buffer, std::move(raytrace_geometry), std::move(raytrace_offset_info),
                     std::move(raytrace_create_info), false, model->lifetime == Lifetime::Long, BottomLevelAccelerationStructure::Performance::FastTrace);
 
@@ -106,9 +83,10 @@ namespace lotus
                         descriptor_vertex_info.emplace_back(mesh->vertex_buffer->buffer, 0, VK_WHOLE_SIZE);
                         descriptor_index_info.emplace_back(mesh->index_buffer->buffer, 0, VK_WHOLE_SIZE);
                         descriptor_texture_info.emplace_back(*mesh->texture->sampler, *mesh->texture->image_view, vk::ImageLayout::eShaderReadOnlyOptimal);
-                        for (int image = 0; image < thread->engine->renderer.getImageCount(); ++image)
+                        mesh->texture->static_bindings.push_back(index + static_cast<uint32_t>(i));
+                        for (int frame = 0; frame < thread->engine->renderer.getFrameCount(); ++frame)
                         {
-                            thread->engine->renderer.mesh_info_buffer_mapped[image * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, glm::vec3{1.f}, 0, model->light_offset, (uint32_t)mesh->getIndexCount() };
+                            thread->engine->renderer.mesh_info_buffer_mapped[frame * Renderer::max_acceleration_binding_index + index + i] = { index + (uint32_t)i, index + (uint32_t)i, mesh->specular_exponent, mesh->specular_intensity, glm::vec4{1.f}, glm::vec3{1.f}, 0, model->light_offset, (uint32_t)mesh->getIndexCount() };
                         }
                     }
                     model->bottom_level_as->resource_index = index;
@@ -136,7 +114,7 @@ namespace lotus
                     write_info_texture.pImageInfo = descriptor_texture_info.data();
 
                     std::vector<vk::WriteDescriptorSet> writes;
-                    for (size_t i = 0; i < thread->engine->renderer.getImageCount(); ++i)
+                    for (size_t i = 0; i < thread->engine->renderer.getFrameCount(); ++i)
                     {
                         write_info_vertex.dstSet = *thread->engine->renderer.rtx_descriptor_sets_const[i];
                         write_info_index.dstSet = *thread->engine->renderer.rtx_descriptor_sets_const[i];
@@ -147,10 +125,10 @@ namespace lotus
                     }
                     thread->engine->renderer.device->updateDescriptorSets(writes, nullptr);
                 }
-            }
-            command_buffer->end();
+                command_buffer->end();
 
-            graphics.primary = *command_buffer;
+                graphics.primary = *command_buffer;
+            }
         }
     }
 }
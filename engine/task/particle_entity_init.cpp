@@ -12,11 +12,7 @@ namespace lotus
 
     void ParticleEntityInitTask::Process(WorkerThread* thread)
     {
-        entity->uniform_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-        entity->mesh_index_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-        entity->uniform_buffer_mapped = static_cast<uint8_t*>(entity->uniform_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), {}));
-        entity->mesh_index_buffer_mapped = static_cast<uint8_t*>(entity->mesh_index_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), {}));
+        entity->constants = thread->engine->renderer.constant_arena->allocate();
 
         createStaticCommandBuffers(thread);
     }
@@ -26,7 +22,7 @@ namespace lotus
         vk::CommandBufferAllocateInfo alloc_info = {};
         alloc_info.level = vk::CommandBufferLevel::eSecondary;
         alloc_info.commandPool = *thread->graphics_pool;
-        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getImageCount());
+        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getFrameCount());
 
         if (thread->engine->renderer.RasterizationEnabled())
         {
@@ -55,8 +51,8 @@ namespace lotus
                 camera_buffer_info.range = sizeof(Camera::CameraData);
 
                 vk::DescriptorBufferInfo model_buffer_info;
-                model_buffer_info.buffer = entity->uniform_buffer->buffer;
-                model_buffer_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject));
+                model_buffer_info.buffer = entity->constants.getBuffer();
+                model_buffer_info.offset = entity->constants.getModelOffset(i);
                 model_buffer_info.range = sizeof(RenderableEntity::UniformBufferObject);
 
                 vk::DescriptorBufferInfo mesh_info;
@@ -65,8 +61,8 @@ namespace lotus
                 mesh_info.range = sizeof(Renderer::MeshInfo) * Renderer::max_acceleration_binding_index;
 
                 vk::DescriptorBufferInfo material_index_info;
-                material_index_info.buffer = entity->mesh_index_buffer->buffer;
-                material_index_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t));
+                material_index_info.buffer = entity->constants.getBuffer();
+                material_index_info.offset = entity->constants.getMeshIndexOffset(i);
                 material_index_info.range = sizeof(uint32_t);
 
                 std::array<vk::WriteDescriptorSet, 4> descriptorWrites = {};
@@ -112,7 +108,7 @@ namespace lotus
         }
     }
 
-    void ParticleEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout layout, size_t image)
+    void ParticleEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout layout, size_t frame)
     {
         for (size_t model_i = 0; model_i < entity->models.size(); ++model_i)
         {
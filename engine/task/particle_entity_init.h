@@ -13,7 +13,7 @@ namespace lotus
         virtual void Process(WorkerThread*) override;
     protected:
         void createStaticCommandBuffers(WorkerThread* thread);
-        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout, size_t image);
+        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, bool transparency, vk::PipelineLayout, size_t frame);
         void drawMesh(WorkerThread* thread, vk::CommandBuffer buffer, const Mesh& mesh, vk::PipelineLayout, uint32_t mesh_index);
 
         std::shared_ptr<Particle> entity;
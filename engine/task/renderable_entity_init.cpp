@@ -43,11 +43,7 @@ namespace lotus
             }
         }
 
-        entity->uniform_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-        entity->mesh_index_buffer = thread->engine->renderer.memory_manager->GetBuffer(thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-        entity->uniform_buffer_mapped = static_cast<uint8_t*>(entity->uniform_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject)) * thread->engine->renderer.getImageCount(), {}));
-        entity->mesh_index_buffer_mapped = static_cast<uint8_t*>(entity->mesh_index_buffer->map(0, thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t)) * thread->engine->renderer.getImageCount(), {}));
+        entity->constants = thread->engine->renderer.constant_arena->allocate();
         createStaticCommandBuffers(thread);
     }
 
@@ -56,9 +52,10 @@ namespace lotus
         vk::CommandBufferAllocateInfo alloc_info;
         alloc_info.level = vk::CommandBufferLevel::eSecondary;
         alloc_info.commandPool = *thread->graphics_pool;
-        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getImageCount());
+        alloc_info.commandBufferCount = static_cast<uint32_t>(thread->engine->renderer.getFrameCount());
 
         entity->command_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
+        alloc_info.commandBufferCount *= Renderer::shadowmap_cascades;
         entity->shadowmap_buffers = thread->engine->renderer.device->allocateCommandBuffersUnique<std::allocator<vk::UniqueHandle<vk::CommandBuffer, vk::DispatchLoaderDynamic>>>(alloc_info);
 
         auto deformable = dynamic_cast<DeformableEntity*>(entity.get());
@@ -86,8 +83,8 @@ namespace lotus
                 camera_buffer_info.range = sizeof(Camera::CameraData);
 
                 vk::DescriptorBufferInfo model_buffer_info;
-                model_buffer_info.buffer = entity->uniform_buffer->buffer;
-                model_buffer_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(RenderableEntity::UniformBufferObject));
+                model_buffer_info.buffer = entity->constants.getBuffer();
+                model_buffer_info.offset = entity->constants.getModelOffset(i);
                 model_buffer_info.range = sizeof(RenderableEntity::UniformBufferObject);
 
                 vk::DescriptorBufferInfo mesh_info;
@@ -96,8 +93,8 @@ namespace lotus
                 mesh_info.range = sizeof(Renderer::MeshInfo) * Renderer::max_acceleration_binding_index;
 
                 vk::DescriptorBufferInfo material_index_info;
-                material_index_info.buffer = entity->mesh_index_buffer->buffer;
-                material_index_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(uint32_t));
+                material_index_info.buffer = entity->constants.getBuffer();
+                material_index_info.offset = entity->constants.getMeshIndexOffset(i);
                 material_index_info.range = sizeof(uint32_t);
 
                 std::array<vk::WriteDescriptorSet, 4> descriptorWrites = {};
@@ -147,10 +144,11 @@ namespace lotus
             for (size_t i = 0; i < entity->shadowmap_buffers.size(); ++i)
             {
                 auto& command_buffer = entity->shadowmap_buffers[i];
+                size_t frame = i / Renderer::shadowmap_cascades;
+                uint32_t cascade = i % Renderer::shadowmap_cascades;
                 vk::CommandBufferInheritanceInfo inheritInfo = {};
                 inheritInfo.renderPass = *thread->engine->renderer.shadowmap_render_pass;
-                //used in multiple framebuffers so we can't give the hint
-                //inheritInfo.framebuffer = *thread->engine->renderer.shadowmap_frame_buffer;
+                inheritInfo.framebuffer = *thread->engine->renderer.cascades[cascade].shadowmap_frame_buffer;
 
                 vk::CommandBufferBeginInfo beginInfo = {};
                 beginInfo.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
@@ -159,13 +157,13 @@ namespace lotus
                 command_buffer->begin(beginInfo);
 
                 vk::DescriptorBufferInfo buffer_info;
-                buffer_info.buffer = entity->uniform_buffer->buffer;
-                buffer_info.offset = i * sizeof(RenderableEntity::UniformBufferObject);
+                buffer_info.buffer = entity->constants.getBuffer();
+                buffer_info.offset = entity->constants.getModelOffset(frame);
                 buffer_info.range = sizeof(RenderableEntity::UniformBufferObject);
 
                 vk::DescriptorBufferInfo cascade_buffer_info;
                 cascade_buffer_info.buffer = thread->engine->camera->cascade_data_ubo->buffer;
-                cascade_buffer_info.offset = i * thread->engine->renderer.uniform_buffer_align_up(sizeof(thread->engine->camera->cascade_data));
+                cascade_buffer_info.offset = frame * thread->engine->renderer.uniform_buffer_align_up(sizeof(thread->engine->camera->cascade_data));
                 cascade_buffer_info.range = sizeof(thread->engine->camera->cascade_data);
 
                 std::array<vk::WriteDescriptorSet, 2> descriptorWrites = {};
@@ -186,19 +184,20 @@ namespace lotus
 
                 command_buffer->pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.shadowmap_pipeline_layout, 0, descriptorWrites);
 
+                command_buffer->pushConstants<uint32_t>(*thread->engine->renderer.shadowmap_pipeline_layout, vk::ShaderStageFlagBits::eVertex, sizeof(uint32_t), cascade);
                 command_buffer->setDepthBias(1.25f, 0, 1.75f);
 
                 command_buffer->bindPipeline(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.main_pipeline_group.shadowmap_pipeline);
-                drawModel(thread, *command_buffer, deformable, false, *thread->engine->renderer.shadowmap_pipeline_layout, i);
+                drawModel(thread, *command_buffer, deformable, false, *thread->engine->renderer.shadowmap_pipeline_layout, frame);
                 command_buffer->bindPipeline(vk::PipelineBindPoint::eGraphics, *thread->engine->renderer.main_pipeline_group.blended_shadowmap_pipeline);
-                drawModel(thread, *command_buffer, deformable, true, *thread->engine->renderer.shadowmap_pipeline_layout, i);
+                drawModel(thread, *command_buffer, deformable, true, *thread->engine->renderer.shadowmap_pipeline_layout, frame);
 
                 command_buffer->end();
             }
         }
     }
 
-    void RenderableEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer command_buffer, DeformableEntity* deformable, bool transparency, vk::PipelineLayout layout, size_t image)
+    void RenderableEntityInitTask::drawModel(WorkerThread* thread, vk::CommandBuffer command_buffer, DeformableEntity* deformable, bool transparency, vk::PipelineLayout layout, size_t frame)
     {
         for (size_t model_i = 0; model_i < entity->models.size(); ++model_i)
         {
@@ -213,7 +212,7 @@ namespace lotus
                     {
                         if (deformable)
                         {
-                            command_buffer.bindVertexBuffers(0, deformable->animation_component->transformed_geometries[model_i].vertex_buffers[mesh_i][image]->buffer, {0});
+                            command_buffer.bindVertexBuffers(0, deformable->animation_component->transformed_geometries[model_i].vertex_buffers[mesh_i][frame]->buffer, {0});
                         }
                         else
                         {
@@ -267,24 +266,24 @@ namespace lotus
         std::vector<std::vector<vk::AccelerationStructureBuildOffsetInfoKHR>> raytrace_offset_info;
         std::vector<std::vector<vk::AccelerationStructureCreateGeometryTypeInfoKHR>> raytrace_create_info;
 
-        raytrace_geometry.resize(thread->engine->renderer.getImageCount());
-        raytrace_offset_info.resize(thread->engine->renderer.getImageCount());
-        raytrace_create_info.resize(thread->engine->renderer.getImageCount());
+        raytrace_geometry.resize(thread->engine->renderer.getFrameCount());
+        raytrace_offset_info.resize(thread->engine->renderer.getFrameCount());
+        raytrace_create_info.resize(thread->engine->renderer.getFrameCount());
         const auto& animation_component = entity->animation_component;
         vertex_buffer.resize(model.meshes.size());
         for (size_t i = 0; i < model.meshes.size(); ++i)
         {
             const auto& mesh = model.meshes[i];
 
-            for (uint32_t image = 0; image < thread->engine->renderer.getImageCount(); ++image)
+            for (uint32_t frame = 0; frame < thread->engine->renderer.getFrameCount(); ++frame)
             {
                 size_t vertex_size = mesh->getVertexInputBindingDescription()[0].stride;
                 vertex_buffer[i].push_back(thread->engine->renderer.memory_manager->GetBuffer(mesh->getVertexCount() * vertex_size,
-                    vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal));
+                    vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::SkinnedOutput));
 
                 if (thread->engine->renderer.RaytraceEnabled())
                 {
-                    raytrace_geometry[image].emplace_back(vk::GeometryTypeKHR::eTriangles, vk::AccelerationStructureGeometryTrianglesDataKHR{
+                    raytrace_geometry[frame].emplace_back(vk::GeometryTypeKHR::eTriangles, vk::AccelerationStructureGeometryTrianglesDataKHR{
                         vk::Format::eR32G32B32Sfloat,
                         thread->engine->renderer.device->getBufferAddressKHR(vertex_buffer[i].back()->buffer),
                         vertex_size,
@@ -292,9 +291,9 @@ namespace lotus
                         thread->engine->renderer.device->getBufferAddressKHR(mesh->index_buffer->buffer) 
                         }, mesh->has_transparency ? vk::GeometryFlagsKHR{} : vk::GeometryFlagBitsKHR::eOpaque);
 
-                    raytrace_offset_info[image].emplace_back(mesh->getIndexCount() / 3, 0, 0);
+                    raytrace_offset_info[frame].emplace_back(mesh->getIndexCount() / 3, 0, 0);
 
-                    raytrace_create_info[image].emplace_back(vk::GeometryTypeKHR::eTriangles, static_cast<uint32_t>(mesh->getIndexCount() / 3),
+                    raytrace_create_info[frame].emplace_back(vk::GeometryTypeKHR::eTriangles, static_cast<uint32_t>(mesh->getIndexCount() / 3),
                         vk::IndexType::eUint16, mesh->getVertexCount(), vk::Format::eR32G32B32Sfloat, false);
                 }
             }
@@ -313,30 +312,37 @@ namespace lotus
             auto& skeleton = component->skeleton;
             command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, *thread->engine->renderer.animation_pipeline);
 
-            for (uint32_t image_index = 0; image_index < thread->engine->renderer.getImageCount(); ++image_index)
-            {
-                vk::DescriptorBufferInfo skeleton_buffer_info;
-                skeleton_buffer_info.buffer = entity->animation_component->skeleton_bone_buffer->buffer;
-                skeleton_buffer_info.offset = sizeof(AnimationComponent::BufferBone) * skeleton->bones.size() * image_index;
-                skeleton_buffer_info.range = sizeof(AnimationComponent::BufferBone) * skeleton->bones.size();
+            //this can run outside of a frame, so the bones can't come from the frame's palette; the buffer lives as long as the task
+            vk::DeviceSize bones_size = sizeof(AnimationComponent::BufferBone) * skeleton->bones.size();
+            auto& bone_buffer = staging_buffers.emplace_back(thread->engine->renderer.memory_manager->GetBuffer(bones_size, vk::BufferUsageFlagBits::eStorageBuffer,
+                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging));
+            component->writeBones(static_cast<AnimationComponent::BufferBone*>(bone_buffer->map(0, bones_size, {})));
+            bone_buffer->unmap();
 
-                vk::WriteDescriptorSet skeleton_descriptor_set = {};
+            vk::DescriptorBufferInfo skeleton_buffer_info;
+            skeleton_buffer_info.buffer = bone_buffer->buffer;
+            skeleton_buffer_info.offset = 0;
+            skeleton_buffer_info.range = bones_size;
 
-                skeleton_descriptor_set.dstSet = nullptr;
-                skeleton_descriptor_set.dstBinding = 1;
-                skeleton_descriptor_set.dstArrayElement = 0;
-                skeleton_descriptor_set.descriptorType = vk::DescriptorType::eStorageBuffer;
-                skeleton_descriptor_set.descriptorCount = 1;
-                skeleton_descriptor_set.pBufferInfo = &skeleton_buffer_info;
+            vk::WriteDescriptorSet skeleton_descriptor_set = {};
 
-                command_buffer.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, *thread->engine->renderer.animation_pipeline_layout, 0, skeleton_descriptor_set);
+            skeleton_descriptor_set.dstSet = nullptr;
+            skeleton_descriptor_set.dstBinding = 1;
+            skeleton_descriptor_set.dstArrayElement = 0;
+            skeleton_descriptor_set.descriptorType = vk::DescriptorType::eStorageBuffer;
+            skeleton_descriptor_set.descriptorCount = 1;
+            skeleton_descriptor_set.pBufferInfo = &skeleton_buffer_info;
 
+            command_buffer.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, *thread->engine->renderer.animation_pipeline_layout, 0, skeleton_descriptor_set);
+
+            for (uint32_t frame_index = 0; frame_index < thread->engine->renderer.getFrameCount(); ++frame_index)
+            {
                 for (size_t i = 0; i < entity->models.size(); ++i)
                 {
                     for (size_t j = 0; j < entity->models[i]->meshes.size(); ++j)
                     {
                         auto& mesh = entity->models[i]->meshes[j];
-                        auto& vertex_buffer = component->transformed_geometries[i].vertex_buffers[j][image_index];
+                        auto& vertex_buffer = component->transformed_geometries[i].vertex_buffers[j][frame_index];
 
                         vk::DescriptorBufferInfo vertex_weights_buffer_info;
                         vertex_weights_buffer_info.buffer = mesh->vertex_buffer->buffer;
@@ -383,7 +389,7 @@ namespace lotus
                     }
                 }
             }
-            for (size_t i = 0; i < thread->engine->renderer.getImageCount(); ++i)
+            for (size_t i = 0; i < thread->engine->renderer.getFrameCount(); ++i)
             {
                 animation_component->transformed_geometries.back().bottom_level_as.push_back(std::make_unique<BottomLevelAccelerationStructure>(thread->engine, command_buffer, std::move(raytrace_geometry[i]),
                     std::move(raytrace_offset_info[i]), std::move(raytrace_create_info[i]), true, model.lifetime == Lifetime::Long, BottomLevelAccelerationStructure::Performance::FastBuild));
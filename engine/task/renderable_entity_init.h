@@ -13,7 +13,7 @@ namespace lotus
         virtual void Process(WorkerThread*) override;
     protected:
         void createStaticCommandBuffers(WorkerThread* thread);
-        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, DeformableEntity* deformable, bool transparency, vk::PipelineLayout, size_t image);
+        void drawModel(WorkerThread* thread, vk::CommandBuffer buffer, DeformableEntity* deformable, bool transparency, vk::PipelineLayout, size_t frame);
         void drawMesh(WorkerThread* thread, vk::CommandBuffer buffer, const Mesh& mesh, vk::PipelineLayout, uint32_t material_index);
         void generateVertexBuffers(WorkerThread* thread, vk::CommandBuffer buffer, DeformableEntity* deformable, const Model& mesh, std::vector<std::vector<std::unique_ptr<Buffer>>>& vertex_buffer);
         std::shared_ptr<RenderableEntity> entity;
@@ -1,6 +1,8 @@
 #pragma once
 #include <functional>
+#include <array>
 #include <engine/renderer/vulkan/vulkan_inc.h>
+#include <engine/renderer/vulkan/renderer.h>
 
 namespace lotus
 {
@@ -23,7 +25,8 @@ namespace lotus
         {
             vk::CommandBuffer primary;
             vk::CommandBuffer secondary;
-            vk::CommandBuffer shadow;
+            //one per cascade, so each cascade only draws what is inside its light frustum
+            std::array<vk::CommandBuffer, Renderer::shadowmap_cascades> shadow;
             vk::CommandBuffer particle;
         } graphics {};
 
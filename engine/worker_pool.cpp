@@ -1,6 +1,7 @@
 #include "worker_pool.h"
 #include "core.h"
 #include "work_item.h"
+#include "renderer/frame_allocator.h"
 #include <algorithm>
 
 namespace lotus
@@ -15,7 +16,7 @@ namespace lotus
             threads.push_back(std::make_unique<WorkerThread>(engine, this));
         }
 #endif
-        processing_work.resize(engine->renderer.getImageCount());
+        processing_work.resize(engine->renderer.getFrameCount());
     }
 
     WorkerPool::~WorkerPool()
@@ -60,10 +61,11 @@ namespace lotus
         idle_cv.notify_all();
     }
 
-    std::vector<vk::CommandBuffer> WorkerPool::getPrimaryGraphicsBuffers(int image)
+    std::pmr::vector<vk::CommandBuffer> WorkerPool::getPrimaryGraphicsBuffers(int frame)
     {
-        std::vector<vk::CommandBuffer> buffers;
-        for (const auto& task : processing_work[image])
+        std::pmr::vector<vk::CommandBuffer> buffers{ engine->renderer.frame_allocator->getResource() };
+        buffers.reserve(processing_work[frame].size());
+        for (const auto& task : processing_work[frame])
         {
             if (task->graphics.primary)
                 buffers.push_back(task->graphics.primary);
@@ -71,10 +73,11 @@ namespace lotus
         return buffers;
     }
 
-    std::vector<vk::CommandBuffer> WorkerPool::getSecondaryGraphicsBuffers(int image)
+    std::pmr::vector<vk::CommandBuffer> WorkerPool::getSecondaryGraphicsBuffers(int frame)
     {
-        std::vector<vk::CommandBuffer> buffers;
-        for (const auto& task : processing_work[image])
+        std::pmr::vector<vk::CommandBuffer> buffers{ engine->renderer.frame_allocator->getResource() };
+        buffers.reserve(processing_work[frame].size());
+        for (const auto& task : processing_work[frame])
         {
             if (task->graphics.secondary)
                 buffers.push_back(task->graphics.secondary);
@@ -82,21 +85,23 @@ namespace lotus
         return buffers;
     }
 
-    std::vector<vk::CommandBuffer> WorkerPool::getShadowmapGraphicsBuffers(int image)
+    std::pmr::vector<vk::CommandBuffer> WorkerPool::getShadowmapGraphicsBuffers(int frame, uint32_t cascade)
     {
-        std::vector<vk::CommandBuffer> buffers;
-        for (const auto& task : processing_work[image])
+        std::pmr::vector<vk::CommandBuffer> buffers{ engine->renderer.frame_allocator->getResource() };
+        buffers.reserve(processing_work[frame].size());
+        for (const auto& task : processing_work[frame])
         {
-            if (task->graphics.shadow)
-                buffers.push_back(task->graphics.shadow);
+            if (task->graphics.shadow[cascade])
+                buffers.push_back(task->graphics.shadow[cascade]);
         }
         return buffers;
     }
 
-    std::vector<vk::CommandBuffer> WorkerPool::getParticleGraphicsBuffers(int image)
+    std::pmr::vector<vk::CommandBuffer> WorkerPool::getParticleGraphicsBuffers(int frame)
     {
-        std::vector<vk::CommandBuffer> buffers;
-        for (const auto& task : processing_work[image])
+        std::pmr::vector<vk::CommandBuffer> buffers{ engine->renderer.frame_allocator->getResource() };
+        buffers.reserve(processing_work[frame].size());
+        for (const auto& task : processing_work[frame])
         {
             if (task->graphics.particle)
                 buffers.push_back(task->graphics.particle);
@@ -104,10 +109,11 @@ namespace lotus
         return buffers;
     }
 
-    std::vector<vk::CommandBuffer> WorkerPool::getPrimaryComputeBuffers(int image)
+    std::pmr::vector<vk::CommandBuffer> WorkerPool::getPrimaryComputeBuffers(int frame)
     {
-        std::vector<vk::CommandBuffer> buffers;
-        for (const auto& task : processing_work[image])
+        std::pmr::vector<vk::CommandBuffer> buffers{ engine->renderer.frame_allocator->getResource() };
+        buffers.reserve(processing_work[frame].size());
+        for (const auto& task : processing_work[frame])
         {
             if (task->compute.primary)
                 buffers.push_back(task->compute.primary);
@@ -115,10 +121,10 @@ namespace lotus
         return buffers;
     }
 
-    void WorkerPool::clearProcessed(int image)
+    void WorkerPool::clearProcessed(int frame)
     {
         //a mutex is not needed here because the fence already assures us that we have nothing being posted to this queue yet
-        std::swap(processing_work[image], finished_work);
+        std::swap(processing_work[frame], finished_work);
     }
 
     void WorkerPool::deleteFinished()
@@ -126,10 +132,10 @@ namespace lotus
         finished_work.clear();
     }
 
-    void WorkerPool::startProcessing(int image)
+    void WorkerPool::startProcessing(int frame)
     {
-        std::swap(pending_work, processing_work[image]);
-        std::sort(processing_work[image].rbegin(), processing_work[image].rend(), WorkCompare());
+        std::swap(pending_work, processing_work[frame]);
+        std::sort(processing_work[frame].rbegin(), processing_work[frame].rend(), WorkCompare());
     }
 
     void WorkerPool::waitIdle()
@@ -3,6 +3,10 @@
 #include "worker_thread.h"
 #include "work_item.h"
 #include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <thread>
 #include <queue>
 #include <mutex>
@@ -73,18 +77,64 @@ namespace lotus
             }
             work_cv.notify_one();
         }
+        //runs func(begin, end) over [0, count) in chunks of chunk_size, spread over the workers and the calling thread, returning once every chunk has run
+        //chunks run on no particular thread and in no particular order, so func must only touch what its range owns
+        //the calling thread takes chunks too, so this never waits behind long running work (like loads) queued before it
+        template<typename F>
+        void parallelFor(size_t count, size_t chunk_size, F func)
+        {
+            struct Batch
+            {
+                std::atomic<size_t> next{ 0 };
+                std::atomic<size_t> remaining{ 0 };
+                std::mutex mutex;
+                std::condition_variable done;
+            };
+            size_t chunks = (count + chunk_size - 1) / chunk_size;
+            if (chunks == 0)
+                return;
+            auto batch = std::make_shared<Batch>();
+            batch->remaining = chunks;
+            //workers that only get to this after every chunk is claimed find nothing left, and never touch func
+            auto run = [batch, chunks, chunk_size, count, &func]()
+            {
+                for (size_t chunk = batch->next++; chunk < chunks; chunk = batch->next++)
+                {
+                    func(chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size));
+                    if (--batch->remaining == 0)
+                    {
+                        std::lock_guard lk{ batch->mutex };
+                        batch->done.notify_all();
+                    }
+                }
+            };
+            std::vector<std::unique_ptr<WorkItem>> items;
+            for (size_t i = 0; i < std::min(chunks - 1, threads.size()); ++i)
+            {
+                auto item = std::make_unique<LambdaWorkItem>([run](WorkerThread*) { run(); });
+                //ahead of anything else queued, since the caller is waiting on it
+                item->priority = -1;
+                items.push_back(std::move(item));
+            }
+            if (!items.empty())
+                addWork(items);
+            run();
+            std::unique_lock lk{ batch->mutex };
+            batch->done.wait(lk, [&batch] { return batch->remaining == 0; });
+        }
+
         void waitForWork(std::unique_ptr<WorkItem>*);
         void workFinished(std::unique_ptr<WorkItem>*);
-        std::vector<vk::CommandBuffer> getPrimaryGraphicsBuffers(int image);
-        std::vector<vk::CommandBuffer> getSecondaryGraphicsBuffers(int image);
-        std::vector<vk::CommandBuffer> getShadowmapGraphicsBuffers(int image);
-        std::vector<vk::CommandBuffer> getParticleGraphicsBuffers(int image);
+        std::pmr::vector<vk::CommandBuffer> getPrimaryGraphicsBuffers(int frame);
+        std::pmr::vector<vk::CommandBuffer> getSecondaryGraphicsBuffers(int frame);
+        std::pmr::vector<vk::CommandBuffer> getShadowmapGraphicsBuffers(int frame, uint32_t cascade);
+        std::pmr::vector<vk::CommandBuffer> getParticleGraphicsBuffers(int frame);
 
-        std::vector<vk::CommandBuffer> getPrimaryComputeBuffers(int image);
+        std::pmr::vector<vk::CommandBuffer> getPrimaryComputeBuffers(int frame);
 
-        void clearProcessed(int image);
+        void clearProcessed(int frame);
         void deleteFinished();
-        void startProcessing(int image);
+        void startProcessing(int frame);
         void waitIdle();
 
     private:
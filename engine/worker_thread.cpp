@@ -4,7 +4,7 @@
 
 lotus::WorkerThread::WorkerThread(Engine* _engine, WorkerPool* _pool) : pool(_pool), engine(_engine)
 {
-    auto [graphics_queue, present_queue, compute_queue] = engine->renderer.getQueueFamilies(engine->renderer.physical_device);
+    auto [graphics_queue, present_queue, compute_queue, transfer_queue] = engine->renderer.getQueueFamilies(engine->renderer.physical_device);
 
     vk::CommandPoolCreateInfo pool_info = {};
     pool_info.queueFamilyIndex = graphics_queue.value();
@@ -15,14 +15,14 @@ lotus::WorkerThread::WorkerThread(Engine* _engine, WorkerPool* _pool) : pool(_po
 
     std::array<vk::DescriptorPoolSize, 2> poolSizes = {};
     poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(engine->renderer.getImageCount());
+    poolSizes[0].descriptorCount = static_cast<uint32_t>(engine->renderer.getFrameCount());
     poolSizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(engine->renderer.getImageCount());
+    poolSizes[1].descriptorCount = static_cast<uint32_t>(engine->renderer.getFrameCount());
 
     vk::DescriptorPoolCreateInfo poolInfo = {};
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(engine->renderer.getImageCount());
+    poolInfo.maxSets = static_cast<uint32_t>(engine->renderer.getFrameCount());
     poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
 
     desc_pool = engine->renderer.device->createDescriptorPoolUnique(poolInfo);
@@ -9,6 +9,8 @@ public:
     struct FFXIInfo
     {
         std::string ffxi_install_path;
+        //directory built navigation graphs are saved to and loaded back from (empty to always build them)
+        std::string navigation_cache_path{ "navigation" };
     } ffxi {};
 
     FFXIConfig();
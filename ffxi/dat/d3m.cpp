@@ -95,14 +95,17 @@ namespace FFXI
                 max_dist = len;
         }
 
+        model->bounds = { glm::vec3{ -max_dist }, glm::vec3{ max_dist } };
+        model->bounding_sphere = { glm::vec3{ 0.f }, max_dist };
+
         auto mesh = std::make_unique<lotus::Mesh>(); 
         mesh->has_transparency = true;
 
         mesh->texture = lotus::Texture::getTexture(d3m->texture_name);
 
-        mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertices.size(), vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(d3m->num_triangles * 3 * sizeof(uint16_t), index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        mesh->aabbs_buffer = engine->renderer.memory_manager->GetBuffer(sizeof(vk::AabbPositionsKHR), aabbs_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertices.size(), vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::Other);
+        mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(d3m->num_triangles * 3 * sizeof(uint16_t), index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::Other);
+        mesh->aabbs_buffer = engine->renderer.memory_manager->GetBuffer(sizeof(vk::AabbPositionsKHR), aabbs_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::Other);
         mesh->setIndexCount(d3m->num_triangles * 3);
         mesh->setVertexCount(d3m->num_triangles * 3);
         mesh->setVertexInputAttributeDescription(D3M::Vertex::getAttributeDescriptions());
@@ -110,6 +113,6 @@ namespace FFXI
 
         model->meshes.push_back(std::move(mesh));
 
-        engine->worker_pool.addWork(std::make_unique<lotus::ParticleModelInitTask>(engine->renderer.getCurrentImage(), model, std::move(vertices), sizeof(D3M::Vertex), max_dist));
+        engine->worker_pool.addWork(std::make_unique<lotus::ParticleModelInitTask>(engine->renderer.getCurrentFrame(), model, std::move(vertices), sizeof(D3M::Vertex), max_dist));
     }
 }
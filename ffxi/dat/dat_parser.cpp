@@ -321,7 +321,9 @@ namespace FFXI
             case 0x20:
                 current_chunk->d3s++;
                 {
-                    std::unique_ptr<DatChunk> new_chunk = std::make_unique<DXT3>(dathead->id, &buffer[offset + sizeof(DATHEAD)], len - sizeof(DATHEAD));
+                    auto new_chunk = std::make_unique<DXT3>(dathead->id, &buffer[offset + sizeof(DATHEAD)], len - sizeof(DATHEAD));
+                    new_chunk->source_path = filepath;
+                    new_chunk->source_offset = offset + sizeof(DATHEAD);
                     new_chunk->parent = current_chunk;
                     current_chunk->children.push_back(std::move(new_chunk));
                 }
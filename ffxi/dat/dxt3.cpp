@@ -1,6 +1,17 @@
 #include "dxt3.h"
+#include <array>
+#include <fstream>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 #include "engine/core.h"
+#include "engine/hash.h"
 #include "engine/task/texture_init.h"
+#include "engine/renderer/mipmap.h"
+#include "engine/renderer/texture_streamer.h"
 
 namespace FFXI
 {
@@ -31,6 +42,82 @@ namespace FFXI
     } IMGINFOB1;
 #pragma pack(pop)
 
+    namespace
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        //the build doesn't enable AVX2 globally, so the gather path is compiled for it on its own and picked at runtime
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+        bool hasAVX2()
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_cpu_supports("avx2");
+#else
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            __cpuid(info, 1);
+            //the OS has to save the ymm registers too
+            if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return info[1] & (1 << 5);
+#endif
+        }
+
+        //returns how many pixels it expanded (a multiple of 8)
+        AVX2_TARGET uint32_t expandRowAVX2(const uint32_t* lut, const uint8_t* src, uint8_t* dst, uint32_t width)
+        {
+            uint32_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)));
+                __m256i color = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), index, 4);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), color);
+            }
+            return x;
+        }
+#undef AVX2_TARGET
+#endif
+
+        //the chunk's data, read from its DAT again (empty if it can't be)
+        std::vector<uint8_t> readChunk(const std::string& path, size_t offset, size_t len)
+        {
+            std::vector<uint8_t> buffer(len);
+            std::ifstream dat{ path, std::ios::binary };
+            dat.seekg(offset);
+            dat.read(reinterpret_cast<char*>(buffer.data()), len);
+            if (!dat)
+                return {};
+            return buffer;
+        }
+
+        //the dimensions and format the content hash covers, ahead of the pixels
+        std::array<uint32_t, 3> getContentHeader(const DXT3& dxt3)
+        {
+            return { dxt3.width, dxt3.height, static_cast<uint32_t>(dxt3.format) };
+        }
+
+        //full mip chain in the upload format, from the chunk's level 0
+        std::vector<uint8_t> buildChain(vk::Format source_format, vk::Format format, std::vector<uint8_t> pixels, uint32_t width, uint32_t height, uint32_t levels, lotus::BlockCompression::Quality quality)
+        {
+            if (source_format == vk::Format::eR8G8B8A8Unorm)
+            {
+                lotus::Mipmap::generateRGBA(pixels, width, height, levels);
+                if (format == source_format)
+                    return pixels;
+                return lotus::Mipmap::compressRGBA(pixels, format, width, height, levels, quality);
+            }
+            lotus::Mipmap::generateCompressed(pixels, format, width, height, levels, quality);
+            return pixels;
+        }
+    }
+
     DXT3::DXT3(char* _name, uint8_t* _buffer, size_t _len) : DatChunk(_name, _buffer, _len)
     {
         IMGINFOA1* infoa1 = reinterpret_cast<IMGINFOA1*>(buffer);
@@ -62,18 +149,8 @@ namespace FFXI
                 width = infob1->imgx;
                 height = infob1->imgy;
                 format = vk::Format::eR8G8B8A8Unorm;
-                uint32_t size = width * height;
-                pixels.resize(static_cast<uint64_t>(size) * 4);
-                uint8_t* buf_p = buffer + sizeof(IMGINFOB1);
-                for (int i = height-1; i>=0; --i)
-                {
-                    for (uint32_t j = 0; j < width; ++j)
-                    {
-                        memcpy(pixels.data() + ((i * static_cast<uint64_t>(width) + j) * 4), &infob1->palet[(size_t)(*buf_p)], 4);
-                        ++buf_p;
-                    }
-                }
-                    
+                pixels.resize(static_cast<uint64_t>(width) * height * 4);
+                expandPalette(buffer + offsetof(IMGINFOB1, palet), buffer + sizeof(IMGINFOB1), width, height, pixels.data());
                 break;
             }
             case 0x05:
@@ -85,13 +162,85 @@ namespace FFXI
         }
     }
 
-    void DXT3Loader::LoadTexture(std::shared_ptr<lotus::Texture>& texture) 
+    void DXT3::expandPalette(const uint8_t* palette, const uint8_t* indices, uint32_t width, uint32_t height, uint8_t* rgba, bool allow_avx2)
+    {
+        //the palette sits unaligned in the (packed) header, so take an aligned copy to look up from
+        alignas(32) std::array<uint32_t, 0x100> lut;
+        memcpy(lut.data(), palette, sizeof(uint32_t) * lut.size());
+#if defined(__x86_64__) || defined(_M_X64)
+        static const bool avx2 = hasAVX2();
+        bool use_avx2 = avx2 && allow_avx2;
+#endif
+
+        //rows are stored bottom-up
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint8_t* src = indices + static_cast<size_t>(y) * width;
+            uint8_t* dst = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+            uint32_t x = 0;
+#if defined(__x86_64__) || defined(_M_X64)
+            if (use_avx2)
+                x = expandRowAVX2(lut.data(), src, dst, width);
+#endif
+            for (; x + 4 <= width; x += 4)
+            {
+                uint32_t color[4] = { lut[src[x]], lut[src[x + 1]], lut[src[x + 2]], lut[src[x + 3]] };
+                memcpy(dst + x * 4, color, sizeof(color));
+            }
+            for (; x < width; ++x)
+            {
+                memcpy(dst + x * 4, &lut[src[x]], 4);
+            }
+        }
+    }
+
+    bool DXT3::isOpaque() const
     {
-        uint32_t stride = 4;
-        if (dxt3->format == vk::Format::eBc2UnormBlock)
-            stride = 1;
-        VkDeviceSize imageSize = static_cast<uint64_t>(dxt3->width) * static_cast<uint64_t>(dxt3->height) * stride;
+        for (size_t i = 3; i < pixels.size(); i += 4)
+        {
+            if (pixels[i] != 0xFF)
+                return false;
+        }
+        return true;
+    }
 
+    uint64_t DXT3Loader::getContentHash() const
+    {
+        if (dxt3->pixels.empty())
+            return 0;
+        //the name is deliberately left out: identical images are stored under many different names
+        auto header = getContentHeader(*dxt3);
+        return lotus::Hash::xxh64(dxt3->pixels.data(), dxt3->pixels.size(), lotus::Hash::xxh64(header.data(), sizeof(header)));
+    }
+
+    std::function<std::vector<uint8_t>()> DXT3Loader::getContentReader() const
+    {
+        if (dxt3->source_path.empty())
+            return {};
+        return [path = dxt3->source_path, offset = dxt3->source_offset, len = dxt3->len]()
+        {
+            auto buffer = readChunk(path, offset, len);
+            if (buffer.empty())
+                return std::vector<uint8_t>{};
+            DXT3 source{ nullptr, buffer.data(), buffer.size() };
+            auto header = getContentHeader(source);
+            std::vector<uint8_t> content(sizeof(header) + source.pixels.size());
+            memcpy(content.data(), header.data(), sizeof(header));
+            memcpy(content.data() + sizeof(header), source.pixels.data(), source.pixels.size());
+            return content;
+        };
+    }
+
+    bool DXT3Loader::matchesContent(const std::vector<uint8_t>& content) const
+    {
+        auto header = getContentHeader(*dxt3);
+        return content.size() == sizeof(header) + dxt3->pixels.size() &&
+            memcmp(content.data(), header.data(), sizeof(header)) == 0 &&
+            memcmp(content.data() + sizeof(header), dxt3->pixels.data(), dxt3->pixels.size()) == 0;
+    }
+
+    void DXT3Loader::LoadTexture(std::shared_ptr<lotus::Texture>& texture) 
+    {
         texture->setWidth(dxt3->width);
         texture->setHeight(dxt3->height);
 
@@ -99,23 +248,21 @@ namespace FFXI
             throw std::runtime_error("failed to load texture image!");
         }
 
-        std::vector<uint8_t> texture_data;
-        texture_data.resize(imageSize);
-        memcpy(texture_data.data(), dxt3->pixels.data(), imageSize);
-
-        texture->image = engine->renderer.memory_manager->GetImage(texture->getWidth(), texture->getHeight(), dxt3->format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        vk::Format format = dxt3->format;
+        auto compression = engine->config->renderer.texture_compression;
+        auto quality = compression == lotus::Config::Renderer::TextureCompression::Fast ? lotus::BlockCompression::Quality::Fast : lotus::BlockCompression::Quality::High;
+        if (format == vk::Format::eR8G8B8A8Unorm && compression != lotus::Config::Renderer::TextureCompression::None)
+        {
+            format = dxt3->isOpaque() ? vk::Format::eBc1RgbUnormBlock : vk::Format::eBc3UnormBlock;
+        }
 
-        vk::ImageViewCreateInfo image_view_info;
-        image_view_info.image = texture->image->image;
-        image_view_info.viewType = vk::ImageViewType::e2D;
-        image_view_info.format = dxt3->format;
-        image_view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-        image_view_info.subresourceRange.baseMipLevel = 0;
-        image_view_info.subresourceRange.levelCount = 1;
-        image_view_info.subresourceRange.baseArrayLayer = 0;
-        image_view_info.subresourceRange.layerCount = 1;
+        texture->setMipLevels(lotus::Mipmap::getLevelCount(dxt3->width, dxt3->height));
 
-        texture->image_view = engine->renderer.device->createImageViewUnique(image_view_info, nullptr);
+        //only the low mips are uploaded up front; the streamer brings in the rest once something visible uses the texture
+        texture->setBaseLevel(engine->renderer.texture_streamer->getInitialLevel(dxt3->width, dxt3->height, texture->getMipLevels()));
+        auto [image, image_view] = engine->renderer.texture_streamer->createImage(*texture, format, texture->getBaseLevel());
+        texture->image = std::move(image);
+        texture->image_view = std::move(image_view);
 
         vk::SamplerCreateInfo sampler_info = {};
         sampler_info.magFilter = vk::Filter::eLinear;
@@ -130,10 +277,38 @@ namespace FFXI
         sampler_info.compareEnable = false;
         sampler_info.compareOp = vk::CompareOp::eAlways;
         sampler_info.mipmapMode = vk::SamplerMipmapMode::eLinear;
+        sampler_info.minLod = 0.f;
+        sampler_info.maxLod = static_cast<float>(texture->getMipLevels());
 
         texture->sampler = engine->renderer.device->createSamplerUnique(sampler_info, nullptr);
 
-        engine->worker_pool.addWork(std::make_unique<lotus::TextureInitTask>(engine->renderer.getCurrentImage(), texture, dxt3->format, vk::ImageTiling::eOptimal, std::move(texture_data)));
+        //only the low mips are kept once the full chain is resident, so the rest is read from the DAT again if the texture streams back in
+        lotus::TextureStreamer::Reload reload;
+        if (!dxt3->source_path.empty())
+        {
+            reload = [path = dxt3->source_path, offset = dxt3->source_offset, len = dxt3->len, format, levels = texture->getMipLevels(), quality]()
+            {
+                auto buffer = readChunk(path, offset, len);
+                if (buffer.empty())
+                    return std::vector<uint8_t>{};
+                DXT3 source{ nullptr, buffer.data(), buffer.size() };
+                return buildChain(source.format, format, std::move(source.pixels), source.width, source.height, levels, quality);
+            };
+        }
+
+        //mip generation and transcoding run on a worker, so a batch of textures is encoded in parallel
+        engine->worker_pool.addWork(std::make_unique<lotus::LambdaWorkItem>([texture, format, source_format = dxt3->format, pixels = dxt3->pixels, width = dxt3->width, height = dxt3->height, quality, reload = std::move(reload)](lotus::WorkerThread* thread) mutable
+        {
+            auto texture_data = buildChain(source_format, format, std::move(pixels), width, height, texture->getMipLevels(), quality);
+            if (texture->getBaseLevel() > 0)
+            {
+                auto resident_offset = lotus::Mipmap::getLevelOffset(format, width, height, texture->getBaseLevel());
+                std::vector<uint8_t> resident_data(texture_data.begin() + resident_offset, texture_data.end());
+                thread->engine->renderer.texture_streamer->registerTexture(texture, format, std::move(texture_data), std::move(reload));
+                texture_data = std::move(resident_data);
+            }
+            thread->engine->worker_pool.addWork(std::make_unique<lotus::TextureInitTask>(texture, format, vk::ImageTiling::eOptimal, std::move(texture_data)));
+        }));
     }
         
 }
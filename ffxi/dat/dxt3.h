@@ -15,6 +15,16 @@ namespace FFXI
         uint32_t height {0};
         std::vector<uint8_t> pixels;
         vk::Format format{};
+        //where the chunk's data starts in its DAT, for reading the texture again later (empty if it wasn't parsed from a file)
+        std::string source_path;
+        size_t source_offset{ 0 };
+
+        //every pixel's alpha is exactly 255; alpha scales specular and drives particle blending, so anything less has to keep it
+        bool isOpaque() const;
+
+        //0xB1: 8 bit indices into a 256 entry RGBA palette, with rows stored bottom-up
+        //gathers 8 pixels at a time when the CPU has AVX2 (and allow_avx2 is set), 4 at a time otherwise
+        static void expandPalette(const uint8_t* palette, const uint8_t* indices, uint32_t width, uint32_t height, uint8_t* rgba, bool allow_avx2 = true);
     };
 
     class DXT3Loader : public lotus::TextureLoader
@@ -22,6 +32,10 @@ namespace FFXI
     public:
         DXT3Loader(DXT3* _dxt3) : lotus::TextureLoader(), dxt3(_dxt3) {}
         virtual void LoadTexture(std::shared_ptr<lotus::Texture>& texture) override;
+        virtual uint64_t getContentHash() const override;
+        virtual size_t getContentSize() const override { return dxt3->pixels.size(); }
+        virtual std::function<std::vector<uint8_t>()> getContentReader() const override;
+        virtual bool matchesContent(const std::vector<uint8_t>& content) const override;
         
         DXT3* dxt3;
     };
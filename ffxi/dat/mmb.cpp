@@ -377,7 +377,7 @@ namespace FFXI
         return true;
     }
 
-    MMBLoader::MMBLoader(MMB* _mmb) : ModelLoader(), mmb(_mmb) {}
+    MMBLoader::MMBLoader(MMB* _mmb, const std::string& _dat) : ModelLoader(), mmb(_mmb), dat(_dat) {}
 
     void MMBLoader::LoadModel(std::shared_ptr<lotus::Model>& model)
     {
@@ -386,8 +386,12 @@ namespace FFXI
         std::vector<std::vector<uint8_t>> indices;
         for (const auto& mmb_mesh : mmb->meshes)
         {
+            for (const auto& vertex : mmb_mesh.vertices)
+            {
+                model->bounds.extend(vertex.pos);
+            }
             auto mesh = std::make_unique<lotus::Mesh>();
-            mesh->texture = lotus::Texture::getTexture(mmb_mesh.textureName);
+            mesh->texture = lotus::Texture::getTexture(dat + ":" + std::string(mmb_mesh.textureName, 16));
 
             mesh->setVertexInputAttributeDescription(FFXI::MMB::Vertex::getAttributeDescriptions());
             mesh->setVertexInputBindingDescription(FFXI::MMB::Vertex::getBindingDescriptions());
@@ -412,15 +416,29 @@ namespace FFXI
                 index_usage_flags |= vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
             }
 
-            mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertices_uint8.size(), vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-            mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(indices_uint8.size(), index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
+            //zones repeat a lot of geometry between their MMBs, so identical meshes share buffers
+            mesh->createBuffers(engine, vertices_uint8, indices_uint8, vertex_usage_flags, index_usage_flags, lotus::MemoryCategory::LandscapeMesh);
 
             vertices.push_back(std::move(vertices_uint8));
             indices.push_back(std::move(indices_uint8));
 
             model->meshes.push_back(std::move(mesh));
         }
+        model->bounding_sphere = lotus::BoundingSphere::fromAABB(model->bounds);
+        if (model->bounds.valid())
+        {
+            //tighten the radius around the box center
+            float max_dist = 0.f;
+            for (const auto& mmb_mesh : mmb->meshes)
+            {
+                for (const auto& vertex : mmb_mesh.vertices)
+                {
+                    max_dist = std::max(max_dist, glm::distance(vertex.pos, model->bounding_sphere.center));
+                }
+            }
+            model->bounding_sphere.radius = max_dist;
+        }
         model->lifetime = lotus::Lifetime::Long;
-        engine->worker_pool.addWork(std::make_unique<lotus::ModelInitTask>(engine->renderer.getCurrentImage(), model, std::move(vertices), std::move(indices), sizeof(MMB::Vertex)));
+        engine->worker_pool.addWork(std::make_unique<lotus::ModelInitTask>(engine->renderer.getCurrentFrame(), model, std::move(vertices), std::move(indices), sizeof(MMB::Vertex)));
     }
 }
@@ -44,9 +44,11 @@ namespace FFXI
     class MMBLoader : public lotus::ModelLoader
     {
     public:
-        explicit MMBLoader(MMB* mmb);
+        MMBLoader(MMB* mmb, const std::string& dat);
         virtual void LoadModel(std::shared_ptr<lotus::Model>&) override;
     private:
         MMB* mmb;
+        //textures are cached per dat, as names are reused between zones
+        std::string dat;
     };
 }
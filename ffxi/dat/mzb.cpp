@@ -88,7 +88,7 @@ namespace FFXI
         return result;
     }
 
-    void QuadTree::find_internal(lotus::Camera::Frustum& frustum, std::vector<uint32_t>& results) const
+    void QuadTree::find_internal(lotus::Camera::Frustum& frustum, std::pmr::vector<uint32_t>& results) const
     {
         auto result = isInFrustum(frustum, pos1, pos2);
         if (result == FrustumResult::Outside)
@@ -107,14 +107,14 @@ namespace FFXI
         }
     }
 
-    std::vector<uint32_t> QuadTree::find(lotus::Camera::Frustum& frustum) const
+    std::pmr::vector<uint32_t> QuadTree::find(lotus::Camera::Frustum& frustum, std::pmr::memory_resource* resource) const
     {
-        std::vector<uint32_t> ret;
+        std::pmr::vector<uint32_t> ret{ resource };
         find_internal(frustum, ret);
         return ret;
     }
 
-    void QuadTree::get_nodes(std::vector<uint32_t>& results) const
+    void QuadTree::get_nodes(std::pmr::vector<uint32_t>& results) const
     {
         results.insert(results.end(), nodes.begin(), nodes.end());
         for (const auto& child : children)
@@ -345,9 +345,9 @@ namespace FFXI
             index_buffer_size += mesh.indices.size() * 2;
         }
 
-        mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertex_buffer_size, vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(index_buffer_size, index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        mesh->transform_buffer = engine->renderer.memory_manager->GetBuffer(transformation_buffer_size, transform_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertex_buffer_size, vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::LandscapeMesh);
+        mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(index_buffer_size, index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::LandscapeMesh);
+        mesh->transform_buffer = engine->renderer.memory_manager->GetBuffer(transformation_buffer_size, transform_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal, lotus::MemoryCategory::LandscapeMesh);
 
         model->meshes.push_back(std::move(mesh));
         model->lifetime = lotus::Lifetime::Long;
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <memory_resource>
 #include <glm/glm.hpp>
 #include <optional>
 #include "dat_chunk.h"
@@ -38,15 +39,16 @@ namespace FFXI
     public:
         QuadTree(glm::vec3 pos1, glm::vec3 pos2) : pos1(pos1), pos2(pos2) {}
 
-        std::vector<uint32_t> find(lotus::Camera::Frustum&) const;
+        //called a few times per frame, so the results can go in the frame allocator
+        std::pmr::vector<uint32_t> find(lotus::Camera::Frustum&, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
 
         glm::vec3 pos1;
         glm::vec3 pos2;
         std::vector<uint32_t> nodes;
         std::vector<QuadTree> children;
     private:
-        void find_internal(lotus::Camera::Frustum&, std::vector<uint32_t>&) const;
-        void get_nodes(std::vector<uint32_t>&) const;
+        void find_internal(lotus::Camera::Frustum&, std::pmr::vector<uint32_t>&) const;
+        void get_nodes(std::pmr::vector<uint32_t>&) const;
 
     };
 
@@ -15,7 +15,7 @@ void Actor::Init(const std::shared_ptr<Actor>& sp, const std::string& dat)
     engine->worker_pool.addWork(std::make_unique<ActorDatLoad>(sp, dat));
 }
 
-FFXIActorLoader::FFXIActorLoader(const std::vector<FFXI::OS2*>& _os2s, FFXI::SK2* _sk2) : ModelLoader(), os2s(_os2s), sk2(_sk2)
+FFXIActorLoader::FFXIActorLoader(const std::vector<FFXI::OS2*>& _os2s, FFXI::SK2* _sk2, const std::string& _dat) : ModelLoader(), os2s(_os2s), sk2(_sk2), dat(_dat)
 {
 }
 
@@ -38,7 +38,7 @@ void FFXIActorLoader::LoadModel(std::shared_ptr<lotus::Model>& model)
             std::vector<uint8_t> vertices_uint8;
             std::vector<uint16_t> mesh_indices;
             std::vector<uint8_t> indices_uint8;
-            mesh->texture = lotus::Texture::getTexture(os2_mesh.tex_name);
+            mesh->texture = lotus::Texture::getTexture(dat + ":" + os2_mesh.tex_name);
             int passes = os2->mirror ? 2 : 1;
             for (int i = 0; i < passes; ++i)
             {
@@ -94,8 +94,7 @@ void FFXIActorLoader::LoadModel(std::shared_ptr<lotus::Model>& model)
             index_usage_flags |= vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
         }
 
-        mesh->vertex_buffer = engine->renderer.memory_manager->GetBuffer(vertices_uint8.size(), vertex_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
-        mesh->index_buffer = engine->renderer.memory_manager->GetBuffer(indices_uint8.size(), index_usage_flags, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        mesh->createBuffers(engine, vertices_uint8, indices_uint8, vertex_usage_flags, index_usage_flags, lotus::MemoryCategory::ActorMesh);
         mesh->setIndexCount(mesh_indices.size());
         mesh->setVertexCount(os2_vertices.size());
         mesh->setVertexInputAttributeDescription(FFXI::OS2::Vertex::getAttributeDescriptions());
@@ -106,7 +105,18 @@ void FFXIActorLoader::LoadModel(std::shared_ptr<lotus::Model>& model)
         model->meshes.push_back(std::move(mesh));
         }
     }
+    //vertices are bone-relative (and may be mirrored), so only the furthest distance from a bone is useful
+    float max_dist = 0.f;
+    for (const auto& os2 : os2s)
+    {
+        for (const auto& [first, second] : os2->vertices)
+        {
+            max_dist = std::max({ max_dist, glm::length(first.pos), glm::length(second.pos) });
+        }
+    }
+    model->bounds = { glm::vec3{ -max_dist }, glm::vec3{ max_dist } };
+    model->bounding_sphere = { glm::vec3{ 0.f }, max_dist };
     model->lifetime = lotus::Lifetime::Short;
     model->weighted = true;
-    engine->worker_pool.addWork(std::make_unique<lotus::ModelInitTask>(engine->renderer.getCurrentImage(), model, std::move(vertices), std::move(indices), sizeof(FFXI::OS2::WeightingVertex)));
+    engine->worker_pool.addWork(std::make_unique<lotus::ModelInitTask>(engine->renderer.getCurrentFrame(), model, std::move(vertices), std::move(indices), sizeof(FFXI::OS2::WeightingVertex)));
 }
@@ -19,9 +19,11 @@ public:
 class FFXIActorLoader : public lotus::ModelLoader
 {
 public:
-    FFXIActorLoader(const std::vector<FFXI::OS2*>& os2s, FFXI::SK2* sk2);
+    FFXIActorLoader(const std::vector<FFXI::OS2*>& os2s, FFXI::SK2* sk2, const std::string& dat);
     virtual void LoadModel(std::shared_ptr<lotus::Model>&) override;
 private:
     const std::vector<FFXI::OS2*>& os2s;
     FFXI::SK2* sk2;
+    //textures are cached per dat, as names are reused between dats
+    std::string dat;
 };
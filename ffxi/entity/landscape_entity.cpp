@@ -2,19 +2,19 @@
 
 #include "task/landscape_dat_load.h"
 #include "engine/core.h"
+#include "engine/renderer/texture_streamer.h"
+#include "engine/renderer/frame_allocator.h"
 
 void FFXILandscapeEntity::Init(const std::shared_ptr<FFXILandscapeEntity>& sp, const std::string& dat)
 {
     engine->worker_pool.addWork(std::make_unique<LandscapeDatLoad>(sp, dat));
 }
 
-void FFXILandscapeEntity::populate_AS(lotus::TopLevelAccelerationStructure* as, uint32_t image_index)
+void FFXILandscapeEntity::populate_AS(lotus::TopLevelAccelerationStructure* as, uint32_t frame_index)
 {
-    auto nodes = quadtree.find(engine->camera->frustum);
-    for (const auto& node : nodes)
+    for (const auto& [node, instance_info] : visible_instances)
     {
-        auto& [model_offset, instance_info] = model_vec[node];
-        auto& model = models[model_offset];
+        auto& model = models[model_vec[node].first];
         if (!model->meshes.empty() && model->bottom_level_as)
         {
             vk::AccelerationStructureInstanceKHR instance{};
@@ -93,9 +93,85 @@ void FFXILandscapeEntity::render(lotus::Engine* engine, std::shared_ptr<Entity>&
         light.skybox_colors[i] = glm::mix(time1->second.skybox_colors[i], time2->second.skybox_colors[i], a);
     }
 
+    updateVisibleInstances();
+
     lotus::LandscapeEntity::render(engine, sp);
 }
 
+void FFXILandscapeEntity::updateVisibleInstances()
+{
+    auto camera = engine->camera;
+    auto frame = engine->renderer.getCurrentFrame();
+
+    visible_instances.clear();
+    visible_draw_instances.clear();
+    cullInstances(camera->frustum, &visible_instances, visible_draw_instances);
+
+    if (engine->renderer.RasterizationEnabled())
+    {
+        writeVisibleInstances(frame, gbuffer_view, visible_draw_instances);
+    }
+
+    if (engine->renderer.render_mode == lotus::RenderMode::Rasterization)
+    {
+        //distant cascades cover most of the zone, but the near ones only need what's around the camera
+        for (uint32_t i = 0; i < lotus::Renderer::shadowmap_cascades; ++i)
+        {
+            cascade_draw_instances.clear();
+            cullInstances(camera->cascade_frustums[i], nullptr, cascade_draw_instances);
+            writeVisibleInstances(frame, getCascadeView(i), cascade_draw_instances);
+        }
+    }
+}
+
+void FFXILandscapeEntity::cullInstances(lotus::Camera::Frustum frustum, std::vector<std::pair<uint32_t, InstanceInfo>>* instances, std::vector<std::pair<uint32_t, InstanceInfo>>& draw_instances)
+{
+    visible_seen.assign(model_vec.size(), false);
+
+    auto camera = engine->camera;
+    const auto& culling = engine->config->renderer.getDetailCulling();
+    float projection_scale = 1.f / glm::tan(camera->getFov() * 0.5f);
+    auto camera_pos = camera->getPos();
+
+    for (const auto& node : quadtree.find(frustum, engine->renderer.frame_allocator->getResource()))
+    {
+        //pieces can be listed in more than one quadtree node
+        if (visible_seen[node])
+            continue;
+        visible_seen[node] = true;
+
+        //detail culling is always relative to the camera, so pieces too small to draw don't cast shadows either
+        const auto& sphere = instance_spheres[node];
+        auto instance_info = model_vec[node].second;
+        float distance = std::max(glm::distance(camera_pos, sphere.center) - sphere.radius, camera->getNearClip());
+        float size = sphere.radius * projection_scale / distance;
+
+        if (size < culling.cull_size)
+            continue;
+
+        if (size < culling.fade_size)
+        {
+            //shrink the instance into its bounds center as it approaches the cull size
+            //never all the way to 0, which would leave the model matrix without an inverse for the normals
+            float fade = std::max((size - culling.cull_size) / (culling.fade_size - culling.cull_size), 0.01f);
+            auto fade_mat = glm::translate(glm::mat4{ 1.f }, sphere.center) * glm::scale(glm::mat4{ 1.f }, glm::vec3{ fade }) * glm::translate(glm::mat4{ 1.f }, -sphere.center);
+            instance_info.model = fade_mat * instance_info.model;
+            instance_info.model_t = glm::transpose(instance_info.model);
+            instance_info.model_it = glm::transpose(glm::inverse(glm::mat3(instance_info.model)));
+        }
+        if (instances)
+        {
+            instances->emplace_back(node, instance_info);
+            for (const auto& mesh : models[model_vec[node].first]->meshes)
+            {
+                if (mesh->texture)
+                    engine->renderer.texture_streamer->request(mesh->texture.get(), distance);
+            }
+        }
+        draw_instances.emplace_back(model_vec[node].first, instance_info);
+    }
+}
+
 void FFXILandscapeEntity::tick(lotus::time_point time, lotus::duration delta)
 {
 }
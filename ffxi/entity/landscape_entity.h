@@ -1,8 +1,14 @@
 #pragma once
+#include <atomic>
 #include "engine/entity/landscape_entity.h"
 #include "engine/renderer/mesh.h"
 #include "dat/mzb.h"
 
+namespace FFXI
+{
+    class Navigation;
+}
+
 class FFXILandscapeEntity : public lotus::LandscapeEntity
 {
 public:
@@ -27,15 +33,28 @@ public:
     };
     FFXILandscapeEntity(lotus::Engine* engine) : LandscapeEntity(engine) {}
     void Init(const std::shared_ptr<FFXILandscapeEntity>& sp, const std::string& dat);
-    virtual void populate_AS(lotus::TopLevelAccelerationStructure* as, uint32_t image_index) override;
+    virtual void populate_AS(lotus::TopLevelAccelerationStructure* as, uint32_t frame_index) override;
     FFXI::QuadTree quadtree{glm::vec3{}, glm::vec3{}};
     std::vector<std::pair<uint32_t, InstanceInfo>> model_vec;
+    //world space bounding sphere of each model_vec entry
+    std::vector<lotus::BoundingSphere> instance_spheres;
     std::map<std::string, std::map<uint32_t, LightTOD>> weather_light_map;
+    //built in the background after load, null until ready
+    std::shared_ptr<FFXI::Navigation> getNavigation() const { return navigation.load(); }
+    std::atomic<std::shared_ptr<FFXI::Navigation>> navigation;
 protected:
     virtual void render(lotus::Engine* engine, std::shared_ptr<Entity>& sp) override;
     virtual void tick(lotus::time_point time, lotus::duration delta) override;
+    void updateVisibleInstances();
+    //quadtree + detail culling against a frustum; instances gets model_vec indices, draw_instances gets model indices
+    void cullInstances(lotus::Camera::Frustum frustum, std::vector<std::pair<uint32_t, InstanceInfo>>* instances, std::vector<std::pair<uint32_t, InstanceInfo>>& draw_instances);
     uint32_t current_time{750};
     std::string current_weather = "suny";
+    //pair of model_vec index/instance, with the detail fade applied
+    std::vector<std::pair<uint32_t, InstanceInfo>> visible_instances;
+    std::vector<std::pair<uint32_t, InstanceInfo>> visible_draw_instances;
+    std::vector<std::pair<uint32_t, InstanceInfo>> cascade_draw_instances;
+    std::vector<bool> visible_seen;
 };
 
 class CollisionMesh : public lotus::Mesh
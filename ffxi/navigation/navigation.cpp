@@ -0,0 +1,578 @@
+#include "navigation.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include "engine/hash.h"
+
+namespace FFXI
+{
+    namespace
+    {
+        struct Span
+        {
+            uint32_t column;
+            float min;
+            float max;
+            bool walkable;
+        };
+
+        constexpr uint32_t file_magic = 0x3156414E; //"NAV1"
+        constexpr uint32_t file_version = 2;
+
+        //Sutherland-Hodgman against one axis-aligned plane in x or z
+        void clipPolygon(std::vector<glm::vec3>& polygon, std::vector<glm::vec3>& scratch, int axis, float value, bool keep_greater)
+        {
+            scratch.clear();
+            for (size_t i = 0; i < polygon.size(); ++i)
+            {
+                const auto& a = polygon[i];
+                const auto& b = polygon[(i + 1) % polygon.size()];
+                float da = keep_greater ? a[axis] - value : value - a[axis];
+                float db = keep_greater ? b[axis] - value : value - b[axis];
+                if (da >= 0)
+                    scratch.push_back(a);
+                if ((da >= 0) != (db >= 0))
+                    scratch.push_back(glm::mix(a, b, da / (da - db)));
+            }
+            polygon.swap(scratch);
+        }
+
+        void forEach(const Navigation::ParallelFor& parallel_for, size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& func)
+        {
+            if (parallel_for)
+                parallel_for(count, chunk_size, func);
+            else if (count > 0)
+                func(0, count);
+        }
+
+        template<typename T>
+        void writeVector(std::ofstream& file, const std::vector<T>& vec)
+        {
+            uint64_t size = vec.size();
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(vec.data()), sizeof(T) * vec.size());
+        }
+
+        template<typename T>
+        bool readVector(std::ifstream& file, std::vector<T>& vec)
+        {
+            uint64_t size = 0;
+            file.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if (!file.good() || size > (1ull << 32))
+                return false;
+            vec.resize(size);
+            file.read(reinterpret_cast<char*>(vec.data()), sizeof(T) * size);
+            return file.good();
+        }
+    }
+
+    std::unique_ptr<Navigation> Navigation::build(const std::vector<CollisionMeshData>& meshes, const std::vector<CollisionEntry>& entries, const Parameters& params, const ParallelFor& parallel_for)
+    {
+        auto nav = std::unique_ptr<Navigation>(new Navigation());
+        nav->params = params;
+
+        std::vector<std::array<glm::vec3, 3>> triangles;
+        glm::vec3 bounds_min{ std::numeric_limits<float>::max() };
+        glm::vec3 bounds_max{ std::numeric_limits<float>::lowest() };
+
+        for (const auto& entry : entries)
+        {
+            if (entry.mesh_entry >= meshes.size())
+                continue;
+            const auto& mesh = meshes[entry.mesh_entry];
+            //entries are stored transposed (see CollisionModelInitTask)
+            glm::mat4 to_world = glm::transpose(entry.transform);
+            const auto* vertices = reinterpret_cast<const glm::vec3*>(mesh.vertices.data());
+            size_t vertex_count = mesh.vertices.size() / sizeof(glm::vec3);
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+            {
+                if (mesh.indices[i] >= vertex_count || mesh.indices[i + 1] >= vertex_count || mesh.indices[i + 2] >= vertex_count)
+                    continue;
+                std::array<glm::vec3, 3> triangle;
+                for (int j = 0; j < 3; ++j)
+                {
+                    triangle[j] = glm::vec3(to_world * glm::vec4(vertices[mesh.indices[i + j]], 1.f));
+                    bounds_min = glm::min(bounds_min, triangle[j]);
+                    bounds_max = glm::max(bounds_max, triangle[j]);
+                }
+                triangles.push_back(triangle);
+            }
+        }
+
+        if (triangles.empty())
+            return nav;
+
+        const float cell_size = params.cell_size;
+        const uint32_t cluster_size = params.cluster_size;
+        nav->origin = glm::vec2{ bounds_min.x, bounds_min.z };
+        nav->clusters_x = static_cast<uint32_t>((bounds_max.x - bounds_min.x) / cell_size) / cluster_size + 1;
+        nav->clusters_z = static_cast<uint32_t>((bounds_max.z - bounds_min.z) / cell_size) / cluster_size + 1;
+        nav->width = nav->clusters_x * cluster_size;
+        nav->depth = nav->clusters_z * cluster_size;
+
+        //voxelize every triangle into height spans per column, a chunk of triangles at a time
+        constexpr size_t triangle_chunk_size = 1024;
+        std::vector<std::vector<Span>> chunk_spans((triangles.size() + triangle_chunk_size - 1) / triangle_chunk_size);
+        const float walkable_normal = glm::cos(params.max_slope);
+        forEach(parallel_for, triangles.size(), triangle_chunk_size, [&](size_t begin, size_t end)
+        {
+            auto& spans = chunk_spans[begin / triangle_chunk_size];
+            std::vector<glm::vec3> polygon;
+            std::vector<glm::vec3> scratch;
+            for (size_t i = begin; i < end; ++i)
+            {
+                const auto& triangle = triangles[i];
+                glm::vec3 normal = glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]);
+                float length = glm::length(normal);
+                if (length < 1e-6f)
+                    continue;
+                bool walkable = glm::abs(normal.y / length) >= walkable_normal;
+
+                glm::vec3 tri_min = glm::min(triangle[0], glm::min(triangle[1], triangle[2]));
+                glm::vec3 tri_max = glm::max(triangle[0], glm::max(triangle[1], triangle[2]));
+                uint32_t x0 = static_cast<uint32_t>((tri_min.x - nav->origin.x) / cell_size);
+                uint32_t x1 = std::min(static_cast<uint32_t>((tri_max.x - nav->origin.x) / cell_size), nav->width - 1);
+                uint32_t z0 = static_cast<uint32_t>((tri_min.z - nav->origin.y) / cell_size);
+                uint32_t z1 = std::min(static_cast<uint32_t>((tri_max.z - nav->origin.y) / cell_size), nav->depth - 1);
+
+                for (uint32_t z = z0; z <= z1; ++z)
+                {
+                    for (uint32_t x = x0; x <= x1; ++x)
+                    {
+                        float cell_x = nav->origin.x + x * cell_size;
+                        float cell_z = nav->origin.y + z * cell_size;
+                        polygon.assign(triangle.begin(), triangle.end());
+                        clipPolygon(polygon, scratch, 0, cell_x, true);
+                        clipPolygon(polygon, scratch, 0, cell_x + cell_size, false);
+                        clipPolygon(polygon, scratch, 2, cell_z, true);
+                        clipPolygon(polygon, scratch, 2, cell_z + cell_size, false);
+                        if (polygon.empty())
+                            continue;
+
+                        Span span{ nav->getColumn(x, z), std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), walkable };
+                        for (const auto& vertex : polygon)
+                        {
+                            span.min = std::min(span.min, -vertex.y);
+                            span.max = std::max(span.max, -vertex.y);
+                        }
+                        spans.push_back(span);
+                    }
+                }
+            }
+        });
+        triangles.clear();
+        triangles.shrink_to_fit();
+
+        //bucket the spans by cluster (keeping the chunks' order, so the graph doesn't depend on how they were split up)
+        const uint32_t cluster_columns = cluster_size * cluster_size;
+        const uint32_t cluster_count = nav->clusters_x * nav->clusters_z;
+        std::vector<size_t> cluster_span_first(cluster_count + 1, 0);
+        for (const auto& spans : chunk_spans)
+        {
+            for (const auto& span : spans)
+            {
+                cluster_span_first[span.column / cluster_columns + 1]++;
+            }
+        }
+        for (uint32_t cluster = 0; cluster < cluster_count; ++cluster)
+        {
+            cluster_span_first[cluster + 1] += cluster_span_first[cluster];
+        }
+        std::vector<Span> spans(cluster_span_first.back());
+        {
+            std::vector<size_t> next(cluster_span_first.begin(), cluster_span_first.end() - 1);
+            for (auto& chunk : chunk_spans)
+            {
+                for (const auto& span : chunk)
+                {
+                    spans[next[span.column / cluster_columns]++] = span;
+                }
+                chunk = {};
+            }
+        }
+
+        //per cluster: merge overlapping spans, and turn walkable surfaces with enough headroom into nodes
+        //column_first holds each column's node count until the clusters are joined up
+        const float merge_epsilon = 0.05f;
+        uint32_t column_count = nav->width * nav->depth;
+        nav->column_first.assign(column_count + 1, 0);
+        std::vector<std::vector<Node>> cluster_nodes(cluster_count);
+        forEach(parallel_for, cluster_count, 1, [&](size_t begin, size_t end)
+        {
+            std::vector<Span> merged;
+            for (size_t cluster = begin; cluster < end; ++cluster)
+            {
+                auto first = spans.begin() + cluster_span_first[cluster];
+                auto last = spans.begin() + cluster_span_first[cluster + 1];
+                std::sort(first, last, [](const Span& a, const Span& b)
+                {
+                    return a.column < b.column || (a.column == b.column && a.min < b.min);
+                });
+
+                auto& nodes = cluster_nodes[cluster];
+                uint32_t column_begin = static_cast<uint32_t>(cluster) * cluster_columns;
+                for (uint32_t column = column_begin; column < column_begin + cluster_columns; ++column)
+                {
+                    merged.clear();
+                    for (; first != last && first->column == column; ++first)
+                    {
+                        const auto& span = *first;
+                        if (!merged.empty() && span.min <= merged.back().max + merge_epsilon)
+                        {
+                            auto& top = merged.back();
+                            if (span.max > top.max + merge_epsilon)
+                                top.walkable = span.walkable;
+                            else if (span.max >= top.max - merge_epsilon)
+                                top.walkable = top.walkable || span.walkable;
+                            top.max = std::max(top.max, span.max);
+                        }
+                        else
+                        {
+                            merged.push_back(span);
+                        }
+                    }
+                    uint32_t layers = 0;
+                    for (size_t i = 0; i < merged.size() && layers < no_link; ++i)
+                    {
+                        if (!merged[i].walkable)
+                            continue;
+                        float ceiling = i + 1 < merged.size() ? merged[i + 1].min : std::numeric_limits<float>::max();
+                        if (ceiling - merged[i].max < params.agent_height)
+                            continue;
+                        Node node{ column, merged[i].max };
+                        std::fill(std::begin(node.links), std::end(node.links), no_link);
+                        nodes.push_back(node);
+                        ++layers;
+                    }
+                    nav->column_first[column] = layers;
+                }
+            }
+        });
+        spans.clear();
+        spans.shrink_to_fit();
+
+        //columns are numbered cluster by cluster, so joining the clusters in order keeps every column's nodes together
+        uint32_t node_count = 0;
+        for (uint32_t column = 0; column < column_count; ++column)
+        {
+            uint32_t layers = nav->column_first[column];
+            nav->column_first[column] = node_count;
+            node_count += layers;
+        }
+        nav->column_first[column_count] = node_count;
+        nav->nodes.reserve(node_count);
+        for (auto& nodes : cluster_nodes)
+        {
+            nav->nodes.insert(nav->nodes.end(), nodes.begin(), nodes.end());
+            nodes = {};
+        }
+
+        nav->buildLinks(parallel_for);
+        nav->buildAbstractGraph(parallel_for);
+        return nav;
+    }
+
+    void Navigation::buildLinks(const ParallelFor& parallel_for)
+    {
+        //nodes only write their own links, so any split of them works
+        constexpr size_t node_chunk_size = 4096;
+        auto findLayer = [this](uint32_t column, float height) -> uint8_t
+        {
+            uint8_t best = no_link;
+            float best_diff = params.step_height;
+            for (uint32_t i = column_first[column]; i < column_first[column + 1]; ++i)
+            {
+                float diff = glm::abs(nodes[i].height - height);
+                if (diff <= best_diff)
+                {
+                    best = static_cast<uint8_t>(i - column_first[column]);
+                    best_diff = diff;
+                }
+            }
+            return best;
+        };
+
+        forEach(parallel_for, nodes.size(), node_chunk_size, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto& node = nodes[i];
+                auto coord = getColumnCoord(node.column);
+                for (int direction = 0; direction < 4; ++direction)
+                {
+                    glm::ivec2 neighbour = glm::ivec2(coord) + glm::ivec2{ direction_x[direction], direction_z[direction] };
+                    if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= static_cast<int>(width) || neighbour.y >= static_cast<int>(depth))
+                        continue;
+                    node.links[direction] = findLayer(getColumn(neighbour.x, neighbour.y), node.height);
+                }
+            }
+        });
+
+        //diagonals only where both orthogonal steps lead to the same diagonal node, so paths can't cut corners
+        //(these only read the orthogonal links, which are all in by now)
+        forEach(parallel_for, nodes.size(), node_chunk_size, [&](size_t begin, size_t end)
+        {
+            for (uint32_t i = static_cast<uint32_t>(begin); i < end; ++i)
+            {
+                for (int direction = 4; direction < 8; ++direction)
+                {
+                    int dir_x = direction_x[direction] > 0 ? 0 : 1;
+                    int dir_z = direction_z[direction] > 0 ? 2 : 3;
+                    uint32_t via_x = getNeighbour(i, dir_x);
+                    uint32_t via_z = getNeighbour(i, dir_z);
+                    if (via_x == invalid_node || via_z == invalid_node)
+                        continue;
+                    uint32_t target_x = getNeighbour(via_x, dir_z);
+                    uint32_t target_z = getNeighbour(via_z, dir_x);
+                    if (target_x != invalid_node && target_x == target_z)
+                        nodes[i].links[direction] = static_cast<uint8_t>(target_x - column_first[nodes[target_x].column]);
+                }
+            }
+        });
+    }
+
+    void Navigation::buildAbstractGraph(const ParallelFor& parallel_for)
+    {
+        const uint32_t cluster_size = params.cluster_size;
+        const uint32_t cluster_count = clusters_x * clusters_z;
+
+        //entrances: maximal runs of connected nodes across each cluster border, represented by their middle transition
+        //each cluster finds the ones on its +x and +z borders
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> cluster_transitions(cluster_count);
+        forEach(parallel_for, cluster_count, 16, [&](size_t begin, size_t end)
+        {
+            for (size_t cluster = begin; cluster < end; ++cluster)
+            {
+                uint32_t cx = static_cast<uint32_t>(cluster) % clusters_x;
+                uint32_t cz = static_cast<uint32_t>(cluster) / clusters_x;
+                for (int direction : { 0, 2 })
+                {
+                    if ((direction == 0 && cx + 1 >= clusters_x) || (direction == 2 && cz + 1 >= clusters_z))
+                        continue;
+                    int along = direction == 0 ? 2 : 0;
+
+                    struct Run { std::vector<std::pair<uint32_t, uint32_t>> pairs; };
+                    std::vector<Run> runs;
+                    std::vector<std::pair<std::pair<uint32_t, uint32_t>, size_t>> previous;
+                    std::vector<std::pair<std::pair<uint32_t, uint32_t>, size_t>> current;
+
+                    for (uint32_t i = 0; i < cluster_size; ++i)
+                    {
+                        uint32_t x = direction == 0 ? cx * cluster_size + cluster_size - 1 : cx * cluster_size + i;
+                        uint32_t z = direction == 0 ? cz * cluster_size + i : cz * cluster_size + cluster_size - 1;
+                        uint32_t column = getColumn(x, z);
+                        current.clear();
+                        for (uint32_t node = column_first[column]; node < column_first[column + 1]; ++node)
+                        {
+                            uint32_t other = getNeighbour(node, direction);
+                            if (other == invalid_node)
+                                continue;
+                            size_t run = runs.size();
+                            for (const auto& [pair, previous_run] : previous)
+                            {
+                                if (getNeighbour(pair.first, along) == node && getNeighbour(pair.second, along) == other)
+                                {
+                                    run = previous_run;
+                                    break;
+                                }
+                            }
+                            if (run == runs.size())
+                                runs.emplace_back();
+                            runs[run].pairs.emplace_back(node, other);
+                            current.push_back({ { node, other }, run });
+                        }
+                        previous.swap(current);
+                    }
+                    for (const auto& run : runs)
+                    {
+                        cluster_transitions[cluster].push_back(run.pairs[run.pairs.size() / 2]);
+                    }
+                }
+            }
+        });
+        std::vector<std::pair<uint32_t, uint32_t>> transitions;
+        for (const auto& cluster : cluster_transitions)
+        {
+            transitions.insert(transitions.end(), cluster.begin(), cluster.end());
+        }
+
+        std::vector<uint32_t> entrance_nodes;
+        for (const auto& [a, b] : transitions)
+        {
+            entrance_nodes.push_back(a);
+            entrance_nodes.push_back(b);
+        }
+        //node indices are already ordered by cluster
+        std::sort(entrance_nodes.begin(), entrance_nodes.end());
+        entrance_nodes.erase(std::unique(entrance_nodes.begin(), entrance_nodes.end()), entrance_nodes.end());
+
+        node_abstract.clear();
+        std::vector<std::vector<AbstractEdge>> edges(entrance_nodes.size());
+        cluster_abstract_first.assign(cluster_count + 1, 0);
+        for (uint32_t i = 0; i < entrance_nodes.size(); ++i)
+        {
+            node_abstract[entrance_nodes[i]] = i;
+            cluster_abstract_first[getCluster(entrance_nodes[i]) + 1]++;
+        }
+        for (size_t i = 1; i < cluster_abstract_first.size(); ++i)
+        {
+            cluster_abstract_first[i] += cluster_abstract_first[i - 1];
+        }
+
+        for (const auto& [a, b] : transitions)
+        {
+            uint32_t abstract_a = node_abstract[a];
+            uint32_t abstract_b = node_abstract[b];
+            float cost = getLinkCost(a, b);
+            edges[abstract_a].push_back({ abstract_b, cost });
+            edges[abstract_b].push_back({ abstract_a, cost });
+        }
+
+        abstract_nodes.resize(entrance_nodes.size());
+        for (uint32_t i = 0; i < entrance_nodes.size(); ++i)
+        {
+            abstract_nodes[i].node = entrance_nodes[i];
+        }
+
+        //intra-cluster edges from a Dijkstra fill out of each entrance, a cluster at a time (the search scratch is per thread)
+        forEach(parallel_for, cluster_count, 1, [&](size_t begin, size_t end)
+        {
+            for (uint32_t i = cluster_abstract_first[begin]; i < cluster_abstract_first[end]; ++i)
+            {
+                for (const auto& [other, cost] : connectToAbstract(entrance_nodes[i]))
+                {
+                    if (other != i)
+                        edges[i].push_back({ other, cost });
+                }
+            }
+        });
+
+        abstract_edges.clear();
+        for (uint32_t i = 0; i < abstract_nodes.size(); ++i)
+        {
+            abstract_nodes[i].first_edge = static_cast<uint32_t>(abstract_edges.size());
+            abstract_nodes[i].edge_count = static_cast<uint32_t>(edges[i].size());
+            abstract_edges.insert(abstract_edges.end(), edges[i].begin(), edges[i].end());
+        }
+    }
+
+    uint32_t Navigation::getColumn(uint32_t x, uint32_t z) const
+    {
+        const uint32_t cluster_size = params.cluster_size;
+        uint32_t cluster = (z / cluster_size) * clusters_x + x / cluster_size;
+        return cluster * cluster_size * cluster_size + (z % cluster_size) * cluster_size + x % cluster_size;
+    }
+
+    glm::uvec2 Navigation::getColumnCoord(uint32_t column) const
+    {
+        const uint32_t cluster_size = params.cluster_size;
+        uint32_t cluster = column / (cluster_size * cluster_size);
+        uint32_t local = column % (cluster_size * cluster_size);
+        return { (cluster % clusters_x) * cluster_size + local % cluster_size, (cluster / clusters_x) * cluster_size + local / cluster_size };
+    }
+
+    uint32_t Navigation::getCluster(uint32_t node) const
+    {
+        return nodes[node].column / (params.cluster_size * params.cluster_size);
+    }
+
+    uint32_t Navigation::getNeighbour(uint32_t node, int direction) const
+    {
+        uint8_t link = nodes[node].links[direction];
+        if (link == no_link)
+            return invalid_node;
+        auto coord = getColumnCoord(nodes[node].column);
+        return column_first[getColumn(coord.x + direction_x[direction], coord.y + direction_z[direction])] + link;
+    }
+
+    glm::vec3 Navigation::getNodePos(uint32_t node) const
+    {
+        auto coord = getColumnCoord(nodes[node].column);
+        return { origin.x + (coord.x + 0.5f) * params.cell_size, -nodes[node].height, origin.y + (coord.y + 0.5f) * params.cell_size };
+    }
+
+    float Navigation::getLinkCost(uint32_t from, uint32_t to) const
+    {
+        return glm::distance(getNodePos(from), getNodePos(to));
+    }
+
+    uint64_t Navigation::hashSource(const std::vector<CollisionMeshData>& meshes, const std::vector<CollisionEntry>& entries)
+    {
+        uint64_t count = meshes.size();
+        uint64_t hash = lotus::Hash::xxh64(&count, sizeof(count));
+        for (const auto& mesh : meshes)
+        {
+            hash = lotus::Hash::xxh64(mesh.vertices.data(), mesh.vertices.size(), hash);
+            hash = lotus::Hash::xxh64(mesh.normals.data(), mesh.normals.size(), hash);
+            hash = lotus::Hash::xxh64(mesh.indices.data(), mesh.indices.size() * sizeof(uint16_t), hash);
+            hash = lotus::Hash::xxh64(&mesh.flags, sizeof(mesh.flags), hash);
+        }
+        return lotus::Hash::xxh64(entries.data(), entries.size() * sizeof(CollisionEntry), hash);
+    }
+
+    bool Navigation::save(const std::string& path, uint64_t source_hash) const
+    {
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        if (!file.good())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&file_magic), sizeof(file_magic));
+        file.write(reinterpret_cast<const char*>(&file_version), sizeof(file_version));
+        file.write(reinterpret_cast<const char*>(&source_hash), sizeof(source_hash));
+        file.write(reinterpret_cast<const char*>(&params), sizeof(params));
+        file.write(reinterpret_cast<const char*>(&origin), sizeof(origin));
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char*>(&depth), sizeof(depth));
+        file.write(reinterpret_cast<const char*>(&clusters_x), sizeof(clusters_x));
+        file.write(reinterpret_cast<const char*>(&clusters_z), sizeof(clusters_z));
+        writeVector(file, column_first);
+        writeVector(file, nodes);
+        writeVector(file, cluster_abstract_first);
+        writeVector(file, abstract_nodes);
+        writeVector(file, abstract_edges);
+        return file.good();
+    }
+
+    std::unique_ptr<Navigation> Navigation::load(const std::string& path, uint64_t source_hash, const Parameters& params)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file.good())
+            return {};
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        if (magic != file_magic || version != file_version)
+            return {};
+
+        uint64_t file_source_hash = 0;
+        file.read(reinterpret_cast<char*>(&file_source_hash), sizeof(file_source_hash));
+        if (file_source_hash != source_hash)
+            return {};
+
+        auto nav = std::unique_ptr<Navigation>(new Navigation());
+        file.read(reinterpret_cast<char*>(&nav->params), sizeof(nav->params));
+        if (nav->params.cell_size != params.cell_size || nav->params.agent_height != params.agent_height || nav->params.step_height != params.step_height ||
+            nav->params.max_slope != params.max_slope || nav->params.cluster_size != params.cluster_size)
+            return {};
+        file.read(reinterpret_cast<char*>(&nav->origin), sizeof(nav->origin));
+        file.read(reinterpret_cast<char*>(&nav->width), sizeof(nav->width));
+        file.read(reinterpret_cast<char*>(&nav->depth), sizeof(nav->depth));
+        file.read(reinterpret_cast<char*>(&nav->clusters_x), sizeof(nav->clusters_x));
+        file.read(reinterpret_cast<char*>(&nav->clusters_z), sizeof(nav->clusters_z));
+        if (!readVector(file, nav->column_first) || !readVector(file, nav->nodes) || !readVector(file, nav->cluster_abstract_first) ||
+            !readVector(file, nav->abstract_nodes) || !readVector(file, nav->abstract_edges))
+            return {};
+
+        if (nav->column_first.size() != static_cast<size_t>(nav->width) * nav->depth + 1 || nav->cluster_abstract_first.size() != nav->getClusterCount() + 1)
+            return {};
+
+        for (uint32_t i = 0; i < nav->abstract_nodes.size(); ++i)
+        {
+            nav->node_abstract[nav->abstract_nodes[i].node] = i;
+        }
+        return nav;
+    }
+}
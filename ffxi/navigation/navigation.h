@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <optional>
+#include <memory>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "dat/mzb.h"
+
+namespace FFXI
+{
+    //layered walkable grid built from MZB collision meshes, with a cluster graph on top for hierarchical A* (HPA*)
+    //heights are stored as -y, since ffxi's y axis points down
+    class Navigation
+    {
+    public:
+        struct Parameters
+        {
+            float cell_size{ 1.f };
+            float agent_height{ 2.f };
+            float step_height{ 0.75f };
+            float max_slope{ glm::radians(50.f) };
+            uint32_t cluster_size{ 16 };
+        };
+
+        //runs func(begin, end) over [0, count) in chunks of chunk_size, returning once every chunk has run (see lotus::WorkerPool::parallelFor)
+        using ParallelFor = std::function<void(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& func)>;
+
+        //the build steps are split by triangle, cluster or node over parallel_for (everything on the calling thread if it's empty)
+        //the graph comes out the same either way
+        static std::unique_ptr<Navigation> build(const std::vector<CollisionMeshData>& meshes, const std::vector<CollisionEntry>& entries, const Parameters& params, const ParallelFor& parallel_for = {});
+        static std::unique_ptr<Navigation> build(const std::vector<CollisionMeshData>& meshes, const std::vector<CollisionEntry>& entries, const ParallelFor& parallel_for = {}) { return build(meshes, entries, Parameters{}, parallel_for); }
+        //hash of the collision data a graph is built from, saved with it so a stale file isn't loaded for a changed zone
+        static uint64_t hashSource(const std::vector<CollisionMeshData>& meshes, const std::vector<CollisionEntry>& entries);
+        //null if the file is missing, from another version, or was saved for different source data or parameters
+        static std::unique_ptr<Navigation> load(const std::string& path, uint64_t source_hash, const Parameters& params);
+        static std::unique_ptr<Navigation> load(const std::string& path, uint64_t source_hash) { return load(path, source_hash, Parameters{}); }
+        bool save(const std::string& path, uint64_t source_hash) const;
+
+        //waypoints are cell centers from start to goal (inclusive), empty if either end isn't near walkable ground
+        std::vector<glm::vec3> findPath(glm::vec3 start, glm::vec3 goal) const;
+        std::optional<glm::vec3> findNearestWalkable(glm::vec3 pos) const;
+
+        size_t getNodeCount() const { return nodes.size(); }
+        size_t getClusterCount() const { return static_cast<size_t>(clusters_x) * clusters_z; }
+        size_t getAbstractNodeCount() const { return abstract_nodes.size(); }
+
+    private:
+        static constexpr uint8_t no_link = 0xFF;
+        static constexpr uint32_t invalid_node = 0xFFFFFFFF;
+        static constexpr size_t max_cached_segments = 1 << 16;
+        //orthogonal directions first, diagonals after
+        static constexpr int direction_x[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+        static constexpr int direction_z[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+        struct Node
+        {
+            uint32_t column;
+            float height;
+            //layer index in each neighbouring column (see direction_x/z), or no_link
+            uint8_t links[8];
+        };
+
+        struct AbstractNode
+        {
+            uint32_t node;
+            uint32_t first_edge;
+            uint32_t edge_count;
+        };
+
+        struct AbstractEdge
+        {
+            uint32_t to;
+            float cost;
+        };
+
+        Navigation() = default;
+
+        uint32_t getColumn(uint32_t x, uint32_t z) const;
+        glm::uvec2 getColumnCoord(uint32_t column) const;
+        uint32_t getCluster(uint32_t node) const;
+        uint32_t getNeighbour(uint32_t node, int direction) const;
+        glm::vec3 getNodePos(uint32_t node) const;
+        float getLinkCost(uint32_t from, uint32_t to) const;
+        uint32_t findNode(glm::vec3 pos) const;
+
+        //A* restricted to one cluster; if goal is invalid_node, runs Dijkstra to every node and leaves the costs in the scratch buffers
+        bool searchCluster(uint32_t cluster, uint32_t start, uint32_t goal, std::vector<uint32_t>* path) const;
+        std::vector<std::pair<uint32_t, float>> connectToAbstract(uint32_t node) const;
+        std::vector<uint32_t> getSegment(uint32_t from, uint32_t to) const;
+
+        void buildLinks(const ParallelFor& parallel_for);
+        void buildAbstractGraph(const ParallelFor& parallel_for);
+
+        Parameters params;
+        glm::vec2 origin{};
+        uint32_t width{ 0 };
+        uint32_t depth{ 0 };
+        uint32_t clusters_x{ 0 };
+        uint32_t clusters_z{ 0 };
+
+        //columns are ordered cluster by cluster so each cluster's nodes are contiguous
+        std::vector<uint32_t> column_first;
+        std::vector<Node> nodes;
+
+        //abstract nodes are sorted by cluster
+        std::vector<uint32_t> cluster_abstract_first;
+        std::vector<AbstractNode> abstract_nodes;
+        std::vector<AbstractEdge> abstract_edges;
+        std::unordered_map<uint32_t, uint32_t> node_abstract;
+
+        mutable std::shared_mutex cache_mutex;
+        mutable std::unordered_map<uint64_t, std::vector<uint32_t>> segment_cache;
+    };
+}
@@ -0,0 +1,308 @@
+#include "navigation.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace FFXI
+{
+    namespace
+    {
+        struct SearchScratch
+        {
+            std::vector<float> cost;
+            std::vector<uint32_t> parent;
+            std::vector<uint8_t> closed;
+            std::vector<std::pair<float, uint32_t>> open;
+
+            void reset(size_t size)
+            {
+                cost.assign(size, std::numeric_limits<float>::max());
+                parent.assign(size, 0xFFFFFFFF);
+                closed.assign(size, 0);
+                open.clear();
+            }
+
+            void push(float f, uint32_t index)
+            {
+                open.emplace_back(f, index);
+                std::push_heap(open.begin(), open.end(), std::greater<>{});
+            }
+
+            uint32_t pop()
+            {
+                std::pop_heap(open.begin(), open.end(), std::greater<>{});
+                uint32_t index = open.back().second;
+                open.pop_back();
+                return index;
+            }
+        };
+
+        //queries can come from any thread, so each keeps its own search buffers
+        thread_local SearchScratch cluster_scratch;
+        thread_local SearchScratch abstract_scratch;
+        thread_local std::vector<float> goal_costs;
+    }
+
+    uint32_t Navigation::findNode(glm::vec3 pos) const
+    {
+        if (nodes.empty())
+            return invalid_node;
+
+        float height = -pos.y;
+        int x = static_cast<int>(glm::floor((pos.x - origin.x) / params.cell_size));
+        int z = static_cast<int>(glm::floor((pos.z - origin.y) / params.cell_size));
+
+        uint32_t best = invalid_node;
+        float best_score = std::numeric_limits<float>::max();
+        for (int radius = 0; radius <= 2 && best == invalid_node; ++radius)
+        {
+            for (int dz = -radius; dz <= radius; ++dz)
+            {
+                for (int dx = -radius; dx <= radius; ++dx)
+                {
+                    if (std::max(std::abs(dx), std::abs(dz)) != radius)
+                        continue;
+                    int cx = x + dx;
+                    int cz = z + dz;
+                    if (cx < 0 || cz < 0 || cx >= static_cast<int>(width) || cz >= static_cast<int>(depth))
+                        continue;
+                    uint32_t column = getColumn(cx, cz);
+                    for (uint32_t node = column_first[column]; node < column_first[column + 1]; ++node)
+                    {
+                        float height_diff = glm::abs(nodes[node].height - height);
+                        if (height_diff > params.agent_height + params.step_height)
+                            continue;
+                        float score = height_diff + glm::distance(glm::vec2{ pos.x, pos.z }, glm::vec2{ getNodePos(node).x, getNodePos(node).z });
+                        if (score < best_score)
+                        {
+                            best = node;
+                            best_score = score;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    bool Navigation::searchCluster(uint32_t cluster, uint32_t start, uint32_t goal, std::vector<uint32_t>* path) const
+    {
+        const uint32_t cluster_columns = params.cluster_size * params.cluster_size;
+        uint32_t begin = column_first[cluster * cluster_columns];
+        uint32_t end = column_first[(cluster + 1) * cluster_columns];
+
+        auto& scratch = cluster_scratch;
+        scratch.reset(end - begin);
+
+        glm::vec3 goal_pos = goal != invalid_node ? getNodePos(goal) : glm::vec3{};
+        auto heuristic = [&](uint32_t node)
+        {
+            return goal != invalid_node ? glm::distance(getNodePos(node), goal_pos) : 0.f;
+        };
+
+        scratch.cost[start - begin] = 0.f;
+        scratch.push(heuristic(start), start);
+        while (!scratch.open.empty())
+        {
+            uint32_t node = scratch.pop();
+            if (scratch.closed[node - begin])
+                continue;
+            scratch.closed[node - begin] = 1;
+
+            if (node == goal)
+            {
+                if (path)
+                {
+                    path->clear();
+                    for (uint32_t current = goal; current != invalid_node; current = scratch.parent[current - begin])
+                    {
+                        path->push_back(current);
+                    }
+                    std::reverse(path->begin(), path->end());
+                }
+                return true;
+            }
+
+            for (int direction = 0; direction < 8; ++direction)
+            {
+                uint32_t neighbour = getNeighbour(node, direction);
+                if (neighbour == invalid_node || neighbour < begin || neighbour >= end || scratch.closed[neighbour - begin])
+                    continue;
+                float cost = scratch.cost[node - begin] + getLinkCost(node, neighbour);
+                if (cost < scratch.cost[neighbour - begin])
+                {
+                    scratch.cost[neighbour - begin] = cost;
+                    scratch.parent[neighbour - begin] = node;
+                    scratch.push(cost + heuristic(neighbour), neighbour);
+                }
+            }
+        }
+        return goal == invalid_node;
+    }
+
+    std::vector<std::pair<uint32_t, float>> Navigation::connectToAbstract(uint32_t node) const
+    {
+        std::vector<std::pair<uint32_t, float>> result;
+        uint32_t cluster = getCluster(node);
+        searchCluster(cluster, node, invalid_node, nullptr);
+
+        uint32_t begin = column_first[cluster * params.cluster_size * params.cluster_size];
+        for (uint32_t i = cluster_abstract_first[cluster]; i < cluster_abstract_first[cluster + 1]; ++i)
+        {
+            float cost = cluster_scratch.cost[abstract_nodes[i].node - begin];
+            if (cost < std::numeric_limits<float>::max())
+                result.emplace_back(i, cost);
+        }
+        return result;
+    }
+
+    std::vector<uint32_t> Navigation::getSegment(uint32_t from, uint32_t to) const
+    {
+        //only entrance to entrance segments repeat between queries, so only those are cached
+        bool cacheable = node_abstract.contains(from) && node_abstract.contains(to);
+        uint64_t key = (static_cast<uint64_t>(from) << 32) | to;
+        if (cacheable)
+        {
+            std::shared_lock lock{ cache_mutex };
+            if (auto found = segment_cache.find(key); found != segment_cache.end())
+                return found->second;
+        }
+
+        std::vector<uint32_t> segment;
+        if (!searchCluster(getCluster(from), from, to, &segment))
+            return {};
+
+        if (cacheable)
+        {
+            std::unique_lock lock{ cache_mutex };
+            if (segment_cache.size() >= max_cached_segments)
+                segment_cache.clear();
+            segment_cache.emplace(key, segment);
+        }
+        return segment;
+    }
+
+    std::vector<glm::vec3> Navigation::findPath(glm::vec3 start, glm::vec3 goal) const
+    {
+        uint32_t start_node = findNode(start);
+        uint32_t goal_node = findNode(goal);
+        if (start_node == invalid_node || goal_node == invalid_node)
+            return {};
+
+        std::vector<uint32_t> node_path;
+        uint32_t start_cluster = getCluster(start_node);
+        uint32_t goal_cluster = getCluster(goal_node);
+
+        //a local search is enough unless the only route leaves the cluster
+        if (start_cluster != goal_cluster || !searchCluster(start_cluster, start_node, goal_node, &node_path))
+        {
+            auto start_links = connectToAbstract(start_node);
+            auto goal_links = connectToAbstract(goal_node);
+            if (start_links.empty() || goal_links.empty())
+                return {};
+
+            //abstract graph plus two virtual nodes for the start and goal
+            const uint32_t abstract_count = static_cast<uint32_t>(abstract_nodes.size());
+            const uint32_t virtual_start = abstract_count;
+            const uint32_t virtual_goal = abstract_count + 1;
+
+            goal_costs.assign(abstract_count, std::numeric_limits<float>::max());
+            for (const auto& [abstract, cost] : goal_links)
+            {
+                goal_costs[abstract] = cost;
+            }
+
+            auto& scratch = abstract_scratch;
+            scratch.reset(abstract_count + 2);
+            glm::vec3 goal_pos = getNodePos(goal_node);
+
+            auto relax = [&](uint32_t from, uint32_t to, float edge_cost)
+            {
+                if (scratch.closed[to])
+                    return;
+                float cost = scratch.cost[from] + edge_cost;
+                if (cost < scratch.cost[to])
+                {
+                    scratch.cost[to] = cost;
+                    scratch.parent[to] = from;
+                    float heuristic = to == virtual_goal ? 0.f : glm::distance(getNodePos(abstract_nodes[to].node), goal_pos);
+                    scratch.push(cost + heuristic, to);
+                }
+            };
+
+            scratch.cost[virtual_start] = 0.f;
+            scratch.closed[virtual_start] = 1;
+            for (const auto& [abstract, cost] : start_links)
+            {
+                relax(virtual_start, abstract, cost);
+            }
+
+            bool found = false;
+            while (!scratch.open.empty())
+            {
+                uint32_t current = scratch.pop();
+                if (scratch.closed[current])
+                    continue;
+                scratch.closed[current] = 1;
+                if (current == virtual_goal)
+                {
+                    found = true;
+                    break;
+                }
+                const auto& abstract = abstract_nodes[current];
+                for (uint32_t edge = abstract.first_edge; edge < abstract.first_edge + abstract.edge_count; ++edge)
+                {
+                    relax(current, abstract_edges[edge].to, abstract_edges[edge].cost);
+                }
+                if (goal_costs[current] < std::numeric_limits<float>::max())
+                {
+                    relax(current, virtual_goal, goal_costs[current]);
+                }
+            }
+            if (!found)
+                return {};
+
+            std::vector<uint32_t> waypoints{ goal_node };
+            for (uint32_t current = scratch.parent[virtual_goal]; current != virtual_start; current = scratch.parent[current])
+            {
+                waypoints.push_back(abstract_nodes[current].node);
+            }
+            waypoints.push_back(start_node);
+            std::reverse(waypoints.begin(), waypoints.end());
+
+            //refine each abstract edge back into grid nodes
+            node_path = { start_node };
+            for (size_t i = 1; i < waypoints.size(); ++i)
+            {
+                uint32_t from = waypoints[i - 1];
+                uint32_t to = waypoints[i];
+                if (from == to)
+                    continue;
+                if (getCluster(from) != getCluster(to))
+                {
+                    node_path.push_back(to);
+                    continue;
+                }
+                auto segment = getSegment(from, to);
+                if (segment.empty())
+                    return {};
+                node_path.insert(node_path.end(), segment.begin() + 1, segment.end());
+            }
+        }
+
+        std::vector<glm::vec3> path;
+        path.reserve(node_path.size());
+        for (auto node : node_path)
+        {
+            path.push_back(getNodePos(node));
+        }
+        return path;
+    }
+
+    std::optional<glm::vec3> Navigation::findNearestWalkable(glm::vec3 pos) const
+    {
+        if (auto node = findNode(pos); node != invalid_node)
+            return getNodePos(node);
+        return {};
+    }
+}
@@ -28,7 +28,7 @@ void ActorDatLoad::Process(lotus::WorkerThread* thread)
         {
             if (dxt3->width > 0)
             {
-                auto texture = lotus::Texture::LoadTexture<FFXI::DXT3Loader>(thread->engine, dxt3->name, dxt3);
+                auto texture = lotus::Texture::LoadTexture<FFXI::DXT3Loader>(thread->engine, dat + ":" + dxt3->name, dxt3);
                 texture_map[dxt3->name] = std::move(texture);
             }
         }
@@ -42,15 +42,17 @@ void ActorDatLoad::Process(lotus::WorkerThread* thread)
         }
         else if (auto mo2 = dynamic_cast<FFXI::MO2*>(chunk.get()))
         {
-            std::unique_ptr<lotus::Animation> animation = std::make_unique<lotus::Animation>(skel.get());
+            std::unique_ptr<lotus::Animation> animation = std::make_unique<lotus::Animation>(skel.get(), mo2->frames);
             animation->name = mo2->name;
             animation->frame_duration = std::chrono::milliseconds(static_cast<int>(1000 * (1.f / 30.f) / mo2->speed));
 
-            for (size_t i = 0; i < mo2->frames; ++i)
+            //parents always come before their children, so each bone's whole track can be added at once
+            for (uint32_t bone = 0; bone < skel->bones.size(); ++bone)
             {
-                for (size_t bone = 0; bone < skel->bones.size(); ++bone)
+                auto transform = mo2->animation_data.find(bone);
+                for (uint32_t i = 0; i < mo2->frames; ++i)
                 {
-                    if (auto transform = mo2->animation_data.find(bone); transform != mo2->animation_data.end())
+                    if (transform != mo2->animation_data.end())
                     {
                         auto& mo2_transform = transform->second[i];
                         animation->addFrameData(i, bone, { mo2_transform.rot, mo2_transform.trans, mo2_transform.scale });
@@ -61,6 +63,8 @@ void ActorDatLoad::Process(lotus::WorkerThread* thread)
                     }
                 }
             }
+            const auto& config = thread->engine->config->renderer;
+            animation->compress(config.animation_rotation_tolerance, config.animation_translation_tolerance, config.animation_scale_tolerance);
             skel->animations[animation->name] = std::move(animation);
         }
         else if (auto os2 = dynamic_cast<FFXI::OS2*>(chunk.get()))
@@ -71,7 +75,7 @@ void ActorDatLoad::Process(lotus::WorkerThread* thread)
 
     entity->addSkeleton(std::move(skel), sizeof(FFXI::OS2::Vertex));
 
-    entity->models.push_back(lotus::Model::LoadModel<FFXIActorLoader>(thread->engine, "iroha_test", os2s, pSk2));
+    entity->models.push_back(lotus::Model::LoadModel<FFXIActorLoader>(thread->engine, dat, os2s, pSk2, dat));
 
     thread->engine->worker_pool.addWork(std::make_unique<lotus::RenderableEntityInitTask>(entity));
 }
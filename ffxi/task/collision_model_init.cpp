@@ -17,7 +17,7 @@ void CollisionModelInitTask::Process(lotus::WorkerThread* thread)
     CollisionMesh* mesh = static_cast<CollisionMesh*>(model->meshes[0].get());
 
     staging_buffer = thread->engine->renderer.memory_manager->GetBuffer(mesh->vertex_buffer->getSize() + mesh->index_buffer->getSize() + mesh->transform_buffer->getSize(),
-        vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, lotus::MemoryCategory::Staging);
 
     uint8_t* staging_map = static_cast<uint8_t*>(staging_buffer->map(0, VK_WHOLE_SIZE, {}));
 
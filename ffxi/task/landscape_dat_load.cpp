@@ -9,6 +9,7 @@
 #include "engine/core.h"
 #include "engine/worker_thread.h"
 #include "engine/task/landscape_entity_init.h"
+#include "task/navigation_build.h"
 #include "engine/renderer/acceleration_structure.h"
 
 LandscapeDatLoad::LandscapeDatLoad(const std::shared_ptr<FFXILandscapeEntity>& _entity, const std::string& _dat) : entity(_entity), dat(_dat)
@@ -39,7 +40,7 @@ void LandscapeDatLoad::Process(lotus::WorkerThread* thread)
         {
             if (dxt3->width > 0)
             {
-                auto texture = lotus::Texture::LoadTexture<FFXI::DXT3Loader>(thread->engine, dxt3->name, dxt3);
+                auto texture = lotus::Texture::LoadTexture<FFXI::DXT3Loader>(thread->engine, dat + ":" + dxt3->name, dxt3);
                 texture_map[dxt3->name] = std::move(texture);
             }
         }
@@ -51,16 +52,13 @@ void LandscapeDatLoad::Process(lotus::WorkerThread* thread)
         {
             std::string name(mmb->name, 16);
 
-            entity->models.push_back(lotus::Model::LoadModel<FFXI::MMBLoader>(thread->engine, name, mmb));
+            entity->models.push_back(lotus::Model::LoadModel<FFXI::MMBLoader>(thread->engine, dat + ":" + name, mmb, dat));
             model_map[name] = entity->models.size() - 1;
         }
     }
 
     if (mzb)
     {
-        entity->instance_buffer = thread->engine->renderer.memory_manager->GetBuffer(sizeof(lotus::LandscapeEntity::InstanceInfo) * mzb->vecMZB.size(),
-            vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
         std::map<std::string, std::vector<lotus::LandscapeEntity::InstanceInfo>> temp_map;
         std::vector<lotus::LandscapeEntity::InstanceInfo> instance_info;
 
@@ -77,7 +75,9 @@ void LandscapeDatLoad::Process(lotus::WorkerThread* thread)
             glm::mat3 model_it = glm::transpose(glm::inverse(glm::mat3(model)));
             lotus::LandscapeEntity::InstanceInfo info{ model, model_t, model_it };
             temp_map[name].push_back(info);
-            entity->model_vec.push_back(std::make_pair(model_map[name], info));
+            auto model_index = model_map[name];
+            entity->model_vec.push_back(std::make_pair(model_index, info));
+            entity->instance_spheres.push_back(entity->models[model_index]->bounding_sphere.transform(model));
         }
 
         for (auto& [name, info_vec] : temp_map)
@@ -88,6 +88,9 @@ void LandscapeDatLoad::Process(lotus::WorkerThread* thread)
 
         entity->quadtree = *mzb->quadtree;
 
+        //the collision meshes are moved into the model below, so the navigation build needs its own copy
+        thread->engine->worker_pool.addWork(std::make_unique<NavigationBuildTask>(entity, dat, mzb->meshes, mzb->mesh_entries));
+
         entity->collision_models.push_back(lotus::Model::LoadModel<FFXI::CollisionLoader>(thread->engine, "", std::move(mzb->meshes), std::move(mzb->mesh_entries)));
 
         thread->engine->worker_pool.addWork(std::make_unique<lotus::LandscapeEntityInitTask>(entity, std::move(instance_info)));
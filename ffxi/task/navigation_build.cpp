@@ -0,0 +1,45 @@
+#include "navigation_build.h"
+
+#include <filesystem>
+#include "navigation/navigation.h"
+#include "engine/core.h"
+#include "engine/hash.h"
+#include "engine/worker_thread.h"
+#include "config.h"
+
+NavigationBuildTask::NavigationBuildTask(const std::shared_ptr<FFXILandscapeEntity>& _entity, const std::string& _dat, std::vector<FFXI::CollisionMeshData> _meshes, std::vector<FFXI::CollisionEntry> _entries) :
+    entity(_entity), dat(_dat), meshes(std::move(_meshes)), entries(std::move(_entries))
+{
+}
+
+void NavigationBuildTask::Process(lotus::WorkerThread* thread)
+{
+    const auto& cache_path = static_cast<FFXIConfig*>(thread->engine->config.get())->ffxi.navigation_cache_path;
+    uint64_t source_hash = FFXI::Navigation::hashSource(meshes, entries);
+    std::filesystem::path path;
+    std::shared_ptr<FFXI::Navigation> navigation;
+
+    if (!cache_path.empty())
+    {
+        //named after the dat it was built from, and checked against the collision data it was built from
+        path = std::filesystem::path{ cache_path } / (std::to_string(lotus::Hash::xxh64(dat.data(), dat.size())) + ".nav");
+        navigation = FFXI::Navigation::load(path.string(), source_hash);
+    }
+
+    if (!navigation)
+    {
+        //this task is already on a worker, and waits on the rest of them (taking chunks itself) for the build steps
+        auto& pool = thread->engine->worker_pool;
+        navigation = FFXI::Navigation::build(meshes, entries, [&pool](size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& func)
+        {
+            pool.parallelFor(count, chunk_size, func);
+        });
+        if (!path.empty())
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(path.parent_path(), ec);
+            navigation->save(path.string(), source_hash);
+        }
+    }
+    entity->navigation.store(navigation);
+}
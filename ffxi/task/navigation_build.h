@@ -0,0 +1,19 @@
+#pragma once
+
+#include "engine/work_item.h"
+#include "entity/landscape_entity.h"
+
+class NavigationBuildTask : public lotus::WorkItem
+{
+public:
+    //dat names the saved graph, which is loaded instead of building it again when the collision data still matches
+    NavigationBuildTask(const std::shared_ptr<FFXILandscapeEntity>& entity, const std::string& dat, std::vector<FFXI::CollisionMeshData> meshes, std::vector<FFXI::CollisionEntry> entries);
+    virtual ~NavigationBuildTask() override = default;
+    virtual void Process(lotus::WorkerThread*) override;
+
+private:
+    std::shared_ptr<FFXILandscapeEntity> entity;
+    std::string dat;
+    std::vector<FFXI::CollisionMeshData> meshes;
+    std::vector<FFXI::CollisionEntry> entries;
+};
@@ -30,7 +30,7 @@ public:
         memcpy(texture_data.data(), pixels, imageSize);
         stbi_image_free(pixels);
 
-        texture->image = engine->renderer.memory_manager->GetImage(texture->getWidth(), texture->getHeight(), vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        texture->image = engine->renderer.memory_manager->GetImage(texture->getWidth(), texture->getHeight(), vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, 1, 1, lotus::MemoryCategory::Texture);
 
         vk::ImageViewCreateInfo image_view_info;
         image_view_info.image = texture->image->image;
@@ -60,6 +60,6 @@ public:
 
         texture->sampler = engine->renderer.device->createSamplerUnique(sampler_info, nullptr);
 
-        engine->worker_pool.addWork(std::make_unique<lotus::TextureInitTask>(engine->renderer.getCurrentImage(), texture, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, std::move(texture_data)));
+        engine->worker_pool.addWork(std::make_unique<lotus::TextureInitTask>(texture, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, std::move(texture_data)));
     }
 };
\ No newline at end of file
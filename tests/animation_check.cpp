@@ -0,0 +1,362 @@
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+
+#include "engine/config.h"
+#include "engine/renderer/animation.h"
+#include "engine/renderer/skeleton.h"
+#include "dat/sk2.h"
+#include "dat/mo2.h"
+
+//checks Animation::sample() against the per-bone map and glm::slerp it replaced, checks compressed clips stay within the configured
+//  tolerances, and times all three, on synthetic clips and on every clip of the DAT given
+
+namespace
+{
+    using lotus::Animation;
+
+    //how clips were stored and sampled before the streams: a map of bone transforms per frame, one bone at a time
+    using MapClip = std::vector<std::map<uint32_t, Animation::BoneTransform>>;
+
+    MapClip toMapClip(const Animation& clip)
+    {
+        MapClip map_clip(clip.getFrameCount());
+        for (uint32_t frame = 0; frame < clip.getFrameCount(); ++frame)
+        {
+            for (uint32_t bone = 0; bone < clip.getBoneCount(); ++bone)
+            {
+                map_clip[frame][bone] = clip.getTransform(frame, bone);
+            }
+        }
+        return map_clip;
+    }
+
+    void sampleMapClip(const MapClip& clip, uint32_t frame, uint32_t next_frame, float t, std::vector<Animation::BoneTransform>& out)
+    {
+        for (uint32_t i = 0; i < out.size(); ++i)
+        {
+            out[i].rot = glm::slerp(clip[frame].at(i).rot, clip[next_frame].at(i).rot, t);
+            out[i].trans = glm::mix(clip[frame].at(i).trans, clip[next_frame].at(i).trans, t);
+            out[i].scale = glm::mix(clip[frame].at(i).scale, clip[next_frame].at(i).scale, t);
+        }
+    }
+
+    //bones with random bind poses; 83 of them so the 4 and 1 wide remainders get sampled too
+    std::unique_ptr<lotus::Skeleton> makeSkeleton(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+        auto skeleton = std::make_unique<lotus::Skeleton>();
+        for (uint32_t bone = 0; bone < 83; ++bone)
+        {
+            glm::quat rot = glm::normalize(glm::quat{ dist(rng), dist(rng), dist(rng), dist(rng) });
+            skeleton->addBone(bone == 0 ? 0 : static_cast<uint8_t>(rng() % bone), rot, glm::vec3{ dist(rng), dist(rng), dist(rng) } * 0.3f);
+        }
+        return skeleton;
+    }
+
+    //most bones swinging about an axis of their own
+    std::unique_ptr<Animation> makeClip(lotus::Skeleton* skeleton, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+        constexpr uint32_t frames{ 60 };
+        auto clip = std::make_unique<Animation>(skeleton, frames);
+        for (uint32_t bone = 0; bone < skeleton->bones.size(); ++bone)
+        {
+            bool animated = bone % 3 != 0;
+            glm::vec3 axis = glm::normalize(glm::vec3{ dist(rng), dist(rng), dist(rng) });
+            for (uint32_t frame = 0; frame < frames; ++frame)
+            {
+                float angle = animated ? std::sin(frame * 0.1f + bone) * 0.5f : 0.f;
+                glm::quat rot{ std::cos(angle), axis.x * std::sin(angle), axis.y * std::sin(angle), axis.z * std::sin(angle) };
+                clip->addFrameData(frame, bone, { rot, glm::vec3{ 0.f, animated ? std::sin(frame * 0.05f) * 0.1f : 0.f, 0.f }, glm::vec3{ 1.f } });
+            }
+        }
+        return clip;
+    }
+
+    //two frames of unrelated rotations, far further apart than a clip's frames ever are: the worst case for the nlerp fit
+    std::unique_ptr<Animation> makeRandomClip(lotus::Skeleton* skeleton, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+        auto clip = std::make_unique<Animation>(skeleton, 2);
+        for (uint32_t bone = 0; bone < skeleton->bones.size(); ++bone)
+        {
+            for (uint32_t frame = 0; frame < 2; ++frame)
+            {
+                glm::quat rot = glm::normalize(glm::quat{ dist(rng), dist(rng), dist(rng), dist(rng) });
+                clip->addFrameData(frame, bone, { rot, glm::vec3{ dist(rng), dist(rng), dist(rng) }, glm::vec3{ 1.f + dist(rng) * 0.5f } });
+            }
+        }
+        return clip;
+    }
+
+    //the same as ActorDatLoad, up to the compression (see checkCompression)
+    std::unique_ptr<Animation> makeClip(lotus::Skeleton* skeleton, const FFXI::MO2& mo2)
+    {
+        auto clip = std::make_unique<Animation>(skeleton, mo2.frames);
+        for (uint32_t bone = 0; bone < skeleton->bones.size(); ++bone)
+        {
+            auto transform = mo2.animation_data.find(bone);
+            for (uint32_t frame = 0; frame < mo2.frames; ++frame)
+            {
+                if (transform != mo2.animation_data.end())
+                    clip->addFrameData(frame, bone, { transform->second[frame].rot, transform->second[frame].trans, transform->second[frame].scale });
+                else
+                    clip->addFrameData(frame, bone, { glm::quat{ 1, 0, 0, 0 }, glm::vec3{ 0 }, glm::vec3{ 1 } });
+            }
+        }
+        return clip;
+    }
+
+    struct Error
+    {
+        double rot{ 0 };
+        double trans{ 0 };
+        double scale{ 0 };
+    };
+
+    //2 atan2(|a - b|, |a + b|) rather than acos of the dot product, which can't resolve small angles in float
+    double angleBetween(glm::quat a, glm::quat b)
+    {
+        double qa[4] = { a.x, a.y, a.z, a.w };
+        double qb[4] = { b.x, b.y, b.z, b.w };
+        double dot = 0, length_a = 0, length_b = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            dot += qa[c] * qb[c];
+            length_a += qa[c] * qa[c];
+            length_b += qb[c] * qb[c];
+        }
+        double sign = dot < 0 ? -1.0 : 1.0;
+        double difference = 0, sum = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            double x = qa[c] / std::sqrt(length_a);
+            double y = sign * qb[c] / std::sqrt(length_b);
+            difference += (x - y) * (x - y);
+            sum += (x + y) * (x + y);
+        }
+        return 2.0 * std::atan2(std::sqrt(difference), std::sqrt(sum));
+    }
+
+    double maxDifference(glm::vec3 a, glm::vec3 b)
+    {
+        return std::max({ std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z) });
+    }
+
+    void compare(const Animation::Streams& pose, const std::vector<Animation::BoneTransform>& expected, Error& error)
+    {
+        for (uint32_t i = 0; i < expected.size(); ++i)
+        {
+            auto transform = pose.get(i);
+            error.rot = std::max(error.rot, angleBetween(transform.rot, expected[i].rot));
+            error.trans = std::max(error.trans, maxDifference(transform.trans, expected[i].trans));
+            error.scale = std::max(error.scale, maxDifference(transform.scale, expected[i].scale));
+        }
+    }
+
+    //every pair of neighbouring frames at a few points between them, and each frame faded in from the one halfway through the clip,
+    //  sampled from clip and compared with reference's frames run through slerp
+    Error accuracy(const Animation& clip, const Animation& reference)
+    {
+        MapClip map_clip = toMapClip(reference);
+        std::vector<Animation::BoneTransform> expected(clip.getBoneCount());
+        Animation::Streams pose, from;
+        pose.resize(clip.getBoneCount());
+        from.resize(clip.getBoneCount());
+
+        Error error;
+        for (uint32_t frame = 0; frame + 1 < clip.getFrameCount(); ++frame)
+        {
+            for (float t : { 0.f, 0.25f, 0.5f, 0.75f, 1.f })
+            {
+                clip.sample(frame, frame + 1, t, pose);
+                sampleMapClip(map_clip, frame, frame + 1, t, expected);
+                compare(pose, expected, error);
+            }
+        }
+
+        uint32_t from_frame = clip.getFrameCount() / 2;
+        clip.sample(from_frame, from_frame, 0.f, from);
+        for (uint32_t frame = 0; frame < clip.getFrameCount(); ++frame)
+        {
+            for (float fade : { 0.25f, 0.5f, 0.75f })
+            {
+                clip.sample(frame, frame, 0.f, pose, &from, fade);
+                for (uint32_t i = 0; i < clip.getBoneCount(); ++i)
+                {
+                    const auto& source = map_clip[from_frame].at(i);
+                    const auto& target = map_clip[frame].at(i);
+                    expected[i] = { glm::slerp(source.rot, target.rot, fade), glm::mix(source.trans, target.trans, fade), glm::mix(source.scale, target.scale, fade) };
+                }
+                compare(pose, expected, error);
+            }
+        }
+        return error;
+    }
+
+    //the nlerp fit keeps within about 1e-3 radians of slerp, and the lerps only differ from glm::mix by rounding
+    void checkAccuracy(const std::string& name, const Animation& clip)
+    {
+        auto error = accuracy(clip, clip);
+        std::printf("%s: worst error against slerp %.2e rad, translation %.2e, scale %.2e\n", name.c_str(), error.rot, error.trans, error.scale);
+        check::expect(error.rot < 1e-3, (name + ": rotations within 1e-3 radians of slerp").c_str());
+        check::expect(error.trans < 1e-4, (name + ": translations match").c_str());
+        check::expect(error.scale < 1e-4, (name + ": scales match").c_str());
+    }
+
+    //compresses clip (built the same as source) as ActorDatLoad does
+    //every decoded frame has to be within the tolerances of source's, or for keys that were kept, within their quantization
+    //sampling then adds no more than the slerp fit, as lerping between two frames stays within the larger of their errors
+    void checkCompression(const std::string& name, const Animation& source, Animation& clip, const lotus::Config::Renderer& config)
+    {
+        clip.compress(config.animation_rotation_tolerance, config.animation_translation_tolerance, config.animation_scale_tolerance);
+
+        glm::vec3 trans_min{ std::numeric_limits<float>::max() }, trans_max{ std::numeric_limits<float>::lowest() };
+        glm::vec3 scale_min{ std::numeric_limits<float>::max() }, scale_max{ std::numeric_limits<float>::lowest() };
+        Error error;
+        for (uint32_t frame = 0; frame < source.getFrameCount(); ++frame)
+        {
+            for (uint32_t bone = 0; bone < source.getBoneCount(); ++bone)
+            {
+                auto expected = source.getTransform(frame, bone);
+                auto decoded = clip.getTransform(frame, bone);
+                error.rot = std::max(error.rot, angleBetween(decoded.rot, expected.rot));
+                error.trans = std::max(error.trans, static_cast<double>(glm::distance(decoded.trans, expected.trans)));
+                error.scale = std::max(error.scale, static_cast<double>(glm::distance(decoded.scale, expected.scale)));
+                trans_min = glm::min(trans_min, expected.trans);
+                trans_max = glm::max(trans_max, expected.trans);
+                scale_min = glm::min(scale_min, expected.scale);
+                scale_max = glm::max(scale_max, expected.scale);
+            }
+        }
+        //half a step of 16 bits across the clip's range, plus float rounding
+        constexpr double slack{ 1e-5 };
+        double rot_bound = std::max<double>(config.animation_rotation_tolerance, 1e-4) + slack;
+        double trans_bound = std::max<double>(config.animation_translation_tolerance, glm::length(trans_max - trans_min) / 65535.0 * 0.5) + slack;
+        double scale_bound = std::max<double>(config.animation_scale_tolerance, glm::length(scale_max - scale_min) / 65535.0 * 0.5) + slack;
+
+        std::printf("%s compressed: %.1f KB (%.1f KB uncompressed), worst error %.2e rad, translation %.2e, scale %.2e\n",
+            name.c_str(), clip.getMemorySize() / 1024.0, clip.getUncompressedSize() / 1024.0, error.rot, error.trans, error.scale);
+        check::expect(error.rot <= rot_bound, (name + ": compressed rotations within the tolerance").c_str());
+        check::expect(error.trans <= trans_bound, (name + ": compressed translations within the tolerance").c_str());
+        check::expect(error.scale <= scale_bound, (name + ": compressed scales within the tolerance").c_str());
+
+        auto sampled = accuracy(clip, source);
+        std::printf("%s compressed: worst sampled error against slerp %.2e rad, translation %.2e, scale %.2e\n", name.c_str(), sampled.rot, sampled.trans, sampled.scale);
+        check::expect(sampled.rot <= rot_bound + 1e-3, (name + ": sampled compressed rotations within the tolerance of slerp").c_str());
+        //per component, so never more than the distance
+        check::expect(sampled.trans <= trans_bound, (name + ": sampled compressed translations within the tolerance").c_str());
+        check::expect(sampled.scale <= scale_bound, (name + ": sampled compressed scales within the tolerance").c_str());
+    }
+
+    //one tick of actors actors all playing clip, sampled the old way, from the streams and from the compressed clip
+    void benchmark(const std::string& name, const Animation& clip, const Animation& compressed, uint32_t actors)
+    {
+        if (clip.getFrameCount() < 2)
+            return;
+
+        MapClip map_clip = toMapClip(clip);
+        std::vector<Animation::BoneTransform> map_pose(clip.getBoneCount());
+        Animation::Streams pose;
+        pose.resize(clip.getBoneCount());
+
+        uint32_t frame = 0;
+        auto next = [&]() { frame = (frame + 1) % (clip.getFrameCount() - 1); };
+        double map_ms = check::time(20, [&]()
+        {
+            for (uint32_t actor = 0; actor < actors; ++actor)
+            {
+                sampleMapClip(map_clip, frame, frame + 1, 0.3f, map_pose);
+                next();
+            }
+        });
+        double streams_ms = check::time(20, [&]()
+        {
+            for (uint32_t actor = 0; actor < actors; ++actor)
+            {
+                clip.sample(frame, frame + 1, 0.3f, pose);
+                next();
+            }
+        });
+        double compressed_ms = check::time(20, [&]()
+        {
+            for (uint32_t actor = 0; actor < actors; ++actor)
+            {
+                compressed.sample(frame, frame + 1, 0.3f, pose);
+                next();
+            }
+        });
+        std::printf("%s: %u actors x %u bones, map + slerp %.3f ms/tick, streams %.3f ms/tick (%.1fx), compressed %.3f ms/tick (%.1fx)\n",
+            name.c_str(), actors, clip.getBoneCount(), map_ms, streams_ms, map_ms / streams_ms, compressed_ms, map_ms / compressed_ms);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    constexpr uint32_t actors{ 1000 };
+    lotus::Config config;
+    {
+        std::mt19937 rng{ 1 };
+        auto skeleton = makeSkeleton(rng);
+        auto make_clip = [&]()
+        {
+            std::mt19937 clip_rng{ 2 };
+            return makeClip(skeleton.get(), clip_rng);
+        };
+        auto clip = make_clip();
+        checkAccuracy("synthetic", *clip);
+        checkAccuracy("random rotations", *makeRandomClip(skeleton.get(), rng));
+        auto compressed_clip = make_clip();
+        checkCompression("synthetic", *clip, *compressed_clip, config.renderer);
+
+        auto before = Animation::getStats();
+        benchmark("synthetic", *clip, *compressed_clip, actors);
+        auto after = Animation::getStats();
+        check::expect(after.poses - before.poses == 2 * 20 * actors, "every sampled pose is counted in the stats");
+        check::expect(after.bones - before.bones == 2 * 20ull * actors * clip->getBoneCount(), "every sampled bone is counted in the stats");
+
+        auto compressed = make_clip();
+        compressed->compress(1e-3f, 1e-3f, 1e-3f);
+        auto loaded = Animation::getStats();
+        check::expect(loaded.clips == after.clips + 1, "loaded clips are counted in the stats");
+        check::expect(loaded.memory_bytes == after.memory_bytes + compressed->getMemorySize(), "the stats hold clips' compressed size");
+        check::expect(loaded.uncompressed_bytes == after.uncompressed_bytes + compressed->getUncompressedSize(), "the stats hold clips' uncompressed size");
+        std::printf("synthetic compressed: %.1f KB (%.1f KB uncompressed)\n", compressed->getMemorySize() / 1024.0, compressed->getUncompressedSize() / 1024.0);
+        compressed.reset();
+        check::expect(Animation::getStats().memory_bytes == after.memory_bytes, "unloaded clips are taken out of the stats");
+    }
+
+    if (argc > 1)
+    {
+        check::DatFile dat{ argv[1] };
+        check::expect(dat.good(), "DAT can be read");
+        auto sk2_chunks = dat.find(0x29);
+        if (!sk2_chunks.empty())
+        {
+            FFXI::SK2 sk2{ sk2_chunks.front().name, sk2_chunks.front().data, sk2_chunks.front().len };
+            lotus::Skeleton skeleton;
+            for (const auto& bone : sk2.bones)
+            {
+                skeleton.addBone(bone.parent_index, bone.rot, bone.trans);
+            }
+            for (const auto& chunk : dat.find(0x2B))
+            {
+                FFXI::MO2 mo2{ chunk.name, chunk.data, chunk.len };
+                std::string name = std::string(argv[1]) + " " + mo2.name;
+                auto clip = makeClip(&skeleton, mo2);
+                auto compressed = makeClip(&skeleton, mo2);
+                checkAccuracy(name, *clip);
+                checkCompression(name, *clip, *compressed, config.renderer);
+                benchmark(name, *clip, *compressed, actors);
+            }
+        }
+    }
+
+    return check::failures == 0 ? 0 : 1;
+}
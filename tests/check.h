@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//shared bits for the standalone checks: each one is an executable that prints what it measured and returns non-zero on failure
+namespace check
+{
+    inline int failures{ 0 };
+
+    inline void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    //milliseconds per call of func, averaged over iterations
+    template<typename F>
+    double time(uint32_t iterations, F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            func();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    //just enough of the DAT format to pull out chunks of one type, without bringing in the whole parser
+    class DatFile
+    {
+    public:
+        struct Chunk
+        {
+            uint32_t type;
+            char* name;
+            uint8_t* data;
+            size_t len;
+        };
+
+        explicit DatFile(const std::string& path)
+        {
+            std::ifstream file{ path, std::ios::ate | std::ios::binary };
+            if (!file.good())
+                return;
+            buffer.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        }
+
+        bool good() const { return !buffer.empty(); }
+
+        std::vector<Chunk> find(uint32_t type)
+        {
+            //16 byte headers: 4 character name, then 7 bits of type and 19 bits of length in 16 byte units
+            constexpr size_t header_size{ 16 };
+            std::vector<Chunk> chunks;
+            size_t offset = 0;
+            while (offset + header_size <= buffer.size())
+            {
+                uint32_t info;
+                std::memcpy(&info, buffer.data() + offset + 4, sizeof(info));
+                size_t len = static_cast<size_t>((info >> 7) & 0x7ffff) * 16;
+                if (len < header_size || offset + len > buffer.size())
+                    break;
+                if ((info & 0x7f) == type)
+                    chunks.push_back({ type, reinterpret_cast<char*>(buffer.data() + offset), buffer.data() + offset + header_size, len - header_size });
+                offset += len;
+            }
+            return chunks;
+        }
+
+    private:
+        std::vector<uint8_t> buffer;
+    };
+}
@@ -0,0 +1,102 @@
+#include "check.h"
+#include "engine/hash.h"
+
+//lotus::Hash::xxh64 against XXH64's reference vectors: the sanity buffer of the reference implementation's self test (which
+//  covers the short, 4/8 byte tail and 32 byte stripe paths, with and without a seed) and a few well known strings;
+//  unaligned input has to hash the same, and the throughput is reported
+
+namespace
+{
+    constexpr uint64_t prime32{ 2654435761ULL };
+    constexpr uint64_t prime64{ 11400714785074694797ULL };
+
+    struct Vector
+    {
+        size_t len;
+        uint64_t seed;
+        uint64_t hash;
+    };
+
+    constexpr Vector sanity_vectors[] = {
+        { 0, 0, 0xEF46DB3751D8E999ULL },
+        { 0, prime32, 0xAC75FDA2929B17EFULL },
+        { 1, 0, 0xE934A84ADB052768ULL },
+        { 1, prime32, 0x5014607643A9B4C3ULL },
+        { 4, 0, 0x9136A0DCA57457EEULL },
+        { 14, 0, 0x8282DCC4994E35C8ULL },
+        { 14, prime32, 0xC3BD6BF63DEB6DF0ULL },
+        { 222, 0, 0xB641AE8CB691C174ULL },
+        { 222, prime32, 0x20CB8AB7AE10C14AULL },
+    };
+
+    struct StringVector
+    {
+        const char* text;
+        uint64_t hash;
+    };
+
+    constexpr StringVector string_vectors[] = {
+        { "a", 0xD24EC4F1A98C6E5BULL },
+        { "abc", 0x44BC2CF5AD770999ULL },
+        { "message digest", 0x066ED728FCEEB3BEULL },
+        { "abcdefghijklmnopqrstuvwxyz", 0xCFE1F278FA89835CULL },
+        { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 0xAAA46907D3047814ULL },
+        { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", 0xE04A477F19EE145DULL },
+    };
+
+    //the reference implementation's sanity buffer
+    std::vector<uint8_t> makeSanityBuffer(size_t len)
+    {
+        std::vector<uint8_t> buffer(len);
+        uint64_t generator = prime32;
+        for (auto& byte : buffer)
+        {
+            byte = static_cast<uint8_t>(generator >> 56);
+            generator *= prime64;
+        }
+        return buffer;
+    }
+}
+
+int main()
+{
+    auto sanity = makeSanityBuffer(2367);
+    for (const auto& vector : sanity_vectors)
+    {
+        uint64_t hash = lotus::Hash::xxh64(sanity.data(), vector.len, vector.seed);
+        if (hash != vector.hash)
+            std::printf("sanity buffer, %zu bytes, seed %llx: %016llx, expected %016llx\n", vector.len,
+                static_cast<unsigned long long>(vector.seed), static_cast<unsigned long long>(hash), static_cast<unsigned long long>(vector.hash));
+        check::expect(hash == vector.hash, "the sanity buffer hashes to the reference value");
+    }
+    for (const auto& vector : string_vectors)
+    {
+        uint64_t hash = lotus::Hash::xxh64(vector.text, std::strlen(vector.text));
+        if (hash != vector.hash)
+            std::printf("\"%s\": %016llx, expected %016llx\n", vector.text, static_cast<unsigned long long>(hash), static_cast<unsigned long long>(vector.hash));
+        check::expect(hash == vector.hash, "the string hashes to the reference value");
+    }
+
+    //every length up to a few stripes, at every offset into a word
+    bool unaligned_match = true;
+    for (size_t len = 0; len <= 100; ++len)
+    {
+        uint64_t aligned = lotus::Hash::xxh64(sanity.data(), len, prime32);
+        for (size_t offset = 1; offset < 8; ++offset)
+        {
+            std::vector<uint8_t> shifted(len + offset);
+            std::memcpy(shifted.data() + offset, sanity.data(), len);
+            unaligned_match = unaligned_match && lotus::Hash::xxh64(shifted.data() + offset, len, prime32) == aligned;
+        }
+    }
+    check::expect(unaligned_match, "unaligned input hashes the same");
+
+    constexpr size_t throughput_size{ 16 * 1024 * 1024 };
+    auto large = makeSanityBuffer(throughput_size);
+    uint64_t hash = 0;
+    double ms = check::time(20, [&] { hash = lotus::Hash::xxh64(large.data(), large.size(), hash); });
+    std::printf("xxh64: %zu MB in %.2f ms (%.1f GB/s), chained hash %016llx\n", throughput_size / (1024 * 1024), ms,
+        throughput_size / (ms / 1000.0) / (1024.0 * 1024.0 * 1024.0), static_cast<unsigned long long>(hash));
+
+    return check::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include "check.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include "navigation/navigation.h"
+
+//navigation graphs built from synthetic multi-floor collision geometry: paths have to go around walls, stay on the floor they
+//  start on, take the ramp between floors and fail for ledges nothing leads up to; the build has to come out the same split
+//  over threads, survive a save/load round trip, and the build and query times are reported
+
+namespace
+{
+    //heights in the collision data are -y, as in ffxi
+    constexpr float platform_height{ 10.f };
+    constexpr float ledge_height{ 20.f };
+    constexpr float wall_x{ 100.f };
+    constexpr float wall_end_z{ 150.f };
+
+    struct Geometry
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<uint16_t> indices;
+
+        void quad(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d)
+        {
+            uint16_t first = static_cast<uint16_t>(vertices.size());
+            vertices.insert(vertices.end(), { a, b, c, d });
+            indices.insert(indices.end(), { first, static_cast<uint16_t>(first + 1), static_cast<uint16_t>(first + 2),
+                first, static_cast<uint16_t>(first + 2), static_cast<uint16_t>(first + 3) });
+        }
+    };
+
+    //a 200x200 ground floor split by a wall along x = 100 (open past z = 150), a platform over [20, 60] with a ramp down
+    //  towards +x, and a ledge over [160, 180] x [20, 40] with no way up
+    //the ground is one mesh placed by two entries, so the entry transforms are exercised too
+    void makeZone(std::vector<FFXI::CollisionMeshData>& meshes, std::vector<FFXI::CollisionEntry>& entries)
+    {
+        Geometry ground;
+        ground.quad({ 0, 0, 0 }, { 100, 0, 0 }, { 100, 0, 200 }, { 0, 0, 200 });
+
+        Geometry features;
+        features.quad({ wall_x, 0, 0 }, { wall_x, 0, wall_end_z }, { wall_x, -platform_height, wall_end_z }, { wall_x, -platform_height, 0 });
+        features.quad({ 20, -platform_height, 20 }, { 60, -platform_height, 20 }, { 60, -platform_height, 60 }, { 20, -platform_height, 60 });
+        features.quad({ 60, -platform_height, 20 }, { 80, 0, 20 }, { 80, 0, 40 }, { 60, -platform_height, 40 });
+        features.quad({ 160, -ledge_height, 20 }, { 180, -ledge_height, 20 }, { 180, -ledge_height, 40 }, { 160, -ledge_height, 40 });
+
+        for (const auto* geometry : { &ground, &features })
+        {
+            FFXI::CollisionMeshData mesh;
+            mesh.vertices.resize(geometry->vertices.size() * sizeof(glm::vec3));
+            std::memcpy(mesh.vertices.data(), geometry->vertices.data(), mesh.vertices.size());
+            mesh.indices = geometry->indices;
+            meshes.push_back(std::move(mesh));
+        }
+        //entries are stored transposed (see CollisionModelInitTask)
+        glm::mat4 east{ 1.f };
+        east[0][3] = 100.f;
+        entries.push_back({ glm::mat4{ 1.f }, 0 });
+        entries.push_back({ east, 0 });
+        entries.push_back({ glm::mat4{ 1.f }, 1 });
+    }
+
+    //spreads the chunks over a few threads the way WorkerPool::parallelFor does, without needing an engine
+    void threadedFor(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& func)
+    {
+        size_t chunks = (count + chunk_size - 1) / chunk_size;
+        std::atomic<size_t> next{ 0 };
+        auto run = [&]()
+        {
+            for (size_t chunk = next++; chunk < chunks; chunk = next++)
+            {
+                func(chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size));
+            }
+        };
+        std::vector<std::thread> threads;
+        size_t thread_count = std::max<size_t>(4, std::thread::hardware_concurrency());
+        for (size_t i = 1; i < std::min(chunks, thread_count); ++i)
+        {
+            threads.emplace_back(run);
+        }
+        run();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file{ path, std::ios::ate | std::ios::binary };
+        std::vector<uint8_t> bytes(file.good() ? static_cast<size_t>(file.tellg()) : 0);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+        return bytes;
+    }
+
+    float pathLength(const std::vector<glm::vec3>& path)
+    {
+        float length = 0.f;
+        for (size_t i = 1; i < path.size(); ++i)
+        {
+            length += glm::distance(path[i - 1], path[i]);
+        }
+        return length;
+    }
+
+    bool allAtHeight(const std::vector<glm::vec3>& path, float height)
+    {
+        return std::all_of(path.begin(), path.end(), [height](glm::vec3 point) { return glm::abs(-point.y - height) < 1e-3f; });
+    }
+
+    //waypoints are neighbouring cells, so a step through the wall would show up as one straddling x = wall_x short of its end
+    bool crossesWall(const std::vector<glm::vec3>& path)
+    {
+        for (size_t i = 1; i < path.size(); ++i)
+        {
+            bool straddles = (path[i - 1].x < wall_x) != (path[i].x < wall_x);
+            if (straddles && std::min(path[i - 1].z, path[i].z) < wall_end_z)
+                return true;
+        }
+        return false;
+    }
+
+    void checkPaths(const FFXI::Navigation& navigation, const char* name)
+    {
+        std::printf("%s:\n", name);
+
+        auto around = navigation.findPath({ 90, 0, 10 }, { 110, 0, 10 });
+        check::expect(!around.empty(), "a path around the wall is found");
+        check::expect(!crossesWall(around), "the path doesn't go through the wall");
+        check::expect(allAtHeight(around, 0.f), "the path around the wall stays on the ground");
+        //down to the gap past z = 150 and back, give or take the cell centers and diagonals
+        check::expect(pathLength(around) > 2.f * (wall_end_z - 10.f) && pathLength(around) < 2.f * (wall_end_z - 10.f) + 40.f, "the path around the wall is about as long as the way around");
+        std::printf("  around the wall: %zu waypoints, %.1f long\n", around.size(), pathLength(around));
+
+        auto upper = navigation.findPath({ 25, -platform_height, 25 }, { 55, -platform_height, 55 });
+        check::expect(!upper.empty() && allAtHeight(upper, platform_height), "a path across the platform stays on the platform");
+        auto under = navigation.findPath({ 25, 0, 25 }, { 55, 0, 55 });
+        check::expect(!under.empty() && allAtHeight(under, 0.f), "a path under the platform stays on the ground");
+        check::expect(!upper.empty() && !under.empty() && glm::distance(upper.front(), under.front()) > platform_height - 1e-3f, "the two floors are separate layers of the same columns");
+
+        auto up = navigation.findPath({ 150, 0, 180 }, { 40, -platform_height, 40 });
+        check::expect(!up.empty(), "a path from across the wall up onto the platform is found");
+        check::expect(!up.empty() && glm::abs(-up.back().y - platform_height) < 1e-3f, "it ends on the platform");
+        check::expect(!crossesWall(up), "it doesn't go through the wall");
+        bool ramp = std::any_of(up.begin(), up.end(), [](glm::vec3 point) { return point.x > 60.f && point.x < 80.f && -point.y > 1.f && -point.y < platform_height - 1.f; });
+        check::expect(ramp, "it takes the ramp");
+        std::printf("  up onto the platform: %zu waypoints, %.1f long\n", up.size(), pathLength(up));
+
+        check::expect(navigation.findPath({ 170, 0, 80 }, { 170, -ledge_height, 30 }).empty(), "nothing leads up onto the ledge");
+        check::expect(navigation.findPath({ 165, -ledge_height, 25 }, { 175, -ledge_height, 35 }).size() > 1, "but paths along the ledge are found");
+        check::expect(!navigation.findNearestWalkable({ 500, 0, 500 }), "nothing is walkable far off the grid");
+        check::expect(!navigation.findNearestWalkable({ 40, -5, 40 }), "nothing is walkable between the floors");
+    }
+}
+
+int main()
+{
+    std::vector<FFXI::CollisionMeshData> meshes;
+    std::vector<FFXI::CollisionEntry> entries;
+    makeZone(meshes, entries);
+    uint64_t source_hash = FFXI::Navigation::hashSource(meshes, entries);
+
+    std::unique_ptr<FFXI::Navigation> serial;
+    std::unique_ptr<FFXI::Navigation> threaded;
+    double serial_ms = check::time(5, [&] { serial = FFXI::Navigation::build(meshes, entries); });
+    double threaded_ms = check::time(5, [&] { threaded = FFXI::Navigation::build(meshes, entries, threadedFor); });
+    std::printf("build: %zu nodes, %zu clusters, %zu entrances; serial %.2f ms, threaded %.2f ms\n",
+        serial->getNodeCount(), serial->getClusterCount(), serial->getAbstractNodeCount(), serial_ms, threaded_ms);
+    check::expect(serial->getNodeCount() > 0 && serial->getAbstractNodeCount() > 0, "the zone has walkable nodes and entrances");
+    checkPaths(*serial, "serial build");
+
+    auto directory = std::filesystem::temp_directory_path();
+    auto serial_path = directory / "navigation_check_serial.nav";
+    auto threaded_path = directory / "navigation_check_threaded.nav";
+    check::expect(serial->save(serial_path.string(), source_hash) && threaded->save(threaded_path.string(), source_hash), "graphs can be saved");
+    check::expect(readFile(serial_path) == readFile(threaded_path), "the threaded build saves the same bytes as the serial one");
+
+    auto loaded = FFXI::Navigation::load(serial_path.string(), source_hash);
+    check::expect(loaded != nullptr, "a saved graph loads back");
+    if (loaded)
+    {
+        check::expect(loaded->getNodeCount() == serial->getNodeCount() && loaded->getAbstractNodeCount() == serial->getAbstractNodeCount(), "the loaded graph is the same size");
+        checkPaths(*loaded, "loaded");
+    }
+    check::expect(!FFXI::Navigation::load(serial_path.string(), source_hash + 1), "a graph saved for other collision data isn't loaded");
+    FFXI::Navigation::Parameters finer;
+    finer.cell_size = 0.5f;
+    check::expect(!FFXI::Navigation::load(serial_path.string(), source_hash, finer), "a graph saved with other parameters isn't loaded");
+    check::expect(!FFXI::Navigation::load((directory / "navigation_check_missing.nav").string(), source_hash), "a missing file isn't loaded");
+
+    //random queries over the ground (west to east, so most have to go around the wall); the loaded graph starts with an empty
+    //  segment cache, so the first pass pays for filling it
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> west{ 2.f, 98.f };
+    std::uniform_real_distribution<float> east{ 102.f, 198.f };
+    std::uniform_real_distribution<float> along{ 2.f, 198.f };
+    std::vector<std::pair<glm::vec3, glm::vec3>> queries(2000);
+    for (auto& [start, goal] : queries)
+    {
+        start = { west(rng), 0.f, along(rng) };
+        goal = { east(rng), 0.f, along(rng) };
+    }
+    if (loaded)
+    {
+        size_t found = 0;
+        double cold_ms = check::time(1, [&]
+        {
+            for (const auto& [start, goal] : queries)
+            {
+                found += loaded->findPath(start, goal).empty() ? 0 : 1;
+            }
+        });
+        double warm_ms = check::time(5, [&]
+        {
+            for (const auto& [start, goal] : queries)
+            {
+                loaded->findPath(start, goal);
+            }
+        });
+        check::expect(found == queries.size(), "every query between two points on the ground finds a path");
+        std::printf("queries: %zu of %zu found, %.1f us each with an empty segment cache, %.1f us once it's filled\n",
+            found, queries.size(), cold_ms * 1000.0 / queries.size(), warm_ms * 1000.0 / queries.size());
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(serial_path, ec);
+    std::filesystem::remove(threaded_path, ec);
+    return check::failures == 0 ? 0 : 1;
+}
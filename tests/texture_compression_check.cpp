@@ -0,0 +1,129 @@
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "engine/renderer/block_compression.h"
+#include "dat/dxt3.h"
+
+//transcoding 0xB1 palettized textures to BC1/BC3: round trips images through the CPU encoder and checks the PSNR stays usable,
+//  and that only textures with every alpha exactly opaque are allowed to lose their alpha channel
+//with a DAT path, its textures are measured as well
+
+using lotus::BlockCompression;
+
+namespace
+{
+    //over rgb, and alpha too when the format keeps it
+    double psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, bool alpha)
+    {
+        double error = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (i % 4 == 3 && !alpha)
+                continue;
+            double diff = static_cast<double>(a[i]) - b[i];
+            error += diff * diff;
+            ++count;
+        }
+        if (error == 0.0)
+            return 99.0;
+        return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+    }
+
+    struct Result
+    {
+        double fast;
+        double high;
+    };
+
+    Result roundTrip(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, vk::Format format)
+    {
+        bool alpha = format != vk::Format::eBc1RgbUnormBlock;
+        auto fast = BlockCompression::decode(format, BlockCompression::encode(format, rgba.data(), width, height, BlockCompression::Quality::Fast).data(), width, height);
+        auto high = BlockCompression::decode(format, BlockCompression::encode(format, rgba.data(), width, height, BlockCompression::Quality::High).data(), width, height);
+        return { psnr(rgba, fast, alpha), psnr(rgba, high, alpha) };
+    }
+
+    //smooth gradients with a little noise and some hard edged shapes, roughly what terrain and clothing textures look like
+    std::vector<uint8_t> makeImage(uint32_t width, uint32_t height, bool alpha)
+    {
+        std::mt19937 rng{ 1 };
+        std::normal_distribution<float> noise{ 0.f, 3.f };
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                bool shape = ((x / 24) + (y / 40)) % 5 == 0;
+                float r = shape ? 200.f : 60.f + 120.f * x / width;
+                float g = shape ? 40.f : 90.f + 80.f * y / height;
+                float b = 70.f + 60.f * std::sin(x * 0.05f + y * 0.03f);
+                float a = alpha ? 255.f * y / height : 255.f;
+                uint8_t* pixel = rgba.data() + (static_cast<size_t>(y) * width + x) * 4;
+                pixel[0] = static_cast<uint8_t>(std::clamp(r + noise(rng), 0.f, 255.f));
+                pixel[1] = static_cast<uint8_t>(std::clamp(g + noise(rng), 0.f, 255.f));
+                pixel[2] = static_cast<uint8_t>(std::clamp(b + noise(rng), 0.f, 255.f));
+                pixel[3] = static_cast<uint8_t>(a);
+            }
+        }
+        return rgba;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    {
+        auto image = makeImage(256, 256, false);
+        auto bc1 = roundTrip(image, 256, 256, vk::Format::eBc1RgbUnormBlock);
+        std::printf("synthetic opaque, BC1: fast %.2f dB, high %.2f dB\n", bc1.fast, bc1.high);
+        check::expect(bc1.high >= 35.0, "BC1 high quality PSNR >= 35 dB");
+        check::expect(bc1.high + 0.1 >= bc1.fast, "BC1 high quality is no worse than fast");
+
+        auto alpha_image = makeImage(256, 256, true);
+        auto bc3 = roundTrip(alpha_image, 256, 256, vk::Format::eBc3UnormBlock);
+        std::printf("synthetic alpha, BC3: fast %.2f dB, high %.2f dB\n", bc3.fast, bc3.high);
+        check::expect(bc3.high >= 35.0, "BC3 high quality PSNR >= 35 dB");
+        check::expect(bc3.high + 0.1 >= bc3.fast, "BC3 high quality is no worse than fast");
+    }
+
+    if (argc > 1)
+    {
+        check::DatFile dat{ argv[1] };
+        check::expect(dat.good(), "DAT can be read");
+        uint32_t textures = 0;
+        uint32_t opaque = 0;
+        double min_high = 99.0;
+        double total_fast = 0.0;
+        double total_high = 0.0;
+        for (const auto& chunk : dat.find(0x20))
+        {
+            FFXI::DXT3 dxt3{ chunk.name, chunk.data, chunk.len };
+            if (dxt3.format != vk::Format::eR8G8B8A8Unorm || dxt3.width < 4 || dxt3.height < 4)
+                continue;
+
+            bool all_opaque = true;
+            for (size_t i = 3; i < dxt3.pixels.size(); i += 4)
+            {
+                all_opaque = all_opaque && dxt3.pixels[i] == 255;
+            }
+            check::expect(dxt3.isOpaque() == all_opaque, "only textures with every alpha at 255 are treated as opaque");
+
+            auto format = dxt3.isOpaque() ? vk::Format::eBc1RgbUnormBlock : vk::Format::eBc3UnormBlock;
+            auto result = roundTrip(dxt3.pixels, dxt3.width, dxt3.height, format);
+            ++textures;
+            opaque += dxt3.isOpaque();
+            min_high = std::min(min_high, result.high);
+            total_fast += result.fast;
+            total_high += result.high;
+        }
+        if (textures > 0)
+        {
+            std::printf("%s: %u palettized textures (%u opaque), mean PSNR fast %.2f dB, high %.2f dB, worst high %.2f dB\n",
+                argv[1], textures, opaque, total_fast / textures, total_high / textures, min_high);
+            check::expect(total_high + 0.1 * textures >= total_fast, "high quality is no worse than fast on average");
+        }
+    }
+
+    return check::failures == 0 ? 0 : 1;
+}